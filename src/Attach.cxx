@@ -5,13 +5,18 @@
 #include <fstream>
 #include <memory>
 #include <string>
+#include <vector>
 #include <sstream>
 #include <algorithm>
 #include <TFile.h>
+#include <TROOT.h>
 #include <TError.h>
 #include <TString.h>
 #include <TSystem.h>
 #include <TDatime.h>
+#include <TThread.h>
+#include <TVirtualMutex.h>
+#include <RVersion.h>
 #include "utils/Assorted.hxx"
 #include "Rint.hxx"
 #include "Buffer.hxx"
@@ -58,18 +63,102 @@ inline Int_t find_timer(TClass* timerclass, TTimer*& output) {
 	return retval;
 }
 
-void start_save(const std::string& save_fname) {
+void enable_implicit_mt() {
+#ifdef R__USE_IMT
+	if(!ROOT::IsImplicitMTEnabled()) ROOT::EnableImplicitMT();
+#else
+	static bool warned = false;
+	if(!warned)
+		rb::err::Warning("start_save")
+			<< "Implicit multi-threading requested in save policy, but ROOT was built without IMT support.";
+	warned = true;
+#endif
+}
+
+//
+// Thread body for closing a save file in the background: writes any
+// trees still in memory (flushing their baskets), then closes the file.
+void* close_file(void* arg) {
+	TFile* file = static_cast<TFile*>(arg);
+	file->Write(0, TObject::kOverwrite);
+	file->Close();
+	delete file;
+	return 0;
+}
+
+//
+// Threads launched by BackgroundClose (none with ROOT 5)
+std::vector<TThread*>& file_closers() {
+	static std::vector<TThread*>* v = new std::vector<TThread*>();
+	return *v;
+}
+
+//
+// shared_ptr deleter that hands closing of a TFile off to a TThread. ROOT 5 has no
+// thread-safe mode (gFile, gDirectory and the list of files are shared by all threads),
+// so there the file is closed right away, on the calling thread.
+struct BackgroundClose {
+	void operator() (TFile* file) const {
+		if(!file) return;
+#if ROOT_VERSION_CODE < ROOT_VERSION(6,0,0)
+		close_file(file);
+#else // thread safety was enabled by the rb::Rint constructor
+		std::vector<TThread*>& closers = file_closers();
+		for(size_t i=0; i< closers.size(); ) { // clean up finished threads
+			if(closers[i]->GetState() == TThread::kCanceledState ||
+				 closers[i]->GetState() == TThread::kFinishedState) {
+				closers[i]->Join();
+				delete closers[i];
+				closers.erase(closers.begin() + i);
+			}
+			else ++i;
+		}
+		TThread* t = new TThread("rb_close_file", close_file, file);
+		closers.push_back(t);
+		t->Run();
+#endif
+	}
+};
+
+boost::shared_ptr<TFile> start_save(const std::string& save_fname, bool background_close = false) {
 	TDirectory* current = gDirectory;
 	if(!current) current = gROOT;
-	boost::shared_ptr<TFile> file (new TFile(save_fname.c_str(), "recreate"));
-	current->cd();
 	rb::EventVector_t events = rb::Rint::gApp()->GetEventVector();
+	//
+	// File-level compression (applies to histograms and keys) follows the
+	// first event with an explicit setting; trees get their own in Save::Start()
+	Int_t compress = -1;
+	for(rb::EventVector_t::iterator it = events.begin(); it != events.end(); ++it) {
+		rb::SavePolicy policy = rb::Rint::gApp()->GetEvent(it->first)->GetSavePolicy();
+		if(compress < 0) compress = policy.GetCompressionSettings();
+		if(policy.fImplicitMT) enable_implicit_mt();
+	}
+	boost::shared_ptr<TFile> file;
+	if(background_close) file.reset(new TFile(save_fname.c_str(), "recreate"), BackgroundClose());
+	else file.reset(new TFile(save_fname.c_str(), "recreate"));
+	if(compress >= 0) file->SetCompressionSettings(compress);
+	current->cd();
 	for(rb::EventVector_t::iterator it = events.begin(); it != events.end(); ++it) {
 		std::stringstream tname; tname << "t" << it->first;
 		std::stringstream ttitle; ttitle << it->second << " data";
 		rb::Rint::gApp()->GetEvent(it->first)->
 			 StartSave(file, tname.str().c_str(), ttitle.str().c_str(), rb::Rint::gApp()->GetSaveHists());
 	}
+	return file;
+}
+
+void stop_save(bool deferred = false) {
+	rb::EventVector_t events = rb::Rint::gApp()->GetEventVector();
+	for(rb::EventVector_t::iterator it = events.begin(); it != events.end(); ++it) {
+		rb::Rint::gApp()->GetEvent(it->first)->StopSave(deferred);
+	}
+}
+
+void flush_hist_batches() {
+	rb::EventVector_t events = rb::Rint::gApp()->GetEventVector();
+	for(rb::EventVector_t::iterator it = events.begin(); it != events.end(); ++it) {
+		rb::Rint::gApp()->GetEvent(it->first)->GetHistManager()->FlushBatch();
+	}
 }
 
 inline void call_begin_run() {
@@ -98,6 +187,15 @@ Bool_t rb::ListAttached() {
 	return check_attached<rb::ListAttach>();
 }
 
+void rb::WaitSaveClose() {
+	std::vector<TThread*>& closers = file_closers();
+	for(size_t i=0; i< closers.size(); ++i) {
+		closers[i]->Join();
+		delete closers[i];
+	}
+	closers.clear();
+}
+
 
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 //\\\\\\\\\\\\ Class rb::FileAttached \\\\\\\\\\\\//
@@ -141,10 +239,8 @@ rb::FileAttach::~FileAttach() {
 		if(Rint::gApp()->GetSignals())
 			 Rint::gApp()->GetSignals()->Unattaching(); // signal to gui
 	}
-	EventVector_t events = Rint::gApp()->GetEventVector();
-	for(EventVector_t::iterator it = events.begin(); it != events.end(); ++it) {
-		Rint::gApp()->GetEvent(it->first)->StopSave();
-	}
+	flush_hist_batches();
+	stop_save();
 }
 
 void rb::FileAttach::Stop() {
@@ -177,11 +273,15 @@ void rb::FileAttach::TimerAction() {
 		}
     else if (kStopAtEnd)
 			break; // we're done
-		else
+		else {
+			flush_hist_batches();
 			return; // yield
+		}
 
-		if(timeout.Check()) // yield
+		if(timeout.Check()) { // yield
+			flush_hist_batches();
 			return;
+		}
   }
 	if (1) {
 		printCounter(fNbuffers, true);
@@ -253,14 +353,22 @@ void rb::ListAttach::TimerAction() {
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 //\\\\\\\\\\\\ Class rb::OnlineAttached \\\\\\\\\\\\//
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
-namespace { TString get_ts_string() {
+namespace {
+TString get_ts_string() {
 	TDatime ts;
 	TString time = ts.AsSQLString();
 	time.ReplaceAll("-","_");
 	time.ReplaceAll(" ","_");
 	time.ReplaceAll(":","");
 	return time;
-}}
+}
+
+rb::OnlineAttach* online_instance = 0;
+}
+
+Long64_t rb::OnlineAttach::fgRolloverSize = 0;
+Double_t rb::OnlineAttach::fgRolloverTime = 0;
+Bool_t   rb::OnlineAttach::fgRolloverRun  = false;
 
 rb::OnlineAttach::OnlineAttach(const char* source, const char* other, char** others, int nothers):
 	fTimeout(ATTACH_TIMEOUT),
@@ -270,7 +378,11 @@ rb::OnlineAttach::OnlineAttach(const char* source, const char* other, char** oth
   fOtherArgs(0),
   fNumOthers(nothers),
 	fBuffer(0),
-	fNbuffers(0)
+	fNbuffers(0),
+	fSaveFile(),
+	fSaveStart(),
+	fRolloverRun(-1),
+	fRolloverRequested(false)
 {
 
 	fSourceArg = new char [strlen(source)+1];
@@ -290,16 +402,17 @@ rb::OnlineAttach::OnlineAttach(const char* source, const char* other, char** oth
 	if(Rint::gApp()->GetSignals())
 		 Rint::gApp()->GetSignals()->Attaching();
 
-	if(Rint::gApp()->GetSaveData()) {
-		std::string save_fname = expand_path_std(kSaveStaticDefault, "$RB_SAVEDIR");
-		save_fname += "Online_";
-		save_fname += get_ts_string().Data();
-		save_fname += ".root";
-		start_save(save_fname);
-	}
+	if(Rint::gApp()->GetSaveData()) StartSave();
+	online_instance = this;
 }
 
 rb::OnlineAttach::~OnlineAttach() {
+	online_instance = 0;
+	flush_hist_batches();
+	if(fSaveFile.get()) {
+		stop_save(true);
+		fSaveFile.reset(); // closes in the background
+	}
 	if(Rint::gApp()->GetSignals()) {
 		Rint::gApp()->GetSignals()->UpdateBufferCounter(fNbuffers, true);
 		Rint::gApp()->GetSignals()->Unattaching();
@@ -316,6 +429,66 @@ rb::OnlineAttach::~OnlineAttach() {
   fBuffer->DisconnectOnline();
 }
 
+rb::OnlineAttach* rb::OnlineAttach::Instance() {
+	return online_instance;
+}
+
+void rb::OnlineAttach::StartSave() {
+	std::string save_fname = expand_path_std(kSaveStaticDefault, "$RB_SAVEDIR");
+	save_fname += "Online_";
+	Int_t run;
+	{
+		R__LOCKGUARD2(gCINTMutex); // set by RunTransition()
+		run = fRolloverRun;
+	}
+	if(run >= 0) save_fname += Form("run%d_", run);
+	save_fname += get_ts_string().Data();
+	std::string fname = save_fname + ".root";
+	for(Int_t i=1; !gSystem->AccessPathName(fname.c_str()); ++i) // don't clobber a file from the same second
+		fname = save_fname + Form("_%d", i) + ".root";
+	fSaveFile = start_save(fname, true);
+	fSaveStart = rb::Time();
+}
+
+void rb::OnlineAttach::CheckRollover() {
+	/*!
+	 * The old file keeps its trees in memory (branch addresses reset); writing the
+	 * remaining baskets and closing it happens in a separate thread once the last
+	 * reference to it goes away, so processing continues straight into the new file.
+	 * With ROOT 5 the old file is closed here instead (see BackgroundClose).
+	 */
+	if(!fSaveFile.get()) return;
+	Bool_t roll;
+	{
+		R__LOCKGUARD2(gCINTMutex); // set by RunTransition()
+		roll = fRolloverRequested;
+		fRolloverRequested = false;
+	}
+	if(!roll && fgRolloverSize > 0 && fSaveFile->GetEND() > fgRolloverSize) roll = true;
+	if(!roll && fgRolloverTime > 0 && (rb::Time() - fSaveStart) > fgRolloverTime) roll = true;
+	if(!roll) return;
+
+	err::Info("rb::OnlineAttach") << "Closing save file \"" << fSaveFile->GetName() << "\" and starting a new one.";
+	stop_save(true);
+	fSaveFile.reset();
+	StartSave();
+}
+
+void rb::OnlineAttach::SetRollover(Double_t max_mb, Double_t max_minutes, Bool_t on_run) {
+	fgRolloverSize = max_mb > 0 ? static_cast<Long64_t>(max_mb*1024*1024) : 0;
+	fgRolloverTime = max_minutes > 0 ? 60*max_minutes : 0;
+	fgRolloverRun  = on_run;
+}
+
+void rb::OnlineAttach::RunTransition(Int_t runnum, Bool_t start) {
+	if(!fgRolloverRun) return;
+	OnlineAttach* online = Instance();
+	if(!online) return;
+	R__LOCKGUARD2(gCINTMutex); // read and cleared by CheckRollover() on the attach thread
+	online->fRolloverRun = start ? runnum : -1;
+	online->fRolloverRequested = true;
+}
+
 void rb::OnlineAttach::Stop() {
 	TTimer* t;
 	while(find_timer(rb::AttachTimer<rb::OnlineAttach>::Class(), t)) {
@@ -360,6 +533,8 @@ void rb::OnlineAttach::TimerAction() {
 		}
 
 		if(timeout.Check()) {
+			flush_hist_batches();
+			CheckRollover();
 			RB_TIMER_RETURN; // yield
 		}
   }
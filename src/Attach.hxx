@@ -3,10 +3,13 @@
 #ifndef RB_ATTACH_HEADER
 #define RB_ATTACH_HEADER
 #include "utils/boost_scoped_ptr.h"
+#include "utils/boost_shared_ptr.h"
 #include "utils/Timer.hxx"
 #include "Buffer.hxx"
 
 
+class TFile;
+
 namespace rb
 {
 
@@ -159,10 +162,36 @@ private:
 	boost::scoped_ptr<BufferSource> fBuffer;
 	//! Buffer counter
 	Long_t fNbuffers;
+	//! File currently being saved to (empty if not saving)
+	boost::shared_ptr<TFile> fSaveFile;
+	//! Time at which fSaveFile was opened
+	rb::Time fSaveStart;
+	//! Run number to tag the next save file with (-1 for none); guarded by gCINTMutex
+	Int_t fRolloverRun;
+	//! Flag requesting a rollover at the next opportunity; guarded by gCINTMutex
+	Bool_t fRolloverRequested;
+	//! Maximum save file size in bytes before rollover (0 = no limit)
+	static Long64_t fgRolloverSize;
+	//! Maximum save file age in seconds before rollover (0 = no limit)
+	static Double_t fgRolloverTime;
+	//! Roll over the save file at each run start/stop transition
+	static Bool_t fgRolloverRun;
 
 public:
 	//! Take care of EOR cleanup
 	virtual ~OnlineAttach();
+	//! \brief Set the conditions for starting a new online save file.
+	//! \param max_mb Roll over once the file exceeds this size in megabytes (0 = no limit).
+	//! \param max_minutes Roll over once the file is this old (0 = no limit).
+	//! \param on_run Roll over at every run start and stop transition.
+	static void SetRollover(Double_t max_mb, Double_t max_minutes, Bool_t on_run);
+	//! \brief Notify the running instance (if any) of a run transition.
+	//! \details Called from run start/stop handlers of BufferSource implementations. If
+	//! rollover on run transitions is enabled, the save file is switched at the next
+	//! opportunity (never inside the transition handler itself).
+	//! \param runnum Run number (tags the new file name on run start)
+	//! \param start True for a run start, false for a run stop.
+	static void RunTransition(Int_t runnum, Bool_t start);
 	//! \brief Make connection to online source and look for data
 	void TimerAction();
 	//! \brief Conststructs a \c new instance of rb::OnlineAttach and calls StartLoop()
@@ -175,6 +204,12 @@ private:
 	OnlineAttach(const char* source, const char* other, char** others, int nothers);
 	//! Start running the loop
 	void StartLoop();
+	//! Open a new save file for all events
+	void StartSave();
+	//! Check rollover conditions, switch save files if any are met
+	void CheckRollover();
+	//! Return the running instance, or NULL if not attached
+	static OnlineAttach* Instance();
 };
 
 inline void rb::OnlineAttach::StartLoop() {
@@ -191,6 +226,9 @@ Bool_t FileAttached();
 Bool_t ListAttached();
 Bool_t OnlineAttached();
 
+//! Wait for any save files still being closed in the background
+void WaitSaveClose();
+
 } // namespace rb
 
 
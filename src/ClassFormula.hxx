@@ -10,7 +10,7 @@
 namespace rb
 {
 
-namespace data { class MReader; }
+namespace data { class MReader; class ReaderGather; }
 
 
 /// Helper class to parse string expressions specifying data members.
@@ -59,13 +59,15 @@ protected:
 	void* fAddress;
 	/// Vector of rb::data::MReader pointers, to extract data needed to evaluate the formula.
 	std::vector<rb::data::MReader*> fReaders;
+	/// Reads all of fReaders in one pass (owned)
+	rb::data::ReaderGather* fGather; //!
 
 public:
 	/// Constructor
 	ClassFormula(const char* name, const char* formula, const char* branchName, const char* className, void* classAddr);
 	/// Copy constructor
 	ClassFormula(const ClassFormula& lhs);
-	/// Free memory allocated to fReaders
+	/// Free memory allocated to fReaders and fGather
 	virtual ~ClassFormula();
 	/// Evaluates the formula using the current value of class members.
 	virtual Double_t Eval() const;
@@ -6,11 +6,13 @@
 #include <deque>
 #include <vector>
 #include <cassert>
+#include <cstring>
 #include <sstream>
 #include <algorithm>
 #include <TRealData.h>
 #include "Rint.hxx"
 #include "Data.hxx"
+#include "Reflect.hxx"
 #include "mxml/mxml.hxx"
 #include "utils/Error.hxx"
 #include "utils/Assorted.hxx"
@@ -26,7 +28,7 @@
 			<< " dimensions and will not be mapped." << ERR_FILE_LINE;				\
 	} while(0)
 
-#define ADD_STL(CONTAINER, TYPE) do {																		\
+#define ADD_STL(CONTAINER, TYPE, READER) do {															\
 		std::stringstream typeStr;																					\
 		typeStr << #CONTAINER << "<"	<< #TYPE << ">";											\
 		TClass* cl = TClass::GetClass(typeStr.str().c_str());								\
@@ -35,15 +37,16 @@
 		fAddMap.insert(std::make_pair(cl, AddSTL<std::CONTAINER<TYPE>, TYPE>)); \
 		fAddrMap.insert(std::make_pair(cl, AddrSTL<std::CONTAINER<TYPE> >)); \
 		fLengthMap.insert(std::make_pair(cl, STLLength<std::CONTAINER<TYPE> >)); \
+		fReaderMap.insert(std::make_pair(cl, NewReader<rb::data::READER<std::CONTAINER<TYPE> > >)); \
 		fBasicTypeMap.insert(std::make_pair(cl, #TYPE));										\
 	} while(0)
 
 #define ADD_CONTAINERS(TYPE) do {								\
-		ADD_STL(set, TYPE);													\
-		ADD_STL(list, TYPE);												\
-		ADD_STL(deque, TYPE);												\
-		ADD_STL(vector, TYPE);											\
-		ADD_STL(multiset, TYPE);										\
+		ADD_STL(set, TYPE, NodeReader);							\
+		ADD_STL(list, TYPE, NodeReader);						\
+		ADD_STL(deque, TYPE, IndexedReader);				\
+		ADD_STL(vector, TYPE, IndexedReader);				\
+		ADD_STL(multiset, TYPE, NodeReader);				\
 	} while(0)
 
 namespace {
@@ -51,9 +54,11 @@ namespace {
 typedef void   (*STLAdd_t)(const char*, volatile void*, TDataMember*);
 typedef Long_t (*STLAddr_t)(volatile void*, size_t);
 typedef size_t (*STLLength_t)(volatile void*);
+typedef rb::data::MReader* (*STLReader_t)(Long_t, size_t);
 typedef std::map<TClass*, STLAdd_t> STLAddMap_t;
 typedef std::map<TClass*, STLAddr_t> STLAddrMap_t;
 typedef std::map<TClass*, STLLength_t> STLLengthMap_t;
+typedef std::map<TClass*, STLReader_t> STLReaderMap_t;
 typedef std::map<TClass*, std::string> STLBasicTypeMap_t;
 
 /// Add all elements of an STL container to MBasic::fgData()
@@ -65,6 +70,7 @@ void AddSTL(const char* name, volatile void* addr, TDataMember* d) {
 		Long_t addrThis = reinterpret_cast<Long_t>(&(*it));
 		std::stringstream fullName;
 		fullName << name << "[" << i++ << "]";
+		if(rb::data::MBasic::IsMapped(fullName.str().c_str())) continue;
 		rb::data::MBasic* m =
 			new rb::data::Basic<B>(fullName.str().c_str(), (volatile void*)addrThis, d);
 		if(!m) rb::err::Error("AddSTL") << "Constructor returned a NULL pointer" << ERR_FILE_LINE;
@@ -90,6 +96,12 @@ Long_t AddrSTL(volatile void* addr, size_t i) {
   return it == p->end() ? 0 :  reinterpret_cast<Long_t>(&(*it));
 }
 
+/// Create a reader of element i of the STL container at address addr
+template <class R>
+rb::data::MReader* NewReader(Long_t addr, size_t i) {
+	return new R(addr, i);
+}
+
 
 class STLMaps
 {
@@ -97,11 +109,13 @@ private:
 	STLAddMap_t fAddMap;
 	STLAddrMap_t fAddrMap;
 	STLLengthMap_t fLengthMap;
+	STLReaderMap_t fReaderMap;
 	STLBasicTypeMap_t fBasicTypeMap;
 public:
 	STLAddMap_t* GetAddMap() { return &fAddMap; }
 	STLAddrMap_t* GetAddrMap() { return &fAddrMap; }
 	STLLengthMap_t* GetLengthMap() { return &fLengthMap; }
+	STLReaderMap_t* GetReaderMap() { return &fReaderMap; }
 	STLBasicTypeMap_t* GetBasicTypeMap() { return &fBasicTypeMap; }
 	STLMaps() {
 		ADD_CONTAINERS(double);
@@ -145,6 +159,8 @@ int get_final_index(std::string* name) {
 // rb::data::MReader Implementation      //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 
+Double_t rb::data::ContainerReader::fgDefault = 0.;
+
 #define GET_READER(addr, type)	do {																		\
 		if (!strcmp(typeName, #type)) {																			\
 			retval = new rb::data::Reader<type> (addr);												\
@@ -174,6 +190,38 @@ rb::data::MReader* rb::data::MReader::New(const char* typeName, Long_t dataAddre
 	return retval;
 }
 #undef GET_READER
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// MReader* rb::data::MReader::New() [static]//
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::data::MReader* rb::data::MReader::New(Type_t type, Long_t dataAddress) {
+	if(!dataAddress) return 0;
+	switch(type) {
+	case kDouble:  return new rb::data::Reader<double> (dataAddress);
+	case kFloat:   return new rb::data::Reader<float> (dataAddress);
+	case kLong64:  return new rb::data::Reader<long long> (dataAddress);
+	case kLong:    return new rb::data::Reader<long> (dataAddress);
+	case kInt:     return new rb::data::Reader<int> (dataAddress);
+	case kShort:   return new rb::data::Reader<short> (dataAddress);
+	case kChar:    return new rb::data::Reader<char> (dataAddress);
+	case kBool:    return new rb::data::Reader<bool> (dataAddress);
+	case kULong64: return new rb::data::Reader<unsigned long long> (dataAddress);
+	case kULong:   return new rb::data::Reader<unsigned long> (dataAddress);
+	case kUInt:    return new rb::data::Reader<unsigned int> (dataAddress);
+	case kUShort:  return new rb::data::Reader<unsigned short> (dataAddress);
+	case kUChar:   return new rb::data::Reader<unsigned char> (dataAddress);
+	default:       return 0;
+	}
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// const char* rb::data::MReader::GetTypeName() [static] //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+const char* rb::data::MReader::GetTypeName(Int_t type) {
+	static const char* const names[kNtypes] = {
+		"double", "float", "long long", "long", "int", "short", "char", "bool",
+		"unsigned long long", "unsigned long", "unsigned int", "unsigned short", "unsigned char"
+	};
+	return type >= 0 && type < kNtypes ? names[type] : "";
+}
 
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // Class                                 //
@@ -202,6 +250,7 @@ rb::data::MReader* rb::data::MReader::New(const char* typeName, Long_t dataAddre
 void rb::data::MBasic::New(const char* name, volatile void* addr, TDataMember* d) {
 
 	if(d->IsBasic()) {
+		if(IsMapped(name)) return;
 		CHECK_TYPE(double);
 		CHECK_TYPE(float);
 		CHECK_TYPE(long long);
@@ -237,22 +286,101 @@ void rb::data::MBasic::New(const char* name, volatile void* addr, TDataMember* d
 	}
 #undef CHECK_TYPE
 }
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::data::MBasic::New() [static]     //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::data::MBasic::New(const char* name, volatile void* addr, Int_t type, Bool_t isConst) {
+#define NEW_BASIC(TYPE, TAG)																						\
+	case rb::data::MReader::TAG:																					\
+		if(isConst) m = new rb::data::ConstBasic<TYPE> (name, addr);				\
+		else        m = new rb::data::Basic<TYPE> (name, addr);							\
+		break
+	if(IsMapped(name)) return;
+	rb::data::MBasic* m = 0;
+	switch(type) {
+		NEW_BASIC(double, kDouble);
+		NEW_BASIC(float, kFloat);
+		NEW_BASIC(long long, kLong64);
+		NEW_BASIC(long, kLong);
+		NEW_BASIC(int, kInt);
+		NEW_BASIC(short, kShort);
+		NEW_BASIC(char, kChar);
+		NEW_BASIC(bool, kBool);
+		NEW_BASIC(unsigned long long, kULong64);
+		NEW_BASIC(unsigned long, kULong);
+		NEW_BASIC(unsigned int, kUInt);
+		NEW_BASIC(unsigned short, kUShort);
+		NEW_BASIC(unsigned char, kUChar);
+	default:
+		rb::err::Error("MBasic::New") << "No support for basic type tag " << type << ERR_FILE_LINE;
+		return;
+	}
+	if(!m) rb::err::Error("data::MBasic::New") << "Constructor returned a NULL pointer";
+#undef NEW_BASIC
+}
+namespace { // On demand mapping
+struct OnDemand {
+	std::string fBranch; // branch name
+	std::string fClass;  // class name
+	Long_t fBase;        // address of the class instance
+	Bool_t fComplete;    // has the whole class been mapped?
+};
+std::vector<OnDemand>& on_demand() {
+	static std::vector<OnDemand>* v = new std::vector<OnDemand>();
+	return *v;
+}
+// Map the leaves along 'name' in the class whose branch it starts with;
+// returns false if no class matches or it was already mapped completely
+bool map_path(const char* name) {
+	std::vector<OnDemand>& roots = on_demand();
+	for(std::vector<OnDemand>::iterator it = roots.begin(); it != roots.end(); ++it) {
+		const size_t n = it->fBranch.size();
+		if(strncmp(name, it->fBranch.c_str(), n) || name[n] != '.') continue;
+		if(it->fComplete) return false;
+		rb::data::Mapper mapper(it->fBranch.c_str(), it->fClass.c_str(), it->fBase, false);
+		mapper.MapClass(name);
+		return true;
+	}
+	return false;
+} }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // rb::data::MBasic::GetAll() [static]         //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 std::vector<std::string> rb::data::MBasic::GetAll() {
+	MapAll();
 	std::vector<std::string> out;
-	for(Map_t::iterator it = fgAll().begin(); it != fgAll().end(); ++it) {
-		out.push_back(it->first);
+	for(Int_t i=0; i< fgAll().GetN(); ++i) {
+		out.push_back(fgAll().GetName(i));
 	}
+	std::sort(out.begin(), out.end());
 	return out;
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // MBasic* rb::data::MBasic::Find() [static]   //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 rb::data::MBasic* rb::data::MBasic::Find(const char* name) {
-  rb::data::MBasic::Map_t::iterator it = fgAll().find(std::string(name));
-  return it != fgAll().end() ? it->second : 0;
+	return fgAll().Get(FindHandle(name));
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Int_t rb::data::MBasic::FindHandle() [static] //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Int_t rb::data::MBasic::FindHandle(const char* name) {
+	Int_t handle = fgAll().Find(name);
+	if(handle < 0 && name && map_path(name))
+		handle = fgAll().Find(name);
+	return handle;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::data::MBasic::MapAll() [static] //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::data::MBasic::MapAll() {
+	std::vector<OnDemand>& roots = on_demand();
+	for(std::vector<OnDemand>::iterator it = roots.begin(); it != roots.end(); ++it) {
+		if(it->fComplete) continue;
+		Mapper mapper(it->fBranch.c_str(), it->fClass.c_str(), it->fBase, false);
+		mapper.MapClass();
+		it->fComplete = true;
+	}
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // Sub Class                             //
@@ -263,21 +391,21 @@ rb::data::MBasic* rb::data::MBasic::Find(const char* name) {
 // void rb::data::MBasic::Printer::SaveXML(XmlWriter*) //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 void rb::data::MBasic::Printer::SaveXML(rb::XmlWriter* writer) {
-  if(fgAll().empty()) return;
+	MapAll();
+  if(!fgAll().GetN()) return;
 	ANSort ansort;
-  rb::data::MBasic::Map_t::iterator it;
 	std::vector<std::string> names;
-  for(it = fgAll().begin(); it != fgAll().end(); ++it) {
-		names.push_back(it->first);
+  for(Int_t i=0; i< fgAll().GetN(); ++i) {
+		names.push_back(fgAll().GetName(i));
 	}
 	std::sort(names.begin(), names.end(), ansort);
 	for(UInt_t i=0; i< names.size(); ++i) {
-		it = fgAll().find(names[i]);
+		MBasic* basic = Find(names[i].c_str());
 		std::stringstream val;
-		val << it->second->GetValue();
+		val << basic->GetValue();
 		mxml_start_element(writer, "var");
-		mxml_write_attribute(writer, "name", it->first.c_str());
-		mxml_write_attribute(writer, "type", it->second->fDataMember->GetTrueTypeName());
+		mxml_write_attribute(writer, "name", names[i].c_str());
+		mxml_write_attribute(writer, "type", basic->fTypeName);
 		mxml_write_value(writer, val.str().c_str());
 		mxml_end_element(writer);
   }
@@ -287,17 +415,16 @@ void rb::data::MBasic::Printer::SaveXML(rb::XmlWriter* writer) {
 // void rb::data::MBasic::Printer::SavePrimitive()   //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 void rb::data::MBasic::Printer::SavePrimitive(std::ostream& strm) {
-  if(fgAll().empty()) return;
+	MapAll();
+  if(!fgAll().GetN()) return;
 	ANSort ansort;
-  rb::data::MBasic::Map_t::iterator it;
 	std::vector<std::string> names;
-  for(it = fgAll().begin(); it != fgAll().end(); ++it) {
-		names.push_back(it->first);
+  for(Int_t i=0; i< fgAll().GetN(); ++i) {
+		names.push_back(fgAll().GetName(i));
 	}
 	std::sort(names.begin(), names.end(), ansort);
 	for(UInt_t i=0; i< names.size(); ++i) {
-		it = fgAll().find(names[i]);
-    strm << "  rb::Rb::Data::SetValue(\"" << it->first << "\", " << it->second->GetValue() << ");\n";
+    strm << "  rb::Rb::Data::SetValue(\"" << names[i] << "\", " << Find(names[i].c_str())->GetValue() << ");\n";
   }
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
@@ -313,20 +440,20 @@ inline std::string double2str(Double_t d) {
 	return sstr.str();
 } }
 void rb::data::MBasic::Printer::PrintAll() {
-  if(fgAll().empty()) return;
+	MapAll();
+  if(!fgAll().GetN()) return;
   std::vector<std::string> names, values, classes;
 
-  rb::data::MBasic::Map_t::iterator it = fgAll().begin();
-  while(it != fgAll().end()) {
-    names.push_back(it->first); ++it;
+  for(Int_t i=0; i< fgAll().GetN(); ++i) {
+    names.push_back(fgAll().GetName(i));
 	}
 	ANSort ansort;
 	std::sort(names.begin(), names.end(), ansort);
 
 	for(UInt_t i=0; i< names.size(); ++i) {
-		it = fgAll().find(names[i]);
-    values.push_back(double2str(it->second->GetValue()));
-    classes.push_back(it->second->fDataMember->GetTrueTypeName());
+		MBasic* basic = Find(names[i].c_str());
+    values.push_back(double2str(basic->GetValue()));
+    classes.push_back(basic->fTypeName);
   }
   Int_t maxName  = max_element(names.begin(), names.end(), string_len_compare)->size();
   maxName = maxName > 4 ? maxName : 4;
@@ -345,10 +472,70 @@ void rb::data::MBasic::Printer::PrintAll() {
 // const char* rb::data::MBasic::GetLeafName() //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 const char* rb::data::MBasic::GetLeafName() {
-	for (Map_t::iterator it = fgAll().begin(); it != fgAll().end(); ++it) {
-		if(it->second == this) return it->first.c_str();
+	return fgAll().GetName(fHandle).c_str();
+}
+
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Class                                 //
+// rb::data::NameRegistry Implementation //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// UInt_t rb::data::NameRegistry::Hash() [static]    //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+UInt_t rb::data::NameRegistry::Hash(const char* name, size_t length) {
+	UInt_t hash = 2166136261u;
+	for(size_t i=0; i< length; ++i) {
+		hash ^= static_cast<unsigned char>(name[i]);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Int_t rb::data::NameRegistry::Find()              //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Int_t rb::data::NameRegistry::Find(const char* name) const {
+	if(!name) return -1;
+	const size_t length = strlen(name);
+	const UInt_t hash = Hash(name, length);
+	const UInt_t mask = fTable.size() - 1;
+	for(UInt_t slot = hash & mask; fTable[slot] >= 0; slot = (slot + 1) & mask) {
+		const Int_t handle = fTable[slot];
+		if(fHashes[handle] == hash && fNames[handle].size() == length && fNames[handle] == name)
+			return handle;
+	}
+	return -1;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Int_t rb::data::NameRegistry::Insert()            //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Int_t rb::data::NameRegistry::Insert(const char* name, MBasic* entry) {
+	Int_t handle = Find(name);
+	if(handle >= 0) return handle;
+	if(2*(fNames.size() + 1) > fTable.size()) Grow();
+
+	handle = fNames.size();
+	fNames.push_back(name);
+	fHashes.push_back(Hash(name, fNames.back().size()));
+	fEntries.push_back(entry);
+	const UInt_t mask = fTable.size() - 1;
+	UInt_t slot = fHashes.back() & mask;
+	while(fTable[slot] >= 0) slot = (slot + 1) & mask;
+	fTable[slot] = handle;
+	return handle;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::data::NameRegistry::Grow()               //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::data::NameRegistry::Grow() {
+	fTable.assign(2*fTable.size(), -1);
+	const UInt_t mask = fTable.size() - 1;
+	for(Int_t handle = 0; handle < GetN(); ++handle) {
+		UInt_t slot = fHashes[handle] & mask;
+		while(fTable[slot] >= 0) slot = (slot + 1) & mask;
+		fTable[slot] = handle;
 	}
-	return "NOT FOUND";
 }
 
 
@@ -375,11 +562,19 @@ private:
 	 std::vector<std::string> fIndices;
 	 Int_t fArrayLength;
 }; // class ArrayConverter
+// Is 'name' on 'path', i.e. is one of them the other or a parent of it? (always true if path is 0)
+inline bool on_path(const std::string& name, const char* path) {
+	if(!path) return true;
+	const size_t n = std::min(name.size(), strlen(path));
+	if(name.compare(0, n, path, n)) return false;
+	const char next = name.size() > n ? name[n] : path[n];
+	return next == 0 || next == '.' || next == '[';
+}
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // void rb::data::Mapper::HandleBasic()   //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
-void rb::data::Mapper::HandleBasic(TDataMember* d, const char* name) {
+void rb::data::Mapper::HandleBasic(TDataMember* d, const char* name, const char* path) {
 	if(d->IsPersistent() == false) return;
   Long_t addr = kBase + d->GetOffset();
   Int_t nDim = d->GetArrayDim();
@@ -394,15 +589,16 @@ void rb::data::Mapper::HandleBasic(TDataMember* d, const char* name) {
     Int_t arrayLen = ac.GetArrayLength();
     Int_t size = d->GetUnitSize();
     for(Int_t i=0; i< arrayLen; ++i) {
-      addr += size*(i>0);
-      rb::data::MBasic::New(ac.GetFullName(name, i).c_str(), reinterpret_cast<void*>(addr), d);
+			std::string name_i = ac.GetFullName(name, i);
+			if(!on_path(name_i, path)) continue;
+      rb::data::MBasic::New(name_i.c_str(), reinterpret_cast<void*>(addr + size*i), d);
     }
   }
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // void rb::data::Mapper::HandleSTL()     //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
-void rb::data::Mapper::HandleSTL(TDataMember* d, const char* name) {
+void rb::data::Mapper::HandleSTL(TDataMember* d, const char* name, const char* path) {
 	if(d->IsPersistent() == false) return;
   Long_t addr = kBase + d->GetOffset();
   Int_t nDim = d->GetArrayDim();
@@ -417,8 +613,9 @@ void rb::data::Mapper::HandleSTL(TDataMember* d, const char* name) {
     Int_t arrayLen = ac.GetArrayLength();
     Int_t size = d->GetUnitSize();
     for(Int_t i=0; i< arrayLen; ++i) {
-      addr += size*(i>0);
-      rb::data::MBasic::New(ac.GetFullName(name, i).c_str(), reinterpret_cast<void*>(addr), d);
+			std::string name_i = ac.GetFullName(name, i);
+			if(!on_path(name_i, path)) continue;
+      rb::data::MBasic::New(name_i.c_str(), reinterpret_cast<void*>(addr + size*i), d);
     }
   }
 }
@@ -492,12 +689,46 @@ void rb::data::Mapper::InsertSTL(TDataMember* d, std::vector<std::string>& v_nam
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 namespace {
 inline std::string append_name(const std::string& base, const char* toAppend) {
-  std::stringstream out;
-  out << base << "." << toAppend;
-  return out.str();
+  std::string out;
+  out.reserve(base.size() + strlen(toAppend) + 1);
+  out += base;
+  out += '.';
+  out += toAppend;
+  return out;
 }
 }
-void rb::data::Mapper::MapClass() {
+void rb::data::Mapper::MapClass(const char* path) {
+	if(const Reflection::Class* reflected = Reflection::Find(kClassName.c_str())) {
+		std::vector<Reflection::Member>::const_iterator m = reflected->fMembers.begin();
+		for(; m != reflected->fMembers.end(); ++m) {
+			std::string newName = append_name(kBranchName, m->fName.c_str());
+			if(!on_path(newName, path) || m->fType == Reflection::kUnsupported) continue;
+			const Reflection::Class* sub = m->fType == Reflection::kClass ? Reflection::Find(*m->fTypeId) : 0;
+			if(m->fType == Reflection::kClass && !sub) { // not reflected (e.g. STL), ask the dictionary
+				TClass* cl = TClass::GetClass(kClassName.c_str());
+				TDataMember* d = cl ? cl->GetDataMember(m->fName.c_str()) : 0;
+				if(d && ShouldBeMapped(d)) MapMember(d, path);
+				continue;
+			}
+			for(Int_t i=0; i< (m->fLength ? m->fLength : 1); ++i) {
+				std::string name_i = newName;
+				if(m->fLength) {
+					std::stringstream sstr;
+					sstr << newName << "[" << i << "]";
+					name_i = sstr.str();
+					if(!on_path(name_i, path)) continue;
+				}
+				const Long_t addr = kBase + m->fOffset + i*m->fSize;
+				if(sub) {
+					Mapper sub_mapper(name_i.c_str(), sub->fName.c_str(), addr, false);
+					sub_mapper.MapClass(path);
+				}
+				else
+					MBasic::New(name_i.c_str(), reinterpret_cast<void*>(addr), m->fType, m->fConst);
+			}
+		}
+		return;
+	}
   TClass* cl = TClass::GetClass(kClassName.c_str());
   if(!cl) {
 		if(0)	rb::err::Warning("MapClass")
@@ -509,34 +740,49 @@ void rb::data::Mapper::MapClass() {
   for(Int_t i=0; i< dataMembers->GetEntries(); ++i) {
     TDataMember* d = reinterpret_cast<TDataMember*>(dataMembers->At(i));
     if(!ShouldBeMapped(d)) continue;
-    std::string newName = append_name(kBranchName, d->GetName());
-    if(d->IsBasic())
-			HandleBasic(d, newName.c_str());
-		else if(d->IsSTLContainer())
-			HandleSTL(d, newName.c_str());
-    else {
-			Int_t nDim = d->GetArrayDim();
-			Long_t addr = kBase + d->GetOffset();
-			if(nDim == 0) { // single element, recurse into this class
-				Mapper sub_mapper(newName.c_str(), d->GetTrueTypeName(), addr, false);
-				sub_mapper.MapClass();
-			}
-			else if (nDim > 4) { // array to many dimensions - bail out
-				ERR_ARRAY_GREATER("MapClass", newName, d, 4);
-			}
-			else { // valid array, recurse into every element
-				ArrayConverter ac(d);
-				Int_t arrayLen = ac.GetArrayLength();
-				Int_t size = d->GetUnitSize();
-				for(Int_t i=0; i< arrayLen; ++i) {
-					Long_t addr_i = addr + size*i;
-					std::string name_i = ac.GetFullName(newName.c_str(), i); 
-					Mapper sub_mapper_i(name_i.c_str(), d->GetTrueTypeName(), addr_i, false);
-					sub_mapper_i.MapClass();
-				}
+		MapMember(d, path);
+	}
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::data::Mapper::MapMember()     //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::data::Mapper::MapMember(TDataMember* d, const char* path) {
+	std::string newName = append_name(kBranchName, d->GetName());
+	if(!on_path(newName, path)) return;
+	if(d->IsBasic())
+		HandleBasic(d, newName.c_str(), path);
+	else if(d->IsSTLContainer())
+		HandleSTL(d, newName.c_str(), path);
+	else {
+		Int_t nDim = d->GetArrayDim();
+		Long_t addr = kBase + d->GetOffset();
+		if(nDim == 0) { // single element, recurse into this class
+			Mapper sub_mapper(newName.c_str(), d->GetTrueTypeName(), addr, false);
+			sub_mapper.MapClass(path);
+		}
+		else if (nDim > 4) { // array to many dimensions - bail out
+			ERR_ARRAY_GREATER("MapClass", newName, d, 4);
+		}
+		else { // valid array, recurse into every element
+			ArrayConverter ac(d);
+			Int_t arrayLen = ac.GetArrayLength();
+			Int_t size = d->GetUnitSize();
+			for(Int_t i=0; i< arrayLen; ++i) {
+				Long_t addr_i = addr + size*i;
+				std::string name_i = ac.GetFullName(newName.c_str(), i);
+				if(!on_path(name_i, path)) continue;
+				Mapper sub_mapper_i(name_i.c_str(), d->GetTrueTypeName(), addr_i, false);
+				sub_mapper_i.MapClass(path);
 			}
-    }
-  }
+		}
+	}
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::data::Mapper::MapOnDemand() //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::data::Mapper::MapOnDemand() {
+	OnDemand root = { kBranchName, kClassName, kBase, false };
+	on_demand().push_back(root);
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // void rb::data::Mapper::ReadBranches()  //
@@ -586,7 +832,9 @@ void rb::data::Mapper::ReadBranches(std::vector<std::string>& branches) {
 // Helper Function for STL containers         //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 namespace {
-inline Long_t FindSTLAddr(const char* name, Long_t baseAddr, TDataMember* dataMember, TRealData* realData) {
+// If stl_index is non-zero, returns the address of the container and stores the element index in it.
+inline Long_t FindSTLAddr(const char* name, Long_t baseAddr, TDataMember* dataMember, TRealData* realData,
+													size_t* stl_index) {
 	Long_t retval = 0;
 	Int_t nDim = dataMember->GetArrayDim();
 	static STLMaps stlMaps;
@@ -604,7 +852,8 @@ inline Long_t FindSTLAddr(const char* name, Long_t baseAddr, TDataMember* dataMe
 			Long_t thisAddr = baseAddr + realData->GetThisOffset();
 			std::string strName(name);
 			int indx = get_final_index(&strName);
-			retval = it->second((volatile void*)thisAddr, indx);
+			if(!stl_index) retval = it->second((volatile void*)thisAddr, indx);
+			else if(indx >= 0) { retval = thisAddr; *stl_index = indx; }
 		}
 	}
 	else { // valid aray
@@ -629,7 +878,8 @@ inline Long_t FindSTLAddr(const char* name, Long_t baseAddr, TDataMember* dataMe
 						<< "No support for the STL class: " << dataMember->GetTrueTypeName() << ERR_FILE_LINE;
 				}
 				else {
-					retval = it->second((volatile void*)thisAddr, indx);
+					if(!stl_index) retval = it->second((volatile void*)thisAddr, indx);
+					else if(indx >= 0) { retval = thisAddr; *stl_index = indx; }
 					break;
 				}
 			}
@@ -640,6 +890,12 @@ inline Long_t FindSTLAddr(const char* name, Long_t baseAddr, TDataMember* dataMe
 } // namespace
 
 Long_t rb::data::Mapper::FindBasicAddr(const char* name, TDataMember** data_member) {
+	return FindAddr(name, data_member, 0);
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Long_t rb::data::Mapper::FindAddr()        //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Long_t rb::data::Mapper::FindAddr(const char* name, TDataMember** data_member, size_t* stl_index) {
   TClass* cl = TClass::GetClass(kClassName.c_str());
 	TRealData* realData = cl ? cl->GetRealData(name) : 0;
 	if(!realData && cl) { // try w/o brackets
@@ -679,7 +935,7 @@ Long_t rb::data::Mapper::FindBasicAddr(const char* name, TDataMember** data_memb
 	}
 
 	else if (dataMember->IsSTLContainer()  && dataMember->IsPersistent() ) { // delegate to FindSTLAddr function
-		retval = FindSTLAddr(name, kBase, dataMember, realData);
+		retval = FindSTLAddr(name, kBase, dataMember, realData, stl_index);
 	}
 
 	else if (dataMember->GetArrayDim() > 0) { // upper-level array
@@ -695,7 +951,7 @@ Long_t rb::data::Mapper::FindBasicAddr(const char* name, TDataMember** data_memb
 			size_t index = get_final_index(&strName);
 			Long_t addr = kBase + realData->GetThisOffset() + index*dataMember->GetUnitSize();
 			Mapper sub_mapper(strName3.c_str(), dataMember->GetTrueTypeName(), addr, false);
-			retval = sub_mapper.FindBasicAddr(strName2.c_str(), data_member);
+			retval = sub_mapper.FindAddr(strName2.c_str(), data_member, stl_index);
 		}
 	}
 
@@ -709,8 +965,14 @@ Long_t rb::data::Mapper::FindBasicAddr(const char* name, TDataMember** data_memb
 // rb::data::MReader* rb::data::Mapper::FindBasicReader()   //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 rb::data::MReader* rb::data::Mapper::FindBasicReader(const char* name, TDataMember** data_member) {
+	Long_t reflected = 0;
+	if(const Reflection::Member* m = Reflection::Resolve(kClassName.c_str(), name, kBase, &reflected)) {
+		if(data_member) *data_member = 0;
+		return rb::data::MReader::New(static_cast<MReader::Type_t>(m->fType), reflected);
+	}
 	TDataMember* d = 0;
-	Long_t retval = FindBasicAddr(name, &d);
+	size_t index = 0;
+	Long_t retval = FindAddr(name, &d, &index);
 	if(!retval) return 0;
 	assert(retval);
 	if(data_member) *data_member = d;
@@ -719,15 +981,14 @@ rb::data::MReader* rb::data::Mapper::FindBasicReader(const char* name, TDataMemb
 	}
 	else {
 		static STLMaps stlMaps;
-		STLBasicTypeMap_t::iterator it = stlMaps.GetBasicTypeMap()->find(TClass::GetClass(d->GetTrueTypeName()));
-		if(it == stlMaps.GetBasicTypeMap()->end()) {
+		STLReaderMap_t::iterator it = stlMaps.GetReaderMap()->find(TClass::GetClass(d->GetTrueTypeName()));
+		if(it == stlMaps.GetReaderMap()->end()) {
 			rb::err::Error("FindBasicReader")
 				<< "Couldn't figure out the basic type stored in container: \""
 				<< d->GetTrueTypeName() << "\"" << ERR_FILE_LINE;
 			return 0;
 		}
-		std::string strType = it->second;
-		return retval ? rb::data::MReader::New(strType.c_str(), retval) : 0;
+		return it->second(retval, index);
 	}
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
@@ -9,6 +9,7 @@
 #include <sstream>
 #include <cassert>
 #include <vector>
+#include <map>
 #include <TROOT.h>
 #include <TTree.h>
 #include <TError.h>
@@ -17,6 +18,7 @@
 #include "Event.hxx"
 #include "utils/Error.hxx"
 #include "utils/LockingPointer.hxx"
+#include "utils/boost_shared_ptr.h"
 #ifndef __MAKECINT__
 #include "boost/scoped_ptr.hpp"
 #else
@@ -32,24 +34,68 @@ typedef struct mxml_writer XmlWriter;
 
 namespace data
 {
+class MBasic;
+
+/// \brief Interned, hashed registry of leaf names.
+//! \details Each name is stored once and identified by a handle, its index in order of
+//! registration, which stays valid for the lifetime of the program. Lookups hash the name
+//! (FNV-1a) into an open addressing table of handles, so finding a name costs one hash and
+//! usually a single string comparison, however many names are registered.
+class NameRegistry
+{
+private:
+	//! Registered names, indexed by handle
+	std::vector<std::string> fNames;
+	//! Hash of each name, indexed by handle
+	std::vector<UInt_t> fHashes;
+	//! Entry registered under each name, indexed by handle
+	std::vector<MBasic*> fEntries;
+	//! Hash table of handles (-1 = empty), size a power of two, at most half full
+	std::vector<Int_t> fTable;
+public:
+	//! Empty registry
+	NameRegistry(): fTable(64, -1) { }
+	//! \brief Register \e entry under \e name
+	//! \returns The handle of \e name. If it was already registered, the existing entry is kept.
+	Int_t Insert(const char* name, MBasic* entry);
+	//! \brief Handle of \e name, -1 if it isn't registered
+	Int_t Find(const char* name) const;
+	//! \brief Entry with handle \e handle, 0 if the handle is invalid
+	MBasic* Get(Int_t handle) const {
+		return handle >= 0 && handle < GetN() ? fEntries[handle] : 0;
+	}
+	//! \brief Name with handle \e handle
+	const std::string& GetName(Int_t handle) const { return fNames.at(handle); }
+	//! \brief Number of registered names
+	Int_t GetN() const { return static_cast<Int_t>(fNames.size()); }
+private:
+	//! Hash function
+	static UInt_t Hash(const char* name, size_t length);
+	//! Double the size of fTable
+	void Grow();
+};
+
 /// \brief Abstract base class facilitating access to the values of basic data members of user's classes in CINT.
 //! \details See data::Basic <T> documentation for more info.
 class MBasic
 {
-public:
-	typedef std::map<std::string, MBasic*> Map_t;
 protected:
-	//! Maps the base name of each data class to a pointer to its corresponding
-	//! data::MBasic instance
-	static MBasic::Map_t& fgAll() {
-		static MBasic::Map_t* m = new MBasic::Map_t();
+	//! Registry of all instances, keyed by the leaf name of their data member
+	static NameRegistry& fgAll() {
+		static NameRegistry* m = new NameRegistry();
 		return *m;
 	}
 	//! The type of basic data (int, double, etc.)
-	const TDataMember* fDataMember;
+	const char* fTypeName;
+	//! Handle of this instance's name in fgAll()
+	Int_t fHandle;
 public:
-	//! Sets fDataMember
-	MBasic(const TDataMember* d): fDataMember(d) {}
+	//! Sets fTypeName from \e d and registers \c this in fgAll() under \e name
+	MBasic(const char* name, const TDataMember* d):
+		fTypeName(d->GetTrueTypeName()), fHandle(fgAll().Insert(name, this)) {}
+	//! Sets fTypeName and registers \c this in fgAll() under \e name
+	MBasic(const char* name, const char* typeName):
+		fTypeName(typeName), fHandle(fgAll().Insert(name, this)) {}
 	//! Nothing to do
 	virtual ~MBasic() {}
 	//! Pure virtual, see rb::data::Basic
@@ -58,17 +104,38 @@ public:
 	virtual void SetValue(Double_t newval) = 0;
 	//! Pure virtual, see rb::data::Basic
 	virtual Long_t GetAddress() = 0;
+	//! GetValue() without locking gDataMutex
+	virtual Double_t GetValueUnlocked() = 0;
+	//! SetValue() without locking gDataMutex
+	virtual void SetValueUnlocked(Double_t newval) = 0;
 	//! Returns the leaf name of this instance
 	const char* GetLeafName();
 	//! Returns a vector containing the names of all variables.
 	static std::vector<std::string> GetAll();
 	//! Search for an instance of Basic*
 	//! \param [in] leafName The name (how it would be referred to in TTree::Draw) of the class instance being searched for.
+	//! \details If \e leafName isn't registered yet, the classes waiting to be mapped (see Mapper::MapOnDemand())
+	//! are mapped along its path first.
 	static MBasic* Find(const char* leafName);
+	//! \brief Handle of the instance named \e leafName, -1 if there is none
+	//! \details Handles never change, so they can be looked up once and used with Get()
+	//! instead of repeating the search by name. Maps \e leafName on demand, like Find().
+	static Int_t FindHandle(const char* leafName);
+	//! \brief Is \e leafName registered? (never maps anything)
+	static Bool_t IsMapped(const char* leafName) { return fgAll().Find(leafName) >= 0; }
+	//! \brief Instance with handle \e handle, 0 if there is none
+	static MBasic* Get(Int_t handle) { return fgAll().Get(handle); }
 	//! Allocate a \c new instance of data::MBasic.
 	//! \returns A heap allocated instance of a data::MBasic-derived class (i.e. some data::Basic template class). It is
 	//! automatically caseted to the correct type based on the <i>basic_type_name</i> input parameter.
 	static void New(const char* name, volatile void* addr, TDataMember* element);
+	//! \brief Allocate a \c new instance of data::Basic<T> (or data::ConstBasic<T> if \e isConst)
+	//! \details Used for members known at compile time (see Reflect.hxx); \e type is the MReader::Type_t of \e T.
+	static void New(const char* name, volatile void* addr, Int_t type, Bool_t isConst);
+protected:
+	//! Finish mapping every class registered with Mapper::MapOnDemand()
+	static void MapAll();
+public:
 
   //! Prints or writes to a stream information on each entry in fgAll.
 	class Printer
@@ -86,35 +153,75 @@ public:
 
 /// \brief Class to read the data contained at a memory address, and translate it into a Double_t.
 //! \details This is an abstract class: implementations are templates that act on the actual type
-//! stored at the address.
+//! stored at the address. The address and a tag for the type are also kept in the base class,
+//! so that many readers can be read at once without virtual calls (see rb::data::ReaderGather).
 class MReader
 {
 public:
-	/// \brief Constructor, empty
-	MReader() { }
+	/// Type tags for the supported basic types
+	enum Type_t {
+		kDouble, kFloat, kLong64, kLong, kInt, kShort, kChar, kBool,
+		kULong64, kULong, kUInt, kUShort, kUChar, kNtypes,
+		kDynamic = kNtypes ///< Address resolved on each read (see ContainerReader)
+	};
+protected:
+	/// \brief Type_t of the data
+	Int_t fType;
+	/// \brief Address where the data of interest are stored.
+	Long_t fAddress;
+public:
+	/// \brief Constructor, sets fType and fAddress
+	MReader(Int_t type, Long_t address): fType(type), fAddress(address) { }
 	/// \brief Destructor, empty
 	virtual ~MReader() { }
 	/// \brief Casts the value at address to a Double_t
 	virtual Double_t ReadValue() = 0;
+	/// \brief Can ReadValue() be called from several threads at once? (false if it caches state)
+	virtual Bool_t IsReentrant() const { return true; }
 	/// \brief Virtual clone function
 	virtual MReader* Clone() = 0;
+	/// \brief Returns fType
+	Int_t GetType() const { return fType; }
+	/// \brief Returns fAddress
+	Long_t GetAddress() const { return fAddress; }
 	/// \brief Static "creation" function
 	//! \details Returns the appropriate derived type based on the passed string.
 	//! The string should correspond to the return value of TDataMember::GetRealTypeName().
 	//! \returns Address of the newly created MBasic; 0 if passed an invalid type name.
 	static MReader* New(const char* typeName, Long_t dataAddress);
+	/// \brief Static "creation" function for a known Type_t
+	//! \returns A reader of \e type at \e dataAddress; 0 if passed an invalid type.
+	static MReader* New(Type_t type, Long_t dataAddress);
+	/// \brief Name of the basic type with tag \e type (as TDataMember::GetTrueTypeName()), "" if invalid
+	static const char* GetTypeName(Int_t type);
 };
 
+/// \brief Maps a basic type to its MReader::Type_t
+template <class T> struct ReaderType;
+#define RB_READER_TYPE(type, tag) \
+	template <> struct ReaderType<type> { enum { kValue = MReader::tag }; }
+RB_READER_TYPE(double, kDouble);
+RB_READER_TYPE(float, kFloat);
+RB_READER_TYPE(long long, kLong64);
+RB_READER_TYPE(long, kLong);
+RB_READER_TYPE(int, kInt);
+RB_READER_TYPE(short, kShort);
+RB_READER_TYPE(char, kChar);
+RB_READER_TYPE(bool, kBool);
+RB_READER_TYPE(unsigned long long, kULong64);
+RB_READER_TYPE(unsigned long, kULong);
+RB_READER_TYPE(unsigned int, kUInt);
+RB_READER_TYPE(unsigned short, kUShort);
+RB_READER_TYPE(unsigned char, kUChar);
+#undef RB_READER_TYPE
+
 /// \brief Derived classes of MReader for the various basic data types.
 template <class T>
 class Reader: public MReader
 {
-private:
-	/// \brief Address where the data of interest are stored.
-	Long_t fAddress;
 public:
 	/// \brief Sets fAddress
-	Reader(Long_t address): fAddress(address) { }
+	Reader(Long_t address): MReader(ReaderType<T>::kValue, address) { }
 	/// \brief Empty
 	~Reader() { }
 	/// Casts the data at fAddress first to \e T, then to Double_t
@@ -128,6 +235,170 @@ public:
 	}
 };
 
+#ifndef __MAKECINT__
+/// \brief Base class for readers of one element of a (basic type) STL container.
+//! \details The element is looked up on every read, so the container may change size, or
+//! reallocate, from one event to the next: fAddress is the address of the container, and
+//! reads past its end return GetDefault() instead of failing.
+class ContainerReader: public MReader
+{
+protected:
+	/// Index of the element
+	size_t fIndex;
+	/// Value read for elements past the end of the container
+	static Double_t fgDefault;
+public:
+	/// \brief Read element \e index of the container at \e container
+	ContainerReader(Long_t container, size_t index): MReader(kDynamic, container), fIndex(index) { }
+	/// \brief Set the value read for missing elements (default 0, as TTreeFormula)
+	static void SetDefault(Double_t value) { fgDefault = value; }
+	/// \brief Value read for missing elements
+	static Double_t GetDefault() { return fgDefault; }
+};
+
+/// \brief Reads an element of a random access container (std::vector, std::deque) in O(1).
+template <class C>
+class IndexedReader: public ContainerReader
+{
+public:
+	/// \brief Read element \e index of the container at \e container
+	IndexedReader(Long_t container, size_t index): ContainerReader(container, index) { }
+	/// Bounds checked read of the element
+	virtual Double_t ReadValue() {
+		const C& c = *reinterpret_cast<const C*>(fAddress);
+		return fIndex < c.size() ? static_cast<Double_t>(c[fIndex]) : fgDefault;
+	}
+	/// Returns a copy of the current object
+	virtual MReader* Clone() {
+		return new IndexedReader(*this);
+	}
+};
+
+/// \brief Reads an element of a node based container (std::list, std::set, std::multiset).
+//! \details The reader keeps an iterator to its element, valid while the container has the same
+//! size and the same first and last nodes as when it was found; a read checks that in O(1) and
+//! otherwise walks to the element again from whichever of begin() and end() is nearer,
+//! O(min(index, size - index)). A container that is cleared and refilled gets new nodes, so the
+//! walk happens at most once per event. Replacing inner elements of a container while keeping its
+//! size and end nodes isn't detected: refill such containers rather than editing them in place.
+//! \attention The cached iterator makes ReadValue() non-reentrant (see IsReentrant()).
+template <class C>
+class NodeReader: public ContainerReader
+{
+private:
+	/// Size of the container when fElement was found (0: nothing cached)
+	size_t fSize;
+	/// First node of the container when fElement was found
+	typename C::const_iterator fFirst;
+	/// Last node of the container when fElement was found
+	typename C::const_iterator fLast;
+	/// The element read
+	typename C::const_iterator fElement;
+public:
+	/// \brief Read element \e index of the container at \e container
+	NodeReader(Long_t container, size_t index):
+		ContainerReader(container, index), fSize(0), fFirst(), fLast(), fElement() { }
+	/// Bounds checked read of the element
+	virtual Double_t ReadValue() {
+		const C& c = *reinterpret_cast<const C*>(fAddress);
+		const size_t n = c.size();
+		if(fIndex >= n) return fgDefault;
+		typename C::const_iterator last = c.end();
+		--last;
+		if(n != fSize || c.begin() != fFirst || last != fLast) {
+			typename C::const_iterator it;
+			if(fIndex < n - fIndex) { it = c.begin(); for(size_t i = 0; i< fIndex; ++i) ++it; }
+			else                    { it = c.end();   for(size_t i = n; i> fIndex; --i) --it; }
+			fSize = n; fFirst = c.begin(); fLast = last; fElement = it;
+		}
+		return static_cast<Double_t>(*fElement);
+	}
+	/// Returns false, reads update the cached iterator
+	virtual Bool_t IsReentrant() const { return false; }
+	/// Returns a copy of the current object
+	virtual MReader* Clone() {
+		return new NodeReader(*this);
+	}
+};
+
+/// \brief Reads a set of MReaders into an array of Double_t in one pass, without virtual calls.
+//! \details Readers are grouped by type into flat arrays of (address, destination index) when they
+//! are added; Read() then runs one tight, type-specific loop per type in use. Basic readers
+//! are not referenced after Add(), but their addresses must remain valid; MReader::kDynamic
+//! readers (container elements) are kept, and read through ReadValue().
+class ReaderGather
+{
+private:
+	/// Addresses and destination indices of the readers of one type
+	struct Column {
+		std::vector<Long_t> fAddress;
+		std::vector<Int_t> fSlot;
+	};
+	/// One Column per MReader::Type_t
+	Column fColumns[MReader::kNtypes];
+	/// Readers of type MReader::kDynamic
+	std::vector<MReader*> fDynamic;
+	/// Destination indices of fDynamic
+	std::vector<Int_t> fDynamicSlot;
+	/// Total number of readers added
+	Int_t fN;
+public:
+	/// Empty gather
+	ReaderGather(): fN(0) { }
+	/// \brief Read \e reader into out[slot] on each call to Read()
+	void Add(MReader* reader, Int_t slot) {
+		++fN;
+		if(reader->GetType() == MReader::kDynamic) {
+			fDynamic.push_back(reader);
+			fDynamicSlot.push_back(slot);
+			return;
+		}
+		Column& column = fColumns[reader->GetType()];
+		column.fAddress.push_back(reader->GetAddress());
+		column.fSlot.push_back(slot);
+	}
+	/// \brief Remove all readers
+	void Clear() {
+		for(Int_t i=0; i< MReader::kNtypes; ++i) {
+			fColumns[i].fAddress.clear();
+			fColumns[i].fSlot.clear();
+		}
+		fDynamic.clear();
+		fDynamicSlot.clear();
+		fN = 0;
+	}
+	/// \brief Number of readers added
+	Int_t GetN() const { return fN; }
+	/// \brief Read every reader into its slot of \e out
+	void Read(Double_t* out) const {
+		if(!fN) return;
+		ReadColumn<double>(MReader::kDouble, out);
+		ReadColumn<float>(MReader::kFloat, out);
+		ReadColumn<long long>(MReader::kLong64, out);
+		ReadColumn<long>(MReader::kLong, out);
+		ReadColumn<int>(MReader::kInt, out);
+		ReadColumn<short>(MReader::kShort, out);
+		ReadColumn<char>(MReader::kChar, out);
+		ReadColumn<bool>(MReader::kBool, out);
+		ReadColumn<unsigned long long>(MReader::kULong64, out);
+		ReadColumn<unsigned long>(MReader::kULong, out);
+		ReadColumn<unsigned int>(MReader::kUInt, out);
+		ReadColumn<unsigned short>(MReader::kUShort, out);
+		ReadColumn<unsigned char>(MReader::kUChar, out);
+		for(size_t i=0; i< fDynamic.size(); ++i)
+			out[fDynamicSlot[i]] = fDynamic[i]->ReadValue();
+	}
+private:
+	/// Read the column of type \e T
+	template <class T> void ReadColumn(Int_t type, Double_t* out) const {
+		const Column& column = fColumns[type];
+		const Int_t n = column.fSlot.size();
+		for(Int_t i=0; i< n; ++i)
+			out[column.fSlot[i]] = static_cast<Double_t>(*reinterpret_cast<const T*>(column.fAddress[i]));
+	}
+};
+#endif
+
 
 /// \brief Allows access to basic data members of user classes in CINT.
 //! \details The motivation behind this class is to allow users to have safe
@@ -216,12 +487,18 @@ public:
 	//! \details Also, in the case of an array, it iterates through the whole array and
 	//! creates a new instance of data::Basic for each element.
 	Basic(const char* name, volatile void* addr, const TDataMember* d);
+	/// \brief Sets fAddress and inserts \c this into data::MBasic::fgAll, without a TDataMember
+	Basic(const char* name, volatile void* addr);
 	//! Return the value of the data stored at fAddress
 	Double_t GetValue();
 	//! Change the value of the data stored at fAddress
 	void SetValue(Double_t newval);
 	//! Return the memory location of the basic data
 	Long_t GetAddress();
+	//! Return the value of the data stored at fAddress, without locking
+	Double_t GetValueUnlocked();
+	//! Change the value of the data stored at fAddress, without locking
+	void SetValueUnlocked(Double_t newval);
 	//! Nothing to do
 	virtual ~Basic();
 };
@@ -239,12 +516,18 @@ public:
 	//! \details Also, in the case of an array, it iterates through the whole array and
 	//! creates a new instance of data::Basic for each element.
 	ConstBasic(const char* name, volatile void* addr, const TDataMember* d);
+	/// \brief Sets fAddress and inserts \c this into data::MBasic::fgAll, without a TDataMember
+	ConstBasic(const char* name, volatile void* addr);
 	//! Return the value of the data stored at fAddress
 	Double_t GetValue();
 	//! Not allowed - gives warning message
 	void SetValue(Double_t);
 	//! Return the memory location of the basic data
 	Long_t GetAddress();
+	//! Return the value of the data stored at fAddress, without locking
+	Double_t GetValueUnlocked();
+	//! Not allowed - gives warning message
+	void SetValueUnlocked(Double_t);
 	//! Nothing to do
 	virtual ~ConstBasic();
 };
@@ -264,7 +547,15 @@ public:
 	Mapper(const char* branchname, const char* classname, Long_t base_address, Bool_t call_message);
 	//! Recurses through a class structure, and for each basic data member, creates a new
 	//! instance of rb::data::Basic.
-	void MapClass();
+	//! \param path If non-zero, only the members on this path (a leaf name or a prefix of leaf names,
+	//! e.g. <tt>"data.a.b[2]"</tt>) are mapped, and only the branches of the class leading to it are walked.
+	//! \details Classes registered in rb::data::Reflection are mapped from their registered members,
+	//! without reading the dictionary.
+	void MapClass(const char* path = 0);
+	//! \brief Defer MapClass() until the data is first looked up by name.
+	//! \details The class is remembered, and MBasic::Find() maps just the path it is asked for,
+	//! so the cost of mapping large classes is only paid for the leaves actually used.
+	void MapOnDemand();
 	//! Similar to MapClass(), except if isn't concerned with addresses and it fills an external vector.
 	void ReadBranches(std::vector<std::string>& branches);
 	//! \brief Finds the address of a specific piece of data.
@@ -276,14 +567,23 @@ public:
 	//! \returns The address at which the indicated datum is located, or 0 if the data isn't present.
 	//! \param [in] name Name of the data to search for
 	//! \param [out] data_member Optional, is set to the TDataMember corresponding to \e name
+	//! (0 for members registered in rb::data::Reflection, which are read without the dictionary)
+	//! \details Elements of STL containers get a reader that looks the element up on each read
+	//! (see rb::data::ContainerReader), so any index is accepted whatever the current size.
 	MReader* FindBasicReader(const char* name, TDataMember** data_member = 0);
 private:
+	//! \brief Implements FindBasicAddr().
+	//! \details If \e stl_index is non-zero and \e name is an element of an STL container, the
+	//! address of the container is returned instead, and the element index stored in \e stl_index.
+	Long_t FindAddr(const char* name, TDataMember** data_member, size_t* stl_index);
+	//! Map data member \e d of the class (and everything below it), see MapClass()
+	void MapMember(TDataMember* d, const char* path);
 	//! Handle a basic element, create a new instance of MBasic data for each array element.
-	void HandleBasic(TDataMember* d, const char* name);
+	void HandleBasic(TDataMember* d, const char* name, const char* path);
 	//! Insert basic element names into a vector of strings, handles arrays similar to HandleBasic
 	void InsertBasic(TDataMember* d, std::vector<std::string>& v_names, const char* name);
 	//! Handle a STL element, create a new instance of MBasic data for each array element.
-	void HandleSTL(TDataMember* d, const char* name);
+	void HandleSTL(TDataMember* d, const char* name, const char* path);
 	//! Insert STL element names into a vector of strings, handles arrays similar to HandleSTL
 	void InsertSTL(TDataMember* d, std::vector<std::string>& v_names, const char* name);
 	//! Adds a message to rb::Rint::fMessage indicating that a class's basic data has been mapped out.
@@ -427,8 +727,11 @@ public:
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 template <class T>
 inline rb::data::Basic<T>::Basic(const char* name, volatile void* addr, const TDataMember* d) :
-  MBasic(d), fAddress(reinterpret_cast<volatile T*>(addr)) {
-  fgAll().insert(std::make_pair<std::string, MBasic*>(name, this));
+  MBasic(name, d), fAddress(reinterpret_cast<volatile T*>(addr)) {
+}
+template <class T>
+inline rb::data::Basic<T>::Basic(const char* name, volatile void* addr) :
+  MBasic(name, MReader::GetTypeName(ReaderType<T>::kValue)), fAddress(reinterpret_cast<volatile T*>(addr)) {
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // Destructor                 //
@@ -460,6 +763,22 @@ inline Long_t rb::data::Basic<T>::GetAddress() {
   LockingPointer<T> p(fAddress, gDataMutex);
   return reinterpret_cast<Long_t>(p.Get());
 }
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Double_t rb::data::Basic<T>::GetValueUnlocked()   //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+template <class T>
+inline Double_t rb::data::Basic<T>::GetValueUnlocked() {
+  LockFreePointer<T> p(fAddress);
+  return *p;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::data::Basic<T>::SetValueUnlocked()       //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+template <class T>
+inline void rb::data::Basic<T>::SetValueUnlocked(Double_t newval) {
+  LockFreePointer<T> p(fAddress);
+  *p = T(newval);
+}
 
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // Template Class                         //
@@ -471,8 +790,11 @@ inline Long_t rb::data::Basic<T>::GetAddress() {
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 template <class T>
 inline rb::data::ConstBasic<T>::ConstBasic(const char* name, volatile void* addr, const TDataMember* d) :
-  MBasic(d), fAddress((const T*)addr) {
-  fgAll().insert(std::make_pair<std::string, MBasic*>(name, this));
+  MBasic(name, d), fAddress((const T*)addr) {
+}
+template <class T>
+inline rb::data::ConstBasic<T>::ConstBasic(const char* name, volatile void* addr) :
+  MBasic(name, MReader::GetTypeName(ReaderType<T>::kValue)), fAddress((const T*)addr) {
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // Destructor                 //
@@ -505,6 +827,20 @@ inline Long_t rb::data::ConstBasic<T>::GetAddress() {
 	RB_LOCKGUARD(gDataMutex);
   return (Long_t)fAddress;
 }
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Double_t rb::data::ConstBasic<T>::GetValueUnlocked()   //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+template <class T>
+inline Double_t rb::data::ConstBasic<T>::GetValueUnlocked() {
+  return *((T*)fAddress);
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::data::ConstBasic<T>::SetValueUnlocked()       //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+template <class T>
+inline void rb::data::ConstBasic<T>::SetValueUnlocked(Double_t newval) {
+	SetValue(newval);
+}
 
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // Template Class                        //
@@ -689,7 +1025,7 @@ void rb::data::Wrapper<T>::Init(Event* event, Bool_t makeVisible, const char* ar
     data::Mapper mapper (kBranchName, cl->GetName(), reinterpret_cast<Long_t>(fData.get()), true);
 		cmd << fData.get();
 #endif
-    mapper.MapClass();
+    mapper.MapOnDemand();
 		gROOT->ProcessLine(cmd.str().c_str());
   }
   // Add as a branch in the event's internal tree.
@@ -0,0 +1,142 @@
+//! \file DerivedVariables.cxx
+//! \brief Implements DerivedVariables.hxx
+#include <cctype>
+#include <iostream>
+#include "DerivedVariables.hxx"
+#include "utils/Error.hxx"
+
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Helper Functions                                      //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+namespace {
+//
+// Is name usable as a derived variable (a plain identifier, not a reserved word)?
+bool valid_name(const char* name) {
+	if(!name || !(isalpha(*name) || *name == '_')) return false;
+	for(const char* p = name; *p; ++p)
+		if(!(isalnum(*p) || *p == '_')) return false;
+	return std::string(name) != "pi";
+} }
+
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Class                                                 //
+// rb::DerivedVariables                                  //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Constructor (rb::DerivedVariables::Definition)        //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::DerivedVariables::Definition::Definition(const std::string& name):
+	fName(name), fExpression(), fIsGate(false), fValue(0.), fCompiled(), fDepends() { }
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Destructor (rb::DerivedVariables::Definition)         //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::DerivedVariables::Definition::~Definition() { }
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Constructor                                           //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::DerivedVariables::DerivedVariables(): fDefinitions(), fOrder() { }
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Destructor                                            //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::DerivedVariables::~DerivedVariables() { }
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Bool_t rb::DerivedVariables::Define()                 //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Bool_t rb::DerivedVariables::Define(const char* name, const char* expression, Bool_t isGate,
+																		const char* branchName, const char* className, void* classAddr) {
+	/*!
+	 * The expression is compiled against the class data and the current definitions. A redefinition
+	 * keeps the address of the old value, so formulae already reading it see the new definition; if
+	 * it would create a dependency cycle (e.g. redefining \c a in terms of \c b when \c b reads
+	 * \c a) it is refused.
+	 */
+	if(!valid_name(name)) {
+		rb::err::Error("rb::DerivedVariables::Define") << "Invalid name \"" << (name ? name : "") << "\"";
+		return false;
+	}
+	boost::scoped_ptr<rb::Expression> compiled
+		(new rb::Expression(expression, branchName, className, classAddr, this));
+	if(!compiled->IsValid()) {
+		rb::err::Error("rb::DerivedVariables::Define") << "Couldn't compile \"" << expression
+																									<< "\" (" << compiled->GetError() << ")";
+		return false;
+	}
+	std::vector<Int_t> depends;
+	for(Int_t i=0; i< compiled->GetNvar(); ++i) {
+		Int_t index = FindIndex(compiled->GetVariable(i));
+		if(index >= 0) depends.push_back(index);
+	}
+
+	Int_t index = FindIndex(name);
+	const Bool_t isNew = index < 0;
+	if(isNew) {
+		fDefinitions.push_back(new Definition(name));
+		index = fDefinitions.size() - 1;
+	}
+	Definition& def = fDefinitions[index];
+	def.fDepends.swap(depends);
+	if(!Sort()) {
+		rb::err::Error("rb::DerivedVariables::Define") << "Defining \"" << name << "\" as \"" << expression
+																									<< "\" would create a circular dependency";
+		if(isNew) fDefinitions.pop_back();
+		else def.fDepends.swap(depends);
+		return false;
+	}
+	def.fExpression = expression;
+	def.fIsGate = isGate;
+	def.fCompiled.swap(compiled);
+	return true;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// const Double_t* rb::DerivedVariables::Find()          //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+const Double_t* rb::DerivedVariables::Find(const char* name) const {
+	Int_t index = FindIndex(name);
+	return index < 0 ? 0 : &fDefinitions[index].fValue;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Int_t rb::DerivedVariables::FindIndex()               //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Int_t rb::DerivedVariables::FindIndex(const std::string& name) const {
+	for(size_t i=0; i< fDefinitions.size(); ++i)
+		if(fDefinitions[i].fName == name) return i;
+	return -1;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Bool_t rb::DerivedVariables::Sort()                   //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Bool_t rb::DerivedVariables::Sort() {
+	std::vector<Int_t> state(fDefinitions.size(), 0); // 0: new, 1: on the stack, 2: done
+	std::vector<Definition*> order;
+	for(size_t i=0; i< fDefinitions.size(); ++i)
+		if(!Visit(i, state, order)) return false;
+	fOrder.swap(order);
+	return true;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Bool_t rb::DerivedVariables::Visit()                  //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Bool_t rb::DerivedVariables::Visit(Int_t index, std::vector<Int_t>& state, std::vector<Definition*>& order) {
+	if(state[index] == 2) return true;
+	if(state[index] == 1) return false; // back edge: cycle
+	state[index] = 1;
+	const std::vector<Int_t>& depends = fDefinitions[index].fDepends;
+	for(size_t i=0; i< depends.size(); ++i)
+		if(!Visit(depends[i], state, order)) return false;
+	state[index] = 2;
+	order.push_back(&fDefinitions[index]);
+	return true;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::DerivedVariables::Print()                    //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::DerivedVariables::Print() const {
+	for(std::vector<Definition*>::const_iterator it = fOrder.begin(); it != fOrder.end(); ++it) {
+		std::cout << ((*it)->fIsGate ? "gate " : "     ") << (*it)->fName << " = " << (*it)->fExpression
+							<< "\t[" << (*it)->fValue << "]\n";
+	}
+	std::cout << std::flush;
+}
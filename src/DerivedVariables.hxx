@@ -0,0 +1,106 @@
+//! \file DerivedVariables.hxx
+//! \brief Defines named derived variables and gates, computed once per event.
+#ifndef RB_DERIVED_VARIABLES_HXX
+#define RB_DERIVED_VARIABLES_HXX
+#include <string>
+#include <vector>
+#include <Rtypes.h>
+#include "utils/nocopy.h"
+#include "utils/boost_scoped_ptr.h"
+#include "utils/boost_ptr_vector.h"
+#include "Expression.hxx"
+
+
+namespace rb
+{
+
+/// \brief Named quantities derived from an event's class data.
+//! \details Each definition is a compiled rb::Expression, which may read class members and any
+//! other derived variable of the same event, e.g.
+//! \code
+//! rb::data::Define("tof", "tail.mcp.tac - head.tail_time");
+//! rb::data::DefineGate("good_tof", "tof > 10 && tof < 50");
+//! \endcode
+//! The definitions form a dependency graph that is kept in topological order; Evaluate() computes
+//! every definition exactly once per event, after the event is unpacked and before anything else
+//! looks at it. Histogram parameters and gates refer to derived variables by name, just as they refer
+//! to class members, and read the stored value instead of recomputing it.
+//!
+//! The value of each definition has a fixed address for the lifetime of the event processor, so
+//! definitions can be changed (but not removed) while histograms are reading them. Redefinitions
+//! that would make the graph cyclic are refused. Gates are derived variables whose value is forced
+//! to 0 or 1.
+class DerivedVariables
+{
+public:
+	/// A single definition
+	struct Definition {
+		/// Name used to refer to the definition
+		std::string fName;
+		/// Source expression
+		std::string fExpression;
+		/// Is it a gate (value forced to 0 or 1)?
+		Bool_t fIsGate;
+		/// Value for the current event
+		Double_t fValue;
+		/// Compiled expression
+		boost::scoped_ptr<rb::Expression> fCompiled;
+		/// Indices (in fDefinitions) of the derived variables read by fCompiled
+		std::vector<Int_t> fDepends;
+		/// Empty definition named \e name
+		Definition(const std::string& name);
+		/// Frees fCompiled
+		~Definition();
+	};
+private:
+	/// All definitions, in order of creation (never erased, so fValue addresses stay valid)
+	boost::ptr_vector<Definition> fDefinitions;
+	/// Definitions in evaluation (topological) order
+	std::vector<Definition*> fOrder;
+
+public:
+	/// Empty registry
+	DerivedVariables();
+	/// Frees the definitions
+	~DerivedVariables();
+	/// \brief Create or replace a definition.
+	//! \param name Identifier used to refer to the variable.
+	//! \param expression Formula defining it (see rb::Expression for the syntax).
+	//! \param isGate If true the value is forced to 0 or 1.
+	//! \param branchName, className, classAddr The event class the expression reads from.
+	//! \returns true on success; on failure the previous definition (if any) stays in place.
+	Bool_t Define(const char* name, const char* expression, Bool_t isGate,
+								const char* branchName, const char* className, void* classAddr);
+	/// \brief Compute all definitions for the current event, in dependency order.
+	void Evaluate();
+	/// \brief Address of the value of \e name, 0 if there's no such definition.
+	const Double_t* Find(const char* name) const;
+	/// \brief Number of definitions
+	Int_t GetNdefinitions() const { return static_cast<Int_t>(fDefinitions.size()); }
+	/// \brief Print the definitions in evaluation order, with their current values.
+	void Print() const;
+private:
+	/// Index of \e name in fDefinitions, -1 if not found
+	Int_t FindIndex(const std::string& name) const;
+	/// Rebuild fOrder; returns false (leaving fOrder untouched) if the graph has a cycle
+	Bool_t Sort();
+	/// Depth-first visit for Sort()
+	Bool_t Visit(Int_t index, std::vector<Int_t>& state, std::vector<Definition*>& order);
+
+	RB_NOCOPY(DerivedVariables);
+};
+
+} // namespace rb
+
+
+#ifndef __MAKECINT__
+
+inline void rb::DerivedVariables::Evaluate() {
+	for(std::vector<Definition*>::iterator it = fOrder.begin(); it != fOrder.end(); ++it)
+		(*it)->fValue = (*it)->fIsGate ? ((*it)->fCompiled->Eval() != 0) : (*it)->fCompiled->Eval();
+}
+
+#endif
+
+
+#endif
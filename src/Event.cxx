@@ -1,17 +1,152 @@
 //! \file Event.cxx
 //! \brief Implements Event.hxx
+#include <cctype>
 #include <cassert>
+#include <set>
+#include <sstream>
+#include <RVersion.h>
+#include <TFile.h>
+#include <TString.h>
 #include "Event.hxx"
 #include "Rint.hxx"
+#include "Data.hxx"
+#include "Formula.hxx"
+#include "DerivedVariables.hxx"
 #include "hist/Hist.hxx"
 #include "utils/Logger.hxx"
 
 namespace {
 const bool formulaPrint = true;
+
+//
+// Turn a column specification into a valid leaf name ("a.b[3]" -> "a_b_3")
+std::string leaf_name(const std::string& column) {
+	std::string out;
+	for(size_t i=0; i< column.size(); ++i) {
+		char c = column[i];
+		if(isalnum(c)) out.push_back(c);
+		else if(!out.empty() && out[out.size()-1] != '_') out.push_back('_');
+	}
+	while(!out.empty() && out[out.size()-1] == '_') out.erase(out.size()-1);
+	return out.empty() ? std::string("col") : out;
+}
+
+//
+// Leaf name of a column that isn't in used yet: different columns can flatten
+// to the same name ("a.b[3]" and "a_b_3"), so later ones get "_1", "_2", ...
+std::string unique_leaf_name(const std::string& column, std::set<std::string>& used) {
+	const std::string base = leaf_name(column);
+	std::string out = base;
+	for(Int_t n = 1; !used.insert(out).second; ++n) {
+		std::stringstream sstr;
+		sstr << base << "_" << n;
+		out = sstr.str();
+	}
+	if(out != base)
+		rb::err::Warning("rb::Event::Save::BranchColumns")
+			<< "The leaf name \"" << base << "\" is already taken, saving column \""
+			<< column << "\" as \"" << out << "\".";
+	return out;
+}
+
+//
+// Expand "name[]" columns to each element of the array "name"
+std::vector<std::string> expand_columns(TTree* tree, const std::vector<std::string>& columns) {
+	std::vector<std::string> out, all;
+	for(size_t i=0; i< columns.size(); ++i) {
+		const std::string& col = columns[i];
+		if(col.size() < 3 || col.substr(col.size()-2) != "[]") {
+			out.push_back(col);
+			continue;
+		}
+		if(all.empty()) {
+			for(Int_t j=0; j< tree->GetListOfBranches()->GetEntries(); ++j) {
+				TBranch* branch = static_cast<TBranch*>(tree->GetListOfBranches()->At(j));
+				rb::data::Mapper mapper(branch->GetName(), branch->GetClassName(), 0, false);
+				mapper.ReadBranches(all);
+			}
+		}
+		const std::string prefix = col.substr(0, col.size()-1); // keep the "["
+		Int_t nfound = 0;
+		for(size_t j=0; j< all.size(); ++j) {
+			if(all[j].compare(0, prefix.size(), prefix) == 0) {
+				out.push_back(all[j]);
+				++nfound;
+			}
+		}
+		if(!nfound)
+			rb::err::Error("rb::Event::Save::Start") << "No array elements found matching \"" << col << "\"";
+	}
+	return out;
+}
 }
 
 namespace rb { rb::Mutex gDataMutex("gDataMutex"); }
 
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Class                                                 //
+// rb::SavePolicy                                        //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Constructor                                           //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::SavePolicy::SavePolicy():
+	fAlgorithm(kGlobal), fLevel(-1), fBasketSize(32000),
+	fAutoFlush(-30000000), fAutoSave(-300000000), fImplicitMT(false)
+{
+	/*!
+	 * A level of -1 means "leave the compression alone", i.e. use whatever
+	 * the TFile was constructed with.
+	 */
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Int_t rb::SavePolicy::GetCompressionSettings()        //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Int_t rb::SavePolicy::GetCompressionSettings() const {
+	/*!
+	 * \returns -1 if the compression should not be changed from the file default.
+	 */
+	if(fLevel < 0) return -1;
+	Int_t level = fLevel > 9 ? 9 : fLevel;
+	return 100*fAlgorithm + level;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Int_t rb::SavePolicy::ParseAlgorithm()                //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Int_t rb::SavePolicy::ParseAlgorithm(const char* name) {
+	/*!
+	 * Not case sensitive. LZ4 requires ROOT >= 6.10; on older versions
+	 * ZLIB is substituted (with a warning).
+	 */
+	TString s(name);
+	s.ToLower();
+	if(s == "" || s == "default" || s == "global") return kGlobal;
+	if(s == "zlib") return kZLIB;
+	if(s == "lzma") return kLZMA;
+	if(s == "lz4") {
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,10,0)
+		return kLZ4;
+#else
+		rb::err::Warning("rb::SavePolicy::ParseAlgorithm")
+			<< "LZ4 compression requires ROOT >= 6.10, using ZLIB instead.";
+		return kZLIB;
+#endif
+	}
+	return -1;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// const char* rb::SavePolicy::AlgorithmName()           //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+const char* rb::SavePolicy::AlgorithmName(Int_t algorithm) {
+	switch(algorithm) {
+	case kZLIB: return "zlib";
+	case kLZMA: return "lzma";
+	case kLZ4:  return "lz4";
+	default:    return "default";
+	}
+}
+
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // Class                                                 //
 // rb::Event                                             //
@@ -21,6 +156,8 @@ namespace rb { rb::Mutex gDataMutex("gDataMutex"); }
 // Constructor                                           //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 rb::Event::Event(): fTree(new TTree("tree", "Rootbeer event tree")),
+										fDerived(new rb::DerivedVariables()),
+										fFormulaCache(new rb::FormulaCache()),
 										fHistManager(), fSave(new rb::Event::Save(this))
 {									
   LockingPointer<TTree> pTree(fTree, gDataMutex);
@@ -28,6 +165,32 @@ rb::Event::Event(): fTree(new TTree("tree", "Rootbeer event tree")),
   pTree->SetCircular(1); // Allows storage of only one event
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Destructor                                            //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::Event::~Event() {
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::FormulaCache* rb::Event::GetFormulaCache()        //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::FormulaCache* rb::Event::GetFormulaCache() {
+	return fFormulaCache.get();
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Bool_t rb::Event::Define()                            //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Bool_t rb::Event::Define(const char* name, const char* expression, Bool_t isGate) {
+	LockingPointer<Long_t> pAddr(fClassAddr, gDataMutex);
+	return fDerived->Define(name, expression, isGate, fBranchname.c_str(), fClassname.c_str(),
+													reinterpret_cast<void*>(*pAddr));
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::Event::PrintDerived()                        //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::Event::PrintDerived() {
+	RB_LOCKGUARD(gDataMutex);
+	fDerived->Print();
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // void rb::Event::Process()                             //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 void rb::Event::Process(const void* event_address, Int_t nchar) {
@@ -39,6 +202,8 @@ void rb::Event::Process(const void* event_address, Int_t nchar) {
 		LockFreePointer<rb::Event::Save> pSave(fSave);
     success = DoProcess(event_address, nchar);
     if(success) {
+			fDerived->Evaluate();
+			fFormulaCache->NextEvent();
       pTree->Fill();
       pTree->LoadTree(0);
 			pSave->Fill();
@@ -57,9 +222,23 @@ void rb::Event::StartSave(boost::shared_ptr<TFile> file, const char* name, const
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // void rb::Event::StopSave()                            //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
-void rb::Event::StopSave() {
+void rb::Event::StopSave(Bool_t deferred) {
 	LockingPointer<rb::Event::Save> pSave(fSave, gDataMutex);
-	pSave->Stop();
+	pSave->Stop(deferred);
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::Event::SetSavePolicy()                       //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::Event::SetSavePolicy(const SavePolicy& policy) {
+	LockingPointer<rb::Event::Save> pSave(fSave, gDataMutex);
+	pSave->SetPolicy(policy);
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::SavePolicy rb::Event::GetSavePolicy()             //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::SavePolicy rb::Event::GetSavePolicy() {
+	LockingPointer<rb::Event::Save> pSave(fSave, gDataMutex);
+	return pSave->GetPolicy();
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // rb::Event::GetBranchList()                            //
@@ -95,13 +274,31 @@ rb::DataFormula* rb::Event::InitFormula::Operate(rb::Event* const event, const c
 	assert(pTree->GetListOfBranches()->GetEntries() == 1);
 
 	LockFreePointer<Long_t> pAddr(event->fClassAddr);
+	std::stringstream rejected; // reasons for passing over each method, see rb::hist::PrintFormulaReport()
 	//
-	// ClassFormula should handle it all
+	// Compiled expression handles everything but TFormula-specific syntax
+	rb::ExpressionDataFormula* compiled =
+		new rb::ExpressionDataFormula(formula_arg, event->fBranchname.c_str(), event->fClassname.c_str(),
+																	reinterpret_cast<void*>(*pAddr), event->fDerived.get());
+	if(compiled->IsZombie() == false) {
+		if(formulaPrint) rb::err::Info("InitFormula") << "Using compiled expression ("
+																							<< compiled->GetExpression().GetNinstructions()
+																							<< " instructions) to evaluate \"" << formula_arg << "\"";
+		return compiled;
+	}
+	rejected << "compiled: " << compiled->GetExpression().GetError();
+	delete compiled;
+
+	// Fall back on ClassFormula (TFormula syntax)
 	rb::ClassDataFormula* clform =
 		new rb::ClassDataFormula(formula_arg, formula_arg,
 														 event->fBranchname.c_str(), event->fClassname.c_str(),
 														 reinterpret_cast<void*>(*pAddr));
-	if(clform->IsZombie() == false) return clform;
+	if(clform->IsZombie() == false) {
+		clform->SetDiagnostics(rejected.str());
+		return clform;
+	}
+	rejected << "; ClassFormula: not valid TFormula syntax for the class members";
 	delete clform;
 
 	// Try constant 
@@ -109,8 +306,10 @@ rb::DataFormula* rb::Event::InitFormula::Operate(rb::Event* const event, const c
 	if(constant->IsZombie() == false) {
 		if(formulaPrint) rb::err::Info("InitFormula") << "Using constant " << constant->Evaluate()
 																							<< " to evaluate \"" << formula_arg << "\"";
+		constant->SetDiagnostics(rejected.str());
 		return constant;
 	}
+	rejected << "; constant: not a number";
 	delete constant; // didn't work
 
 	// try direct
@@ -118,13 +317,17 @@ rb::DataFormula* rb::Event::InitFormula::Operate(rb::Event* const event, const c
 		new rb::DirectDataFormula(branch->GetName(), branch->GetClassName(), reinterpret_cast<void*>(*pAddr), formula_arg);
 	if(direct->IsZombie() == false) {
 		if(formulaPrint) rb::err::Info("InitFormula") << "Using direct address to evaluate \"" << formula_arg << "\"";
+		direct->SetDiagnostics(rejected.str());
 		return direct;
 	}
+	rejected << "; direct: not a single basic class member";
 	delete direct; // didn't work
 
 	// resort to TTreeFormula
 	if(formulaPrint) rb::err::Info("InitFormula") << "Using TTreeFormula to evaluate \"" << formula_arg << "\"";
-	return new rb::TTreeDataFormula(formula_arg, formula_arg, pTree.Get());
+	rb::DataFormula* ttf = new rb::TTreeDataFormula(formula_arg, formula_arg, pTree.Get());
+	ttf->SetDiagnostics(rejected.str());
+	return ttf;
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // Bool_t rb::Event::BranchAdd::Operate()                //
@@ -141,6 +344,18 @@ Bool_t rb::Event::BranchAdd::Operate(rb::Event* const event, const char* name, c
   return branch != 0;
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Constructor (rb::Event::Save)                         //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::Event::Save::Save(rb::Event* event):
+	fEvent(event), fIsActive(false), fSaveHistograms(false), fTree(0),
+	fBranchAddr(0), fPolicy(), fColumnFormulae(), fColumnValues() { }
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Destructor (rb::Event::Save)                          //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::Event::Save::~Save() {
+	Stop();
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // void rb::Event::Save::Start()                         //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 void rb::Event::Save::Start(boost::shared_ptr<TFile> file, const char* name, const char* title, Bool_t save_hists) {
@@ -152,40 +367,108 @@ void rb::Event::Save::Start(boost::shared_ptr<TFile> file, const char* name, con
 	fTree = new TTree(pEventTree->GetName(), pEventTree->GetTitle());
 	if(strcmp(name, "")) fTree->SetName(name);
 	if(strcmp(title, "")) fTree->SetTitle(title);
+	fTree->SetAutoFlush(fPolicy.fAutoFlush);
+	fTree->SetAutoSave(fPolicy.fAutoSave);
+	if(fPolicy.fColumns.empty()) BranchFull();
+	else BranchColumns();
+	const Int_t compress = fPolicy.GetCompressionSettings();
+	if(compress >= 0) {
+		for(Int_t i=0; i< fTree->GetListOfBranches()->GetEntries(); ++i) // recurses into sub-branches
+			static_cast<TBranch*>(fTree->GetListOfBranches()->At(i))->SetCompressionSettings(compress);
+	}
+	fIsActive = true;
+	if(current) current->cd();
+	else gROOT->cd();
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::Event::Save::BranchFull()                    //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::Event::Save::BranchFull() {
+	LockFreePointer<TTree> pEventTree(fEvent->fTree);
 	std::string br_name = "", br_clname = "";
+	fBranchAddr.clear();
 	for(int i=0; i< pEventTree->GetListOfBranches()->GetEntries(); ++i) {
 		TBranch* branch = static_cast<TBranch*>(pEventTree->GetListOfBranches()->At(i));
 		br_name = branch->GetName();
 		br_clname = branch->GetClassName();
 		fBranchAddr.push_back(reinterpret_cast<void**>(branch->GetAddress()));
-		fTree->Branch(br_name.c_str(), br_clname.c_str(), fBranchAddr.at(i));
+		fTree->Branch(br_name.c_str(), br_clname.c_str(), fBranchAddr.at(i), fPolicy.fBasketSize);
+	}
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::Event::Save::BranchColumns()                 //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::Event::Save::BranchColumns() {
+	/*!
+	 * Each column gets a DataFormula from the event's FormulaCache (and so from
+	 * InitFormula::Operate()), so plain leaves are read through their direct address,
+	 * and columns that are also histogram parameters are evaluated only once per event.
+	 * Columns ending in "[]" are expanded to every array element known to
+	 * rb::data::Mapper. Invalid columns are skipped with an error message, and
+	 * columns whose leaf names collide get a numbered suffix.
+	 */
+	fColumnFormulae.clear();
+	LockFreePointer<TTree> pEventTree(fEvent->fTree);
+	std::vector<std::string> columns = expand_columns(pEventTree.Get(), fPolicy.fColumns);
+	std::vector<std::string> leaves;
+	std::set<std::string> used;
+	for(size_t i=0; i< columns.size(); ++i) {
+		rb::DataFormula* formula = 0;
+		try {
+			rb::FormulaCache* cache = fEvent->GetFormulaCache();
+			formula = new rb::CachedDataFormula(cache, cache->Get(fEvent, columns[i].c_str()));
+		} catch (std::exception& e) {
+			formula = 0;
+		}
+		if(!formula || formula->IsZombie()) {
+			rb::err::Error("rb::Event::Save::BranchColumns")
+				<< "Invalid column \"" << columns[i] << "\", skipping.";
+			delete formula;
+			continue;
+		}
+		fColumnFormulae.push_back(formula);
+		leaves.push_back(unique_leaf_name(columns[i], used));
+	}
+	// Size fColumnValues once, so the branch addresses below stay valid
+	fColumnValues.assign(fColumnFormulae.size(), 0.);
+	for(size_t i=0; i< leaves.size(); ++i) {
+		std::string leaflist = leaves[i] + "/D";
+		fTree->Branch(leaves[i].c_str(), &fColumnValues[i], leaflist.c_str(), fPolicy.fBasketSize);
 	}
-	fIsActive = true;
-	if(current) current->cd();
-	else gROOT->cd();
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // void rb::Event::Save::Stop()                          //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
-void rb::Event::Save::Stop() {
+void rb::Event::Save::Stop(Bool_t deferred) {
+	/*!
+	 * \param deferred If true, skip the final AutoSave() of fTree. The tree stays in memory
+	 * (owned by fFile) with its branch addresses reset, so it no longer references event data;
+	 * it then has to be written by whoever closes the file (e.g. the background closer used for
+	 * online file rollover), which keeps basket compression off of the processing thread.
+	 */
 	if(!fTree) return;
 	if(!fFile.get()) return;
 	TDirectory* current = gDirectory;
 	fFile->cd();
 	fTree->GetCurrentFile();
-	fTree->AutoSave();
+	if(!deferred) fTree->AutoSave();
 	fTree->ResetBranchAddresses();
 	if(fSaveHistograms) fEvent->fHistManager.WriteAll(fFile.get());
 	if(current) current->cd();
 	else gROOT->cd();
 	if(fFile.get()) fFile.reset();
+	fTree = 0; // owned (and deleted) by fFile
+	fColumnFormulae.clear();
 	fIsActive = false;
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // void rb::Event::Save::Fill()                          //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 void rb::Event::Save::Fill() {
-	if(fIsActive && fTree) fTree->Fill();
+	if(!fIsActive || !fTree) return;
+	for(size_t i=0; i< fColumnFormulae.size(); ++i)
+		fColumnValues[i] = fColumnFormulae[i].Evaluate();
+	fTree->Fill();
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // void rb::Event::RunBegin::operator()                  //
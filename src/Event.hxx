@@ -21,6 +21,7 @@
 #include "utils/nocopy.h"
 #include "utils/boost_scoped_ptr.h"
 #include "utils/boost_shared_ptr.h"
+#include "utils/boost_ptr_vector.h"
 
 
 class TH1;
@@ -32,10 +33,49 @@ typedef boost::scoped_ptr<volatile TTreeFormula> FormulaPtr_t;
 
 class Rint;
 class DataFormula;
+class FormulaCache;
 class TreeFormulae;
+class DerivedVariables;
 namespace data { template <class T> class Wrapper; }
 namespace hist { class Base; }
 
+/// \brief Settings used when writing event data to disk.
+//! \details Controls the compression, basket size and flushing behavior of the
+//! trees (and files) created by rb::Event::Save. Defaults match the ROOT defaults,
+//! so an untouched policy behaves exactly as a plain TTree would.
+struct SavePolicy
+{
+	//! Compression algorithm codes (same values as ROOT's ECompressionAlgorithm)
+	enum Algorithm_t { kGlobal = 0, kZLIB = 1, kLZMA = 2, kLZ4 = 4 };
+
+	//! Compression algorithm (one of Algorithm_t)
+	Int_t fAlgorithm;
+	//! Compression level (0 = none, 9 = max)
+	Int_t fLevel;
+	//! Basket buffer size passed to TTree::Branch()
+	Int_t fBasketSize;
+	//! Argument to TTree::SetAutoFlush() (<0 is bytes, >0 is entries)
+	Long64_t fAutoFlush;
+	//! Argument to TTree::SetAutoSave() (<0 is bytes, >0 is entries)
+	Long64_t fAutoSave;
+	//! Use ROOT implicit multi-threading (parallel basket compression)
+	Bool_t fImplicitMT;
+	//! \brief Columns to save in flat-ntuple mode.
+	//! \details Each entry is a leaf name or formula, evaluated event-by-event and stored as
+	//! a Double_t leaf. A trailing \c [] (e.g. "ecal[]") expands to every array element.
+	//! Empty means save the full top-level branches (default).
+	std::vector<std::string> fColumns;
+
+	//! Set ROOT defaults
+	SavePolicy();
+	//! Returns compression settings in ROOT format (100*algorithm + level)
+	Int_t GetCompressionSettings() const;
+	//! Convert a string ("zlib", "lzma", "lz4", "default") into an Algorithm_t code, -1 if invalid
+	static Int_t ParseAlgorithm(const char* name);
+	//! Convert an Algorithm_t code into a string
+	static const char* AlgorithmName(Int_t algorithm);
+};
+
 /// \brief Abstract base class for event processors.
 class Event
 {
@@ -53,6 +93,12 @@ private:
 	//! Memory address of fTree's branch (the actual class)
 	volatile Long_t fClassAddr;
 
+	//! Named derived variables and gates (declared first, formulae read their values)
+	boost::scoped_ptr<DerivedVariables> fDerived;
+
+	//! Formulae shared between this event's histograms (declared before fHistManager so it outlives them)
+	boost::scoped_ptr<FormulaCache> fFormulaCache;
+
 	//! Manages histograms associated with the event
 	hist::Manager fHistManager;
 
@@ -61,11 +107,31 @@ public:
 	void StartSave(boost::shared_ptr<TFile> file, const char* name, const char* title, Bool_t save_hists = false);
 
 	//! Stop saving the output to a root tree on disk.
-	void StopSave();
+	//! \param deferred If true, leave flushing the tree's baskets to whoever closes the file
+	//!  (see rb::Event::Save::Stop()).
+	void StopSave(Bool_t deferred = false);
+
+	//! Set the policy used for subsequent saves (takes effect on the next StartSave()).
+	void SetSavePolicy(const SavePolicy& policy);
+
+	//! Return a copy of the current save policy.
+	SavePolicy GetSavePolicy();
 
 	//! Return a pointer to fHistManager
 	hist::Manager* const GetHistManager();
 
+	//! Return a pointer to the shared formula cache (access only with gDataMutex locked)
+	FormulaCache* GetFormulaCache();
+
+	//! \brief Create or replace a named derived variable (or gate, if \e isGate is true).
+	//! \details See rb::DerivedVariables; the value is computed once per event, right after
+	//! DoProcess(), and can be used by name in any formula of this event.
+	//! \returns true on success, false (with an error message) otherwise.
+	Bool_t Define(const char* name, const char* expression, Bool_t isGate = false);
+
+	//! Print the derived variables and their current values
+	void PrintDerived();
+
 	//! \brief Public interface for processing an event.
 	//! \details The real work for actually doing something with the event data
 	//! is done in the virtual member DoProcess(). This function just takes care
@@ -169,17 +235,32 @@ public:
 		TTree* fTree;
 		//! Vector of branch addresses (for fSaveTree)
 		std::vector<void**> fBranchAddr;
+		//! Compression, basket and flushing settings
+		SavePolicy fPolicy;
+		//! Formulae evaluating each column (flat-ntuple mode only)
+		boost::ptr_vector<rb::DataFormula> fColumnFormulae;
+		//! Storage for column values, branch addresses of fTree (flat-ntuple mode only)
+		std::vector<Double_t> fColumnValues;
+ private:
+		//! Create fTree branches as clones of the event tree's top-level branches
+		void BranchFull();
+		//! Create one Double_t branch per column in fPolicy.fColumns
+		void BranchColumns();
  public:
 		//! Start saving
 		void Start(boost::shared_ptr<TFile> file, const char* name, const char* title, Bool_t save_hists = false);
 		//! Stop saving
-		void Stop();
+		void Stop(Bool_t deferred = false);
 		//! Fill fTree (if active)
 		void Fill();
+		//! Set fPolicy
+		void SetPolicy(const SavePolicy& policy) { fPolicy = policy; }
+		//! Return fPolicy
+		const SavePolicy& GetPolicy() const { return fPolicy; }
 		//! Constructor
-		Save(rb::Event* event): fEvent(event), fIsActive(false), fSaveHistograms(false), fTree(0), fBranchAddr(0) { }
+		Save(rb::Event* event);
 		//! Destructor
-		~Save() { Stop(); }
+		~Save();
 	};
 
 	/// \brief Functor class to for calling BeginRun()
@@ -211,9 +292,6 @@ private:
 
 // ======== Inlined Function Implementations ========= //
 
-inline rb::Event::~Event() {
-}
-
 inline rb::hist::Manager* const rb::Event::GetHistManager() {
   return &fHistManager;
 }
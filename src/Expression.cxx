@@ -0,0 +1,699 @@
+//! \file Expression.cxx
+//! \brief Implements Expression.hxx
+#include <cmath>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <TMath.h>
+#include <TROOT.h>
+#include <TCutG.h>
+#include "Data.hxx"
+#include "PolygonGate.hxx"
+#include "DerivedVariables.hxx"
+#include "Expression.hxx"
+
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Helper Functions                                      //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+namespace {
+
+typedef rb::Expression Ex;
+
+//
+// Math functions available to expressions; arguments out of domain are handled as TFormula does
+// (0 or a clamped argument rather than NaN), so the compiled engine can stand in for it
+typedef Double_t (*Func1_t)(Double_t);
+typedef Double_t (*Func2_t)(Double_t, Double_t);
+
+Double_t f_sin  (Double_t x) { return sin(x);   }
+Double_t f_cos  (Double_t x) { return cos(x);   }
+Double_t f_tan  (Double_t x) { return tan(x);   }
+Double_t f_asin (Double_t x) { return fabs(x) > 1 ? asin(1.) : asin(x); }
+Double_t f_acos (Double_t x) { return fabs(x) > 1 ? acos(1.) : acos(x); }
+Double_t f_atan (Double_t x) { return atan(x);  }
+Double_t f_sinh (Double_t x) { return sinh(x);  }
+Double_t f_cosh (Double_t x) { return cosh(x);  }
+Double_t f_tanh (Double_t x) { return tanh(x);  }
+Double_t f_asinh(Double_t x) { return TMath::ASinH(x); }
+Double_t f_acosh(Double_t x) { return x < 1 ? 0. : TMath::ACosH(x); }
+Double_t f_atanh(Double_t x) { return fabs(x) > 1 ? 0. : TMath::ATanH(x); }
+Double_t f_exp  (Double_t x) { return x < -700 ? 0. : exp(x > 700 ? 700. : x); }
+Double_t f_log  (Double_t x) { return x > 0 ? log(x) : 0.; }
+Double_t f_log10(Double_t x) { return x > 0 ? log10(x) : 0.; }
+Double_t f_floor(Double_t x) { return floor(x); }
+Double_t f_ceil (Double_t x) { return ceil(x);  }
+Double_t f_int  (Double_t x) { return static_cast<Double_t>(static_cast<Long64_t>(x)); }
+Double_t f_sq   (Double_t x) { return x*x; }
+
+Double_t f_pow  (Double_t x, Double_t y) { return pow(x, y);   }
+Double_t f_atan2(Double_t x, Double_t y) { return atan2(x, y); }
+Double_t f_fmod (Double_t x, Double_t y) { return fmod(x, y);  }
+Double_t f_min  (Double_t x, Double_t y) { return x < y ? x : y; }
+Double_t f_max  (Double_t x, Double_t y) { return x > y ? x : y; }
+Double_t f_sign (Double_t x, Double_t y) { return TMath::Sign(x, y); }
+
+struct Function1 { const char* fName; Func1_t fFunc; };
+struct Function2 { const char* fName; Func2_t fFunc; };
+
+const Function1 kFunctions1[] = {
+	{ "sin",   f_sin   }, { "cos",   f_cos   }, { "tan",   f_tan   },
+	{ "asin",  f_asin  }, { "acos",  f_acos  }, { "atan",  f_atan  },
+	{ "sinh",  f_sinh  }, { "cosh",  f_cosh  }, { "tanh",  f_tanh  },
+	{ "asinh", f_asinh }, { "acosh", f_acosh }, { "atanh", f_atanh },
+	{ "exp",   f_exp   }, { "log",   f_log   }, { "log10", f_log10 },
+	{ "floor", f_floor }, { "ceil",  f_ceil  }, { "int",   f_int   },
+	{ "sq",    f_sq    }
+};
+const Int_t kNfunctions1 = sizeof(kFunctions1) / sizeof(kFunctions1[0]);
+
+const Function2 kFunctions2[] = {
+	{ "pow",   f_pow   }, { "power", f_pow   }, { "atan2", f_atan2 },
+	{ "fmod",  f_fmod  }, { "min",   f_min   }, { "max",   f_max   },
+	{ "sign",  f_sign  }
+};
+const Int_t kNfunctions2 = sizeof(kFunctions2) / sizeof(kFunctions2[0]);
+
+//
+// Pseudo-opcodes for short-circuit logic (expanded to jumps by the compiler)
+const Int_t kLogicalAnd = 1000;
+const Int_t kLogicalOr  = 1001;
+
+//
+// Evaluate a single (non-jump) instruction
+inline Double_t apply(Int_t op, Int_t func, Double_t x, Double_t y) {
+	switch(op) {
+	case Ex::kMove:      return x;
+	case Ex::kNeg:       return -x;
+	case Ex::kNot:       return !x;
+	case Ex::kBool:      return x != 0;
+	case Ex::kAdd:       return x + y;
+	case Ex::kSub:       return x - y;
+	case Ex::kMul:       return x * y;
+	case Ex::kDiv:       return y != 0 ? x / y : 0.;
+	case Ex::kMod:       return Long64_t(y) != 0 ? Double_t(Long64_t(x) % Long64_t(y)) : 0.;
+	case Ex::kPow:       return pow(x, y);
+	case Ex::kLess:      return x <  y;
+	case Ex::kLessEq:    return x <= y;
+	case Ex::kGreater:   return x >  y;
+	case Ex::kGreaterEq: return x >= y;
+	case Ex::kEqual:     return x == y;
+	case Ex::kNotEqual:  return x != y;
+	case Ex::kBitAnd:    return Double_t(Long64_t(x) & Long64_t(y));
+	case Ex::kBitOr:     return Double_t(Long64_t(x) | Long64_t(y));
+	case Ex::kShiftL:    return Double_t(Long64_t(x) << Long64_t(y));
+	case Ex::kShiftR:    return Double_t(Long64_t(x) >> Long64_t(y));
+	case Ex::kSqrt:      return sqrt(fabs(x));
+	case Ex::kAbs:       return fabs(x);
+	case Ex::kFunc1:     return kFunctions1[func].fFunc(x);
+	case Ex::kFunc2:     return kFunctions2[func].fFunc(x, y);
+	default:             return 0.;
+	}
+}
+
+//
+// Relative cost of an instruction, for ordering the terms of a chain
+Int_t op_cost(Int_t op) {
+	switch(op) {
+	case Ex::kPolygon: return 4;
+	case Ex::kPow:
+	case Ex::kFunc1:
+	case Ex::kFunc2:   return 3;
+	default:           return 1;
+	}
+}
+
+//
+// Orders chain terms by decisive rate per unit cost, best first
+struct TermOrder {
+	const std::vector<Ex::Term>& fTerms;
+	TermOrder(const std::vector<Ex::Term>& terms): fTerms(terms) { }
+	Double_t Score(Int_t i) const {
+		const Ex::Term& t = fTerms[i];
+		return (t.fNdecisive + 1.) / (t.fNeval + 2.) / t.fCost;
+	}
+	bool operator() (Int_t lhs, Int_t rhs) const { return Score(lhs) > Score(rhs); }
+};
+
+const char* op_name(Int_t op) {
+	static const char* names[] = {
+		"move", "neg", "not", "bool", "add", "sub", "mul", "div", "mod", "pow",
+		"lt", "le", "gt", "ge", "eq", "ne", "band", "bor", "shl", "shr", "sqrt", "abs",
+		"call1", "call2", "cut", "jz", "jnz"
+	};
+	return op >= 0 && op <= Ex::kJumpIfNot ? names[op] : "???";
+}
+
+//
+// Syntax tree node
+struct Node {
+	enum Kind_t { kConst, kVar, kOp };
+	Int_t fKind;
+	Int_t fOp;      // opcode (kOp)
+	Int_t fFunc;    // function index (kFunc1, kFunc2)
+	Int_t fVar;     // variable index (kVar)
+	Double_t fValue;// value (kConst)
+	Int_t fArg[2];  // operand nodes, fArg[1] < 0 for unary operations
+};
+
+//
+// Recursive descent parser, builds the syntax tree with constant folding
+class Parser
+{
+private:
+	const char* fPos;
+	std::vector<Node>& fNodes;
+	std::vector<std::string>& fVariables;
+	std::vector<rb::PolygonGate*>& fPolygons;
+	Int_t fDepth;
+public:
+	Parser(const char* expr, std::vector<Node>& nodes, std::vector<std::string>& variables,
+				 std::vector<rb::PolygonGate*>& polygons, Int_t depth = 0):
+		fPos(expr), fNodes(nodes), fVariables(variables), fPolygons(polygons), fDepth(depth) { }
+
+	Int_t Parse() {
+		Int_t root = LogicalOr();
+		SkipSpace();
+		if(*fPos) Fail("unexpected character");
+		return root;
+	}
+
+private:
+	void Fail(const char* what) {
+		std::string message = what;
+		message += " at \"";
+		message += fPos;
+		message += "\"";
+		throw std::invalid_argument(message);
+	}
+	void SkipSpace() { while(isspace(*fPos)) ++fPos; }
+	Bool_t Peek(const char* token) {
+		SkipSpace();
+		return strncmp(fPos, token, strlen(token)) == 0;
+	}
+	Bool_t Accept(const char* token) {
+		if(!Peek(token)) return false;
+		fPos += strlen(token);
+		return true;
+	}
+	// Accept a single-character operator that isn't the prefix of a longer one
+	Bool_t AcceptSingle(char c, const char* notFollowedBy) {
+		SkipSpace();
+		if(*fPos != c || (fPos[1] && strchr(notFollowedBy, fPos[1]))) return false;
+		++fPos;
+		return true;
+	}
+
+	Int_t Constant(Double_t value) {
+		Node node = { Node::kConst, 0, 0, 0, value, { -1, -1 } };
+		fNodes.push_back(node);
+		return fNodes.size() - 1;
+	}
+	Int_t Variable(const std::string& name) {
+		Int_t index = std::find(fVariables.begin(), fVariables.end(), name) - fVariables.begin();
+		if(index == Int_t(fVariables.size())) fVariables.push_back(name);
+		Node node = { Node::kVar, 0, 0, index, 0., { -1, -1 } };
+		fNodes.push_back(node);
+		return fNodes.size() - 1;
+	}
+	Int_t Operation(Int_t op, Int_t a, Int_t b = -1, Int_t func = 0) {
+		const Bool_t constA = fNodes[a].fKind == Node::kConst;
+		const Bool_t constB = b < 0 || fNodes[b].fKind == Node::kConst;
+		if(constA && constB && op != Ex::kPolygon) { // fold (cuts can change, never fold them)
+			Double_t x = fNodes[a].fValue, y = b < 0 ? 0. : fNodes[b].fValue;
+			if(op == kLogicalAnd) return Constant(x != 0 && y != 0);
+			if(op == kLogicalOr)  return Constant(x != 0 || y != 0);
+			return Constant(apply(op, func, x, y));
+		}
+		Node node = { Node::kOp, op, func, 0, 0., { a, b } };
+		fNodes.push_back(node);
+		return fNodes.size() - 1;
+	}
+
+	Int_t LogicalOr() {
+		Int_t lhs = LogicalAnd();
+		while(Accept("||")) lhs = Operation(kLogicalOr, lhs, LogicalAnd());
+		return lhs;
+	}
+	Int_t LogicalAnd() {
+		Int_t lhs = BitOr();
+		while(Accept("&&")) lhs = Operation(kLogicalAnd, lhs, BitOr());
+		return lhs;
+	}
+	Int_t BitOr() {
+		Int_t lhs = BitAnd();
+		while(AcceptSingle('|', "|")) lhs = Operation(Ex::kBitOr, lhs, BitAnd());
+		return lhs;
+	}
+	Int_t BitAnd() {
+		Int_t lhs = Equality();
+		while(AcceptSingle('&', "&")) lhs = Operation(Ex::kBitAnd, lhs, Equality());
+		return lhs;
+	}
+	Int_t Equality() {
+		Int_t lhs = Relational();
+		while(1) {
+			if     (Accept("==")) lhs = Operation(Ex::kEqual,    lhs, Relational());
+			else if(Accept("!=")) lhs = Operation(Ex::kNotEqual, lhs, Relational());
+			else break;
+		}
+		return lhs;
+	}
+	Int_t Relational() {
+		Int_t lhs = Shift();
+		while(1) {
+			if     (Accept("<="))            lhs = Operation(Ex::kLessEq,    lhs, Shift());
+			else if(Accept(">="))            lhs = Operation(Ex::kGreaterEq, lhs, Shift());
+			else if(AcceptSingle('<', "<"))  lhs = Operation(Ex::kLess,      lhs, Shift());
+			else if(AcceptSingle('>', ">"))  lhs = Operation(Ex::kGreater,   lhs, Shift());
+			else break;
+		}
+		return lhs;
+	}
+	Int_t Shift() {
+		Int_t lhs = Additive();
+		while(1) {
+			if     (Accept("<<")) lhs = Operation(Ex::kShiftL, lhs, Additive());
+			else if(Accept(">>")) lhs = Operation(Ex::kShiftR, lhs, Additive());
+			else break;
+		}
+		return lhs;
+	}
+	Int_t Additive() {
+		Int_t lhs = Multiplicative();
+		while(1) {
+			if     (Accept("+")) lhs = Operation(Ex::kAdd, lhs, Multiplicative());
+			else if(Accept("-")) lhs = Operation(Ex::kSub, lhs, Multiplicative());
+			else break;
+		}
+		return lhs;
+	}
+	Int_t Multiplicative() {
+		Int_t lhs = Unary();
+		while(1) {
+			if     (AcceptSingle('*', "*")) lhs = Operation(Ex::kMul, lhs, Unary());
+			else if(Accept("/"))            lhs = Operation(Ex::kDiv, lhs, Unary());
+			else if(Accept("%"))            lhs = Operation(Ex::kMod, lhs, Unary());
+			else break;
+		}
+		return lhs;
+	}
+	Int_t Unary() {
+		if(Accept("-")) return Operation(Ex::kNeg, Unary());
+		if(Accept("+")) return Unary();
+		if(AcceptSingle('!', "=")) return Operation(Ex::kNot, Unary());
+		return Power();
+	}
+	Int_t Power() {
+		Int_t base = Primary();
+		if(Accept("^") || Accept("**")) return Operation(Ex::kPow, base, Unary());
+		return base;
+	}
+	Int_t Primary() {
+		SkipSpace();
+		if(Accept("(")) {
+			Int_t inner = LogicalOr();
+			if(!Accept(")")) Fail("expected ')'");
+			return inner;
+		}
+		if(isdigit(*fPos) || (*fPos == '.' && isdigit(fPos[1]))) {
+			char* end = 0;
+			Double_t value = strtod(fPos, &end);
+			fPos = end;
+			return Constant(value);
+		}
+		if(isalpha(*fPos) || *fPos == '_') {
+			std::string name = Identifier();
+			if(Peek("(")) return Call(name);
+			if(name == "pi" || name == "TMath::Pi") return Constant(TMath::Pi());
+			if(name.find_first_of(".[:") == std::string::npos) {
+				TObject* special = gROOT->GetListOfSpecials()->FindObject(name.c_str());
+				if(special && special->InheritsFrom(TCutG::Class()))
+					return Cut(static_cast<TCutG*>(special));
+			}
+			return Variable(name);
+		}
+		Fail("unexpected character");
+		return -1;
+	}
+	// Class member or function name: a.b[1][2]->c, TMath::Abs
+	std::string Identifier() {
+		std::string name;
+		while(1) {
+			while(isalnum(*fPos) || *fPos == '_') name.push_back(*fPos++);
+			if(fPos[0] == ':' && fPos[1] == ':') {
+				name += "::"; fPos += 2;
+			}
+			else if(*fPos == '[') {
+				const char* close = strchr(fPos, ']');
+				if(!close || close == fPos + 1) Fail("bad array index");
+				for(const char* p = fPos + 1; p < close; ++p)
+					if(!isdigit(*p)) Fail("non-constant array index");
+				name.append(fPos, close + 1);
+				fPos = close + 1;
+				continue;
+			}
+			else if(fPos[0] == '.' && (isalpha(fPos[1]) || fPos[1] == '_')) {
+				name.push_back('.'); ++fPos;
+			}
+			else if(fPos[0] == '-' && fPos[1] == '>' && (isalpha(fPos[2]) || fPos[2] == '_')) {
+				name.push_back('.'); fPos += 2;
+			}
+			else break;
+		}
+		return name;
+	}
+	// Graphical cut: inline its x and y expressions, test with a PolygonGate
+	Int_t Cut(TCutG* cut) {
+		if(fDepth > 8) Fail("graphical cuts nested too deeply");
+		if(!cut->GetVarX() || !*cut->GetVarX() || !cut->GetVarY() || !*cut->GetVarY())
+			Fail("graphical cut without VarX/VarY");
+		Int_t x = Parser(cut->GetVarX(), fNodes, fVariables, fPolygons, fDepth + 1).Parse();
+		Int_t y = Parser(cut->GetVarY(), fNodes, fVariables, fPolygons, fDepth + 1).Parse();
+		fPolygons.push_back(new rb::PolygonGate(cut));
+		return Operation(Ex::kPolygon, x, y, fPolygons.size() - 1);
+	}
+	Int_t Call(std::string name) {
+		if(name.compare(0, 7, "TMath::") == 0) name = name.substr(7);
+		for(size_t i=0; i< name.size(); ++i) name[i] = tolower(name[i]);
+		Accept("(");
+		std::vector<Int_t> args;
+		if(!Accept(")")) {
+			do { args.push_back(LogicalOr()); } while(Accept(","));
+			if(!Accept(")")) Fail("expected ')'");
+		}
+		if(args.empty() && name == "pi") return Constant(TMath::Pi());
+		if(args.size() == 1) {
+			if(name == "sqrt") return Operation(Ex::kSqrt, args[0]);
+			if(name == "abs" || name == "fabs") return Operation(Ex::kAbs, args[0]);
+			for(Int_t i=0; i< kNfunctions1; ++i)
+				if(name == kFunctions1[i].fName) return Operation(Ex::kFunc1, args[0], -1, i);
+		}
+		else if(args.size() == 2) {
+			for(Int_t i=0; i< kNfunctions2; ++i)
+				if(name == kFunctions2[i].fName) return Operation(Ex::kFunc2, args[0], args[1], i);
+		}
+		Fail("unknown function");
+		return -1;
+	}
+};
+
+//
+// Flattens the syntax tree into register bytecode
+class Compiler
+{
+private:
+	const std::vector<Node>& fNodes;
+	std::vector<Ex::Instruction>& fProgram;
+	std::vector<Int_t> fConstRegister; // node -> register, for constants
+	Int_t fVarBase;
+	Int_t fNext;
+	Int_t fMax;
+public:
+	Compiler(const std::vector<Node>& nodes, std::vector<Ex::Instruction>& program):
+		fNodes(nodes), fProgram(program), fConstRegister(nodes.size(), -1), fVarBase(0), fNext(0), fMax(0) { }
+
+	// Assign constant registers, returns their values
+	std::vector<Double_t> Constants(Int_t root) {
+		std::vector<Double_t> values;
+		std::vector<Int_t> stack(1, root);
+		while(!stack.empty()) {
+			const Int_t n = stack.back(); stack.pop_back();
+			if(fNodes[n].fKind == Node::kConst) {
+				Int_t reg = std::find(values.begin(), values.end(), fNodes[n].fValue) - values.begin();
+				if(reg == Int_t(values.size())) values.push_back(fNodes[n].fValue);
+				fConstRegister[n] = reg;
+			}
+			for(Int_t i=0; i< 2; ++i) if(fNodes[n].fArg[i] >= 0) stack.push_back(fNodes[n].fArg[i]);
+		}
+		return values;
+	}
+	// Emit the program, returns the result register; temporaries start after the variables.
+	// May be called once per term of a chain, each term then gets its own block of instructions.
+	Int_t Compile(Int_t root, Int_t varBase, Int_t nvar) {
+		fVarBase = varBase;
+		fNext = varBase + nvar;
+		if(fMax < fNext) fMax = fNext;
+		return Generate(root);
+	}
+	Int_t GetNregisters() const { return fMax; }
+	// Collect the operands of a top level chain of \e op (kLogicalAnd or kLogicalOr), left to right
+	void Chain(Int_t n, Int_t op, std::vector<Int_t>& terms) const {
+		const Node& node = fNodes[n];
+		if(node.fKind == Node::kOp && node.fOp == op) {
+			Chain(node.fArg[0], op, terms);
+			Chain(node.fArg[1], op, terms);
+		}
+		else terms.push_back(n);
+	}
+
+private:
+	Int_t Emit(Int_t op, Int_t dest, Int_t a, Int_t b = -1, Int_t c = 0) {
+		Ex::Instruction ins = { op, dest, a, b < 0 ? a : b, c };
+		fProgram.push_back(ins);
+		return fProgram.size() - 1;
+	}
+	Int_t Allocate() {
+		Int_t reg = fNext++;
+		if(fNext > fMax) fMax = fNext;
+		return reg;
+	}
+	Int_t Generate(Int_t n) {
+		const Node& node = fNodes[n];
+		if(node.fKind == Node::kConst) return fConstRegister[n];
+		if(node.fKind == Node::kVar)   return fVarBase + node.fVar;
+
+		const Int_t mark = fNext;
+		if(node.fOp == kLogicalAnd || node.fOp == kLogicalOr) {
+			Int_t ra = Generate(node.fArg[0]);
+			fNext = mark;
+			Int_t dest = Allocate();
+			Emit(Ex::kBool, dest, ra);
+			Int_t jump = Emit(node.fOp == kLogicalAnd ? Ex::kJumpIfZero : Ex::kJumpIfNot, dest, dest);
+			Int_t rb = Generate(node.fArg[1]);
+			fNext = mark + 1;
+			Emit(Ex::kBool, dest, rb);
+			fProgram[jump].fB = fProgram.size();
+			return dest;
+		}
+		Int_t ra = Generate(node.fArg[0]);
+		Int_t rb = node.fArg[1] < 0 ? -1 : Generate(node.fArg[1]);
+		fNext = mark;
+		Int_t dest = Allocate();
+		Emit(node.fOp, dest, ra, rb, node.fFunc);
+		return dest;
+	}
+};
+
+} // namespace
+
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Class                                                 //
+// rb::Expression                                        //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Constructor                                           //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::Expression::Expression(const char* expression, const char* branchName, const char* className, void* classAddr,
+													 const rb::DerivedVariables* derived):
+	fSource(expression ? expression : ""), fGather(new rb::data::ReaderGather()), fNconst(0), fResult(0), fValid(false), fReentrant(true),
+	fSyncTime(0), fChainAnd(true), fAdaptCountdown(kAdaptInterval) {
+	std::string source = fSource;
+	if(source.find_first_not_of(" \t\n") == std::string::npos) source = "1";
+
+	std::vector<Node> nodes;
+	Int_t root = -1;
+	try {
+		Parser parser(source.c_str(), nodes, fVariables, fPolygons);
+		root = parser.Parse();
+	} catch (std::invalid_argument& e) {
+		fError = e.what();
+		return;
+	}
+
+	rb::data::Mapper mapper(branchName, className, reinterpret_cast<Long_t>(classAddr), kFALSE);
+	for(size_t i=0; i< fVariables.size(); ++i) {
+		const Double_t* value = derived ? derived->Find(fVariables[i].c_str()) : 0;
+		rb::data::MReader* reader = value ?
+			new rb::data::Reader<Double_t>(reinterpret_cast<Long_t>(value)) :
+			mapper.FindBasicReader(fVariables[i].c_str());
+		if(!reader) {
+			fError = "unknown variable \"" + fVariables[i] + "\"";
+			return;
+		}
+		fReaders.push_back(reader);
+		if(!reader->IsReentrant()) fReentrant = false;
+	}
+
+	Compiler compiler(nodes, fProgram);
+	std::vector<Double_t> constants = compiler.Constants(root);
+	fNconst = constants.size();
+	std::vector<Int_t> terms;
+	if(nodes[root].fKind == Node::kOp && (nodes[root].fOp == kLogicalAnd || nodes[root].fOp == kLogicalOr)) {
+		fChainAnd = nodes[root].fOp == kLogicalAnd;
+		compiler.Chain(root, nodes[root].fOp, terms);
+	}
+	if(terms.empty())
+		fResult = compiler.Compile(root, fNconst, fReaders.size());
+	for(size_t i=0; i< terms.size(); ++i) {
+		Term term = { Int_t(fProgram.size()), 0, 0, 1, 0, 0 };
+		term.fResult = compiler.Compile(terms[i], fNconst, fReaders.size());
+		term.fEnd = fProgram.size();
+		for(Int_t j = term.fBegin; j< term.fEnd; ++j) term.fCost += op_cost(fProgram[j].fOp);
+		fTerms.push_back(term);
+		fOrder.push_back(i);
+	}
+	for(size_t i=0; i< fReaders.size(); ++i) fGather->Add(fReaders[i], fNconst + i);
+	fRegisters.assign(compiler.GetNregisters() > 0 ? compiler.GetNregisters() : 1, 0.);
+	std::copy(constants.begin(), constants.end(), fRegisters.begin());
+	fValid = true;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Destructor                                            //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::Expression::~Expression() {
+	for(size_t i=0; i< fReaders.size(); ++i) delete fReaders[i];
+	for(size_t i=0; i< fPolygons.size(); ++i) delete fPolygons[i];
+	delete fGather;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Double_t rb::Expression::Eval()                       //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Double_t rb::Expression::Eval() {
+	if(!fPolygons.empty()) { // std::time() is cheap next to the lookup in Sync()
+		const std::time_t now = std::time(0);
+		if(now - fSyncTime >= PolygonGate::kSyncPeriod) {
+			fSyncTime = now;
+			for(size_t i=0; i< fPolygons.size(); ++i) fPolygons[i]->Sync();
+		}
+	}
+	if(fTerms.empty()) return Run(&fRegisters[0]);
+	if(--fAdaptCountdown <= 0) Adapt();
+	return RunAdaptive(&fRegisters[0]);
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Double_t rb::Expression::Eval() [reentrant]           //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Double_t rb::Expression::Eval(Double_t* registers) const {
+	std::copy(fRegisters.begin(), fRegisters.begin() + fNconst, registers);
+	return Run(registers);
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Double_t rb::Expression::Run()                        //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Double_t rb::Expression::Run(Double_t* const r) const {
+	fGather->Read(r);
+	if(fTerms.empty()) {
+		Exec(r, 0, fProgram.size());
+		return r[fResult];
+	}
+	for(std::vector<Int_t>::const_iterator it = fOrder.begin(); it != fOrder.end(); ++it) {
+		const Term& term = fTerms[*it];
+		Exec(r, term.fBegin, term.fEnd);
+		if((r[term.fResult] != 0) != fChainAnd) return !fChainAnd;
+	}
+	return fChainAnd;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Double_t rb::Expression::RunAdaptive()                //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Double_t rb::Expression::RunAdaptive(Double_t* const r) {
+	fGather->Read(r);
+	for(std::vector<Int_t>::const_iterator it = fOrder.begin(); it != fOrder.end(); ++it) {
+		Term& term = fTerms[*it];
+		Exec(r, term.fBegin, term.fEnd);
+		++term.fNeval;
+		if((r[term.fResult] != 0) != fChainAnd) {
+			++term.fNdecisive;
+			return !fChainAnd;
+		}
+	}
+	return fChainAnd;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::Expression::Exec()                           //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::Expression::Exec(Double_t* const r, Int_t first, Int_t last) const {
+	if(first == last) return;
+	const Instruction* const begin = &fProgram[0];
+	const Instruction* const end = begin + last;
+	for(const Instruction* ins = begin + first; ins != end; ++ins) {
+		switch(ins->fOp) {
+		case kPolygon:
+			r[ins->fDest] = fPolygons[ins->fC]->IsInside(r[ins->fA], r[ins->fB]);
+			break;
+		case kJumpIfZero:
+			if(r[ins->fA] == 0) ins = begin + ins->fB - 1;
+			break;
+		case kJumpIfNot:
+			if(r[ins->fA] != 0) ins = begin + ins->fB - 1;
+			break;
+		default:
+			r[ins->fDest] = apply(ins->fOp, ins->fC, r[ins->fA], r[ins->fB]);
+			break;
+		}
+	}
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::Expression::Adapt()                          //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::Expression::Adapt() {
+	/*!
+	 * A term's score is the (smoothed) fraction of its evaluations that decided the
+	 * chain, divided by its cost. The sort is stable, so ties keep the written order.
+	 */
+	fAdaptCountdown = kAdaptInterval;
+	std::stable_sort(fOrder.begin(), fOrder.end(), TermOrder(fTerms));
+	for(std::vector<Term>::iterator it = fTerms.begin(); it != fTerms.end(); ++it) {
+		it->fNeval /= 2;
+		it->fNdecisive /= 2;
+	}
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::Expression::Print()                          //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::Expression::Print() const {
+	std::cout << "Expression: \"" << fSource << "\"";
+	if(!fValid) {
+		std::cout << " (invalid: " << fError << ")\n";
+		return;
+	}
+	std::cout << "\n";
+	for(Int_t i=0; i< fNconst; ++i)
+		std::cout << "  r" << i << " = " << fRegisters[i] << "\n";
+	for(size_t i=0; i< fVariables.size(); ++i)
+		std::cout << "  r" << fNconst + i << " <- " << fVariables[i] << "\n";
+	char buf[256];
+	for(size_t i=0; i< fProgram.size(); ++i) {
+		const Instruction& ins = fProgram[i];
+		if(ins.fOp == kJumpIfZero || ins.fOp == kJumpIfNot)
+			sprintf(buf, "%4d  %-6s r%d, @%d", Int_t(i), op_name(ins.fOp), ins.fA, ins.fB);
+		else if(ins.fOp == kFunc1)
+			sprintf(buf, "%4d  %-6s r%d, %s(r%d)", Int_t(i), op_name(ins.fOp), ins.fDest, kFunctions1[ins.fC].fName, ins.fA);
+		else if(ins.fOp == kPolygon)
+			sprintf(buf, "%4d  %-6s r%d, %s(r%d, r%d)", Int_t(i), op_name(ins.fOp), ins.fDest, fPolygons[ins.fC]->GetName(), ins.fA, ins.fB);
+		else if(ins.fOp == kFunc2)
+			sprintf(buf, "%4d  %-6s r%d, %s(r%d, r%d)", Int_t(i), op_name(ins.fOp), ins.fDest, kFunctions2[ins.fC].fName, ins.fA, ins.fB);
+		else
+			sprintf(buf, "%4d  %-6s r%d, r%d, r%d", Int_t(i), op_name(ins.fOp), ins.fDest, ins.fA, ins.fB);
+		std::cout << buf << "\n";
+	}
+	if(fTerms.empty()) {
+		std::cout << "  result: r" << fResult << "\n";
+		return;
+	}
+	std::cout << "  " << (fChainAnd ? "&&" : "||") << " chain, in evaluation order:\n";
+	for(std::vector<Int_t>::const_iterator it = fOrder.begin(); it != fOrder.end(); ++it) {
+		const Term& term = fTerms[*it];
+		sprintf(buf, "    term %d: @%d-@%d -> r%d, cost %d, decisive %lld/%lld", *it, term.fBegin, term.fEnd,
+						term.fResult, term.fCost, term.fNdecisive, term.fNeval);
+		std::cout << buf << "\n";
+	}
+}
@@ -0,0 +1,196 @@
+//! \file Expression.hxx
+//! \brief Defines a compiled expression engine for histogram parameters and gates.
+#ifndef RB_EXPRESSION_HXX
+#define RB_EXPRESSION_HXX
+#include <ctime>
+#include <string>
+#include <vector>
+#include <Rtypes.h>
+#include "utils/nocopy.h"
+
+
+namespace rb
+{
+
+namespace data { class MReader; class ReaderGather; }
+class PolygonGate;
+class DerivedVariables;
+
+/// \brief Compiles formula expressions of class data into a compact register bytecode.
+//! \details The expression is parsed once, in the constructor, into a small syntax tree which is
+//! constant-folded and then flattened into a linear program of three-address instructions
+//! operating on a private register file. Registers are laid out as
+//! `[ constants | variables | temporaries ]`: constants are written once at compile time, and
+//! variables are filled before the program runs by an rb::data::ReaderGather, which reads straight
+//! from the data addresses in one loop per data type (no virtual call per variable). `&&` and `||`
+//! short-circuit through conditional jumps.
+//!
+//! When the whole expression is a chain of terms joined by the same operator (`a && b && c` or
+//! `a || b || c`), each term is compiled as a separate block and the chain is evaluated term by term,
+//! stopping at the first decisive one (false for `&&`, true for `||`). Since the terms have no side
+//! effects their order is free: Eval() counts how often each term is decisive, and every
+//! kAdaptInterval calls re-orders the terms by decisive rate per unit of cost, so that cheap,
+//! selective terms run first. The counts are halved at each re-ordering to follow changing data.
+//!
+//! The accepted language is the subset of TFormula syntax used in practice for parameters and gates:
+//! numbers, `pi`, class members (`a.b[2].c`, `a->b`), the unary operators `- + !`, the binary operators
+//! `^ ** * / % + - << >> < <= > >= == != & | && ||`, and the usual math functions (optionally
+//! prefixed by `TMath::`), which treat arguments out of their domain as TFormula does (e.g. `log` of
+//! x <= 0 is 0, `sqrt` takes |x|, `exp` clamps its argument to +/-700, `sign(a, b)` is TMath::Sign).
+//! The name of a TCutG in `gROOT->GetListOfSpecials()` is compiled into a
+//! native rb::PolygonGate test on the cut's VarX and VarY expressions, which are compiled inline.
+//! Other plain names are looked up in the event's rb::DerivedVariables, if one is given.
+//! Anything else (fit-function shorthands, `[n]` parameters, ...) marks the expression invalid, and
+//! the caller is expected to fall back to a more general evaluator.
+class Expression
+{
+public:
+	/// Instruction codes
+	enum Opcode_t {
+		kMove,      ///< r[dest] = r[a]
+		kNeg,       ///< r[dest] = -r[a]
+		kNot,       ///< r[dest] = !r[a]
+		kBool,      ///< r[dest] = r[a] != 0
+		kAdd,       ///< r[dest] = r[a] + r[b]
+		kSub,       ///< r[dest] = r[a] - r[b]
+		kMul,       ///< r[dest] = r[a] * r[b]
+		kDiv,       ///< r[dest] = r[a] / r[b] (0 if r[b] == 0, as TFormula)
+		kMod,       ///< r[dest] = int(r[a]) % int(r[b])
+		kPow,       ///< r[dest] = pow(r[a], r[b])
+		kLess,      ///< r[dest] = r[a] <  r[b]
+		kLessEq,    ///< r[dest] = r[a] <= r[b]
+		kGreater,   ///< r[dest] = r[a] >  r[b]
+		kGreaterEq, ///< r[dest] = r[a] >= r[b]
+		kEqual,     ///< r[dest] = r[a] == r[b]
+		kNotEqual,  ///< r[dest] = r[a] != r[b]
+		kBitAnd,    ///< r[dest] = long(r[a]) & long(r[b])
+		kBitOr,     ///< r[dest] = long(r[a]) | long(r[b])
+		kShiftL,    ///< r[dest] = long(r[a]) << long(r[b])
+		kShiftR,    ///< r[dest] = long(r[a]) >> long(r[b])
+		kSqrt,      ///< r[dest] = sqrt(r[a])
+		kAbs,       ///< r[dest] = fabs(r[a])
+		kFunc1,     ///< r[dest] = function1[c](r[a])
+		kFunc2,     ///< r[dest] = function2[c](r[a], r[b])
+		kPolygon,   ///< r[dest] = polygons[c]->IsInside(r[a], r[b])
+		kJumpIfZero,///< if(r[a] == 0) goto b
+		kJumpIfNot  ///< if(r[a] != 0) goto b
+	};
+
+	/// Number of evaluations between re-orderings of the terms of an `&&` or `||` chain
+	enum { kAdaptInterval = 1024 };
+
+	/// A single bytecode instruction
+	struct Instruction {
+		Int_t fOp;   ///< Opcode_t
+		Int_t fDest; ///< Destination register
+		Int_t fA;    ///< First operand (register)
+		Int_t fB;    ///< Second operand (register, jump target)
+		Int_t fC;    ///< Function or polygon index (kFunc1, kFunc2, kPolygon)
+	};
+
+	/// One term of an `&&` or `||` chain
+	struct Term {
+		Int_t fBegin;        ///< First instruction
+		Int_t fEnd;          ///< One past the last instruction
+		Int_t fResult;       ///< Register holding the term's value
+		Int_t fCost;         ///< Estimated cost (weighted instruction count)
+		Long64_t fNeval;     ///< Times evaluated (decayed)
+		Long64_t fNdecisive; ///< Times it decided the chain (decayed)
+	};
+
+private:
+	/// The source expression
+	std::string fSource;
+	/// Compiled program
+	std::vector<Instruction> fProgram;
+	/// Register file
+	std::vector<Double_t> fRegisters;
+	/// Readers for the class members used in the expression (owned)
+	std::vector<rb::data::MReader*> fReaders;
+	/// Reads fReaders into their registers (owned)
+	rb::data::ReaderGather* fGather;
+	/// Names of the class members corresponding to fReaders
+	std::vector<std::string> fVariables;
+	/// Native evaluators for the graphical cuts used in the expression (owned)
+	std::vector<rb::PolygonGate*> fPolygons;
+	/// Number of constant registers
+	Int_t fNconst;
+	/// Register holding the result
+	Int_t fResult;
+	/// Did compilation succeed?
+	Bool_t fValid;
+	/// Are all of fReaders reentrant? (see rb::data::MReader::IsReentrant())
+	Bool_t fReentrant;
+	/// Description of the compilation failure, if any
+	std::string fError;
+	/// Time the graphical cuts in fPolygons were last re-synchronized
+	std::time_t fSyncTime;
+	/// Terms of the top level `&&` / `||` chain (empty if the expression isn't one)
+	std::vector<Term> fTerms;
+	/// Current evaluation order of fTerms
+	std::vector<Int_t> fOrder;
+	/// Is the chain an `&&` (true) or an `||` (false)?
+	Bool_t fChainAnd;
+	/// Evaluations left before fOrder is revised
+	Int_t fAdaptCountdown;
+
+public:
+	/// \brief Compiles the expression.
+	//! \param expression The formula to compile; empty expressions evaluate to `1`.
+	//! \param branchName Name of the branch associated with the class from which to read data.
+	//! \param className Name of the class from which to read data.
+	//! \param classAddr Address of the class from which to read data.
+	//! \param derived Named derived variables the expression may refer to (optional).
+	Expression(const char* expression, const char* branchName, const char* className, void* classAddr,
+						 const rb::DerivedVariables* derived = 0);
+	/// Frees fReaders, fGather and fPolygons
+	~Expression();
+	/// Evaluates the program using the current values of the class data
+	//! \details Uses the internal register file, so this is not reentrant. Once every
+	//! rb::PolygonGate::kSyncPeriod seconds it also re-synchronizes the graphical cuts, and
+	//! every kAdaptInterval calls it re-orders the terms of an `&&` / `||` chain.
+	Double_t Eval();
+	/// \brief Reentrant evaluation using a caller-supplied register file
+	//! \details The program itself is never modified, so any number of threads may
+	//! evaluate the same expression at once, each with its own \e registers (but not
+	//! concurrently with Eval(), which may re-order the terms of a chain). This needs
+	//! IsReentrant(): otherwise calls must be serialized by the caller.
+	//! \param registers At least GetNregisters() values of scratch space
+	Double_t Eval(Double_t* registers) const;
+	/// Size of the register file needed by Eval(Double_t*)
+	Int_t GetNregisters() const { return static_cast<Int_t>(fRegisters.size()); }
+	/// Was the expression compiled successfully?
+	Bool_t IsValid() const { return fValid; }
+	/// Can Eval(Double_t*) run in several threads at once? (false if a reader caches state)
+	Bool_t IsReentrant() const { return fReentrant; }
+	/// Reason for a compilation failure
+	const char* GetError() const { return fError.c_str(); }
+	/// The source expression
+	const char* GetSource() const { return fSource.c_str(); }
+	/// Number of class members read by the program
+	Int_t GetNvar() const { return static_cast<Int_t>(fReaders.size()); }
+	/// Name of the \e i-th class member (or derived variable) read by the program
+	const char* GetVariable(Int_t i) const { return fVariables.at(i).c_str(); }
+	/// Number of bytecode instructions
+	Int_t GetNinstructions() const { return static_cast<Int_t>(fProgram.size()); }
+	/// Number of terms in the top level `&&` / `||` chain (0 if the expression isn't one)
+	Int_t GetNterms() const { return static_cast<Int_t>(fTerms.size()); }
+	/// Print a disassembly of the program
+	void Print() const;
+private:
+	/// Execute the program on register file \e r (constants already in place)
+	Double_t Run(Double_t* const r) const;
+	/// Execute the program, counting how often each term of the chain is decisive
+	Double_t RunAdaptive(Double_t* const r);
+	/// Execute instructions [\e begin, \e end) on register file \e r
+	void Exec(Double_t* const r, Int_t begin, Int_t end) const;
+	/// Re-order fTerms by decisive rate per unit cost and decay the counts
+	void Adapt();
+
+	RB_NOCOPY(Expression);
+};
+
+} // namespace rb
+
+
+#endif
@@ -1,11 +1,15 @@
 //! \file Formula.cxx
 //! \brief Implements Formula.hxx
+#include <cctype>
 #include <cassert>
+#include <algorithm>
+#include <memory>
 #include <vector>
 #include <sstream>
 #include <stdexcept>
 #include <TTree.h>
 #include <TString.h>
+#include <TStopwatch.h>
 #include <TTreeFormula.h>
 #include "Formula.hxx"
 #include "Rint.hxx"
@@ -74,6 +78,9 @@ rb::ConstantDataFormula::ConstantDataFormula(const char* formula):
 	}
 }
 
+namespace rb { TMutex gFormulaMutex; }
+
+
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // Class                                                 //
 // rb::TTreeDataFormula                                  //
@@ -90,6 +97,66 @@ rb::TTreeDataFormula::TTreeDataFormula(const char* name, const char* formula, TT
 }
 
 
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Class                                                 //
+// rb::FormulaCache                                      //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Constructor (rb::FormulaCache::Entry)                 //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::FormulaCache::Entry::Entry(rb::Event* event, const std::string& expression, Int_t id):
+	fExpression(expression),
+	fFormula(rb::Event::InitFormula::Operate(event, expression.c_str())),
+	fValue(0.), fGeneration(0), fId(id) { }
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// std::string rb::FormulaCache::Normalize()             //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+std::string rb::FormulaCache::Normalize(const char* expression) {
+	std::string out;
+	for(const char* p = expression; p && *p; ++p) {
+		if(isspace(*p)) continue;
+		if(p[0] == '-' && p[1] == '>') { out.push_back('.'); ++p; continue; }
+		out.push_back(*p);
+	}
+	return out;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::FormulaCache::Get()                               //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::FormulaCache::EntryPtr_t rb::FormulaCache::Get(rb::Event* event, const char* expression) {
+	/*!
+	 * Entries no longer referenced by any CachedDataFormula are kept for reuse, and
+	 * removed (all at once) when the cache has grown to fPurgeAt entries.
+	 */
+	if(fEntries.size() >= fPurgeAt) Purge();
+	const std::string key = Normalize(expression);
+	EntryPtr_t& entry = fEntries[key];
+	if(entry.get() && entry.unique() && entry->fFormula->IsZombie()) entry.reset(); // try again
+	if(!entry.get()) entry.reset(new Entry(event, key, fNextId++));
+	return entry;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::FormulaCache::Purge()                        //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::FormulaCache::Purge() {
+	for(std::map<std::string, EntryPtr_t>::iterator it = fEntries.begin(); it != fEntries.end(); ) {
+		if(it->second.unique()) fEntries.erase(it++);
+		else ++it;
+	}
+	fPurgeAt = std::max(size_t(kMinPurge), 2*fEntries.size());
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Int_t rb::FormulaCache::GetNentries()                 //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Int_t rb::FormulaCache::GetNentries() {
+	Int_t n = 0;
+	for(std::map<std::string, EntryPtr_t>::iterator it = fEntries.begin(); it != fEntries.end(); ++it)
+		if(!it->second.unique()) ++n;
+	return n;
+}
+
+
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // Class                                                 //
 // rb::TreeFormulae                                      //
@@ -106,11 +173,12 @@ rb::TreeFormulae::TreeFormulae(std::vector<std::string>& params, Int_t event_cod
   for(it = params.begin(); it != params.end(); ++it) {
     modify_formula_arg(*it);
     fFormulaArgs.push_back(*it);
-    rb::DataFormula* formula = 
-      rb::Event::InitFormula::Operate(rb::Rint::gApp()->GetEvent(kEventCode), it->c_str());
+    rb::Event* event = rb::Rint::gApp()->GetEvent(kEventCode);
+    std::auto_ptr<rb::DataFormula> formula
+      (new rb::CachedDataFormula(event->GetFormulaCache(), event->GetFormulaCache()->Get(event, it->c_str())));
 
     if(formula->IsZombie()) ThrowBad(it->c_str(), it-params.begin());
-    else fDataFormulae->push_back(formula);
+    else fDataFormulae->push_back(formula.release());
   }
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
@@ -130,16 +198,17 @@ Bool_t rb::TreeFormulae::Change(Int_t index, std::string new_formula) {
   // Modify formula if necessary
   modify_formula_arg(new_formula);
 
-  // check that new gate formula is valid
-  boost::scoped_ptr<rb::DataFormula>
-    temp (rb::Event::InitFormula::Operate(rb::Rint::gApp()->GetEvent(kEventCode), new_formula.c_str()));
+  // get the new formula from the cache (compiling it only if it isn't there), check it's valid
+  RB_LOCKGUARD(gDataMutex);
+  rb::Event* event = rb::Rint::gApp()->GetEvent(kEventCode);
+  std::auto_ptr<rb::DataFormula> formula
+    (new rb::CachedDataFormula(event->GetFormulaCache(), event->GetFormulaCache()->Get(event, new_formula.c_str())));
 
-  if(temp->IsZombie())
+  if(formula->IsZombie())
     return false;
   else {
     try {
-      RB_LOCKGUARD(gDataMutex);
-      fDataFormulae->replace(index, rb::Event::InitFormula::Operate(rb::Rint::gApp()->GetEvent(kEventCode), new_formula.c_str()));
+      fDataFormulae->replace(index, formula.release());
       fFormulaArgs.at(index) = new_formula;
     } catch(std::exception& e) {
       rb::err::Error("rb::TreeFormulae::Change()") << "Invalid index " << index;
@@ -158,6 +227,41 @@ std::string rb::TreeFormulae::Get(Int_t index) {
   return fFormulaArgs[index];
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::FormulaProfile rb::TreeFormulae::Profile()        //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::FormulaProfile rb::TreeFormulae::Profile(Int_t index, Int_t nloops) {
+  /*!
+   * Shared formulae are timed directly (not through the per-event memo), on the
+   * data of the most recent event. Compiled expressions are run on a scratch register
+   * file (Expression::Eval(Double_t*)), so profiling doesn't count towards the adaptive
+   * term order or the graphical cut synchronization of the live evaluation.
+   */
+  rb::FormulaProfile profile;
+  profile.fFormula = Get(index);
+  profile.fNsPerEval = 0.;
+  RB_LOCKGUARD(gDataMutex);
+  if(index < 0 || index >= Int_t(fDataFormulae->size())) {
+    rb::err::Error("rb::TreeFormulae::Profile") << "Invalid index " << index;
+    return profile;
+  }
+  rb::DataFormula* formula = (*fDataFormulae)[index].GetShared();
+  profile.fBackend = formula->GetBackend();
+  profile.fDiagnostics = formula->GetDiagnostics();
+  if(nloops > 0) {
+    volatile Double_t sink = 0.;
+    rb::ExpressionDataFormula* compiled = dynamic_cast<rb::ExpressionDataFormula*>(formula);
+    std::vector<Double_t> registers(compiled ? compiled->GetExpression().GetNregisters() : 0);
+    TStopwatch watch;
+    if(compiled)
+      for(Int_t i=0; i< nloops; ++i) sink = compiled->GetExpression().Eval(registers.empty() ? 0 : &registers[0]);
+    else
+      for(Int_t i=0; i< nloops; ++i) sink = formula->Evaluate();
+    watch.Stop();
+    profile.fNsPerEval = 1e9 * watch.RealTime() / nloops;
+  }
+  return profile;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // Double_t rb::TreeFormulae::Eval()                     //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 Double_t rb::TreeFormulae::Eval(Int_t index) {
@@ -192,3 +296,22 @@ void rb::TreeFormulae::EvalAllUnlocked(std::vector<Double_t>& out) {
   for(it = fDataFormulae->begin(); it != fDataFormulae->end(); ++it)
     out.push_back(it->Evaluate());
 }
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Double_t rb::TreeFormulae::EvalUnlocked(context)      //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Double_t rb::TreeFormulae::EvalUnlocked(Int_t index, rb::FormulaContext& context) {
+  if(index < 0 || index >= Int_t(fDataFormulae->size())) {
+    rb::err::Error("rb::TreeFormulae::Eval") << "Invalid index " << index;
+    return -1;
+  }
+  return (*fDataFormulae)[index].EvaluateIn(context);
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::TreeFormulae::EvalAllUnlocked(context)       //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::TreeFormulae::EvalAllUnlocked(std::vector<Double_t>& out, rb::FormulaContext& context) {
+  boost::ptr_vector<rb::DataFormula>::iterator it;
+  out.clear();
+  for(it = fDataFormulae->begin(); it != fDataFormulae->end(); ++it)
+    out.push_back(it->EvaluateIn(context));
+}
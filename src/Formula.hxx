@@ -2,11 +2,17 @@
 //! \brief Defines a thread safe wrapper class for TTreeFormulas.
 #ifndef FORMULA_HXX
 #define FORMULA_HXX
+#include <map>
+#include <deque>
 #include <string>
+#include <vector>
 #include "utils/boost_scoped_ptr.h"
+#include "utils/boost_shared_ptr.h"
 #include "utils/boost_ptr_vector.h"
 #include "utils/Critical.hxx"
+#include "utils/Mutex.hxx"
 #include "ClassFormula.hxx"
+#include "Expression.hxx"
 
 
 // =========== Forward Declarations =========== //
@@ -21,27 +27,112 @@ namespace rb
 {
 // =========== Forward Declarations =========== //
 namespace data { class MReader; }
+class Event;
+
+/// \brief Serializes evaluation of the non-reentrant backends (TTreeFormula, ClassFormula)
+//! \details A plain TMutex rather than an rb::Mutex, whose locking is compiled out.
+extern TMutex gFormulaMutex;
 
 // =========== Class Definitions ============ //
 
+/// \brief Per-thread mutable state for evaluating DataFormulae.
+//! \details DataFormula::EvaluateIn() keeps everything it needs to write during an evaluation
+//! (expression registers, memoized per-event values) in the context rather than in the formula
+//! objects. Any number of threads may therefore evaluate the same formulae concurrently, as long
+//! as each uses its own context and the event data isn't changing underneath them. Formulae backed
+//! by TTreeFormula or ClassFormula, or reading node based containers (rb::data::NodeReader), keep
+//! state internally; their EvaluateIn() holds gFormulaMutex, so those evaluations are serialized
+//! while the others run in parallel.
+//! \attention Contexts must not be used while another thread calls plain Evaluate() on the same
+//! formulae (the compiled engine's Eval() re-orders terms and re-syncs cuts in place).
+class FormulaContext
+{
+public:
+	/// Memoized value of a shared rb::FormulaCache entry
+	struct Memo {
+		/// Event generation of fValue
+		ULong64_t fGeneration;
+		/// Memoized value
+		Double_t fValue;
+	};
+private:
+	/// Register frames, one per nesting level (deque so outer frames never move)
+	std::deque<std::vector<Double_t> > fFrames;
+	/// Current nesting level
+	Int_t fDepth;
+	/// Memoized values, indexed by FormulaCache::Entry::fId
+	std::vector<Memo> fMemo;
+public:
+	/// Empty context
+	FormulaContext(): fFrames(), fDepth(0), fMemo() { }
+	/// \brief Reserve a register frame of at least \e n values for the next nesting level
+	Double_t* PushFrame(Int_t n) {
+		if(Int_t(fFrames.size()) <= fDepth) fFrames.resize(fDepth + 1);
+		std::vector<Double_t>& frame = fFrames[fDepth++];
+		if(Int_t(frame.size()) < n) frame.resize(n);
+		return frame.empty() ? 0 : &frame[0];
+	}
+	/// \brief Release the frame reserved by the matching PushFrame()
+	void PopFrame() { --fDepth; }
+	/// \brief Return the memo slot for cache entry \e id
+	Memo& GetMemo(Int_t id) {
+		if(Int_t(fMemo.size()) <= id) {
+			Memo empty = { 0, 0. };
+			fMemo.resize(id + 1, empty);
+		}
+		return fMemo[id];
+	}
+};
+
 /// \brief abstract class for accessing class data via a string.
 //! \details This provides a very basic interface for accessing
 //! event-by-event data from a class which is known to ROOT (i.e. has a dictionary).
 //! Derived classes decide exactly how to access the data (e.g. directly vs. using TTReeFormula).
 class DataFormula
 {
+private:
+	/// \brief Why faster implementations were passed over (set by rb::Event::InitFormula)
+	std::string fDiagnostics;
 public:
 	/// \brief Empty constructor.
-	DataFormula() { }
+	DataFormula(): fDiagnostics() { }
 	/// \brief Empty (virtual) destructor.
 	virtual ~DataFormula() { }
 	/// \brief Evaluates the current state of the formula data.
 	virtual Double_t Evaluate() = 0;
+	/// \brief Reentrant version of Evaluate(), all scratch state is kept in \e context.
+	//! \details The default is fine for formulae that only read data; formulae with internal
+	//! mutable state override this.
+	virtual Double_t EvaluateIn(FormulaContext& context) { return Evaluate(); }
 	/// \brief Tells if the current object is in a "zombie" (invalid) state.
 	/// \attention In general, the Evaluate() function will do no checking for validity of the
 	/// internal components. Ths IsZombie() function should provide all needed checks and be
 	/// called by the user before evaluating.
 	virtual Bool_t IsZombie() = 0;
+	/// \brief Short name of the evaluation method, for diagnostics.
+	virtual const char* GetBackend() const { return "custom"; }
+	/// \brief The formula doing the actual work (differs from \c this for shared formulae).
+	virtual DataFormula* GetShared() { return this; }
+	/// \brief Returns fDiagnostics
+	const std::string& GetDiagnostics() const { return fDiagnostics; }
+	/// \brief Sets fDiagnostics
+	void SetDiagnostics(const std::string& diagnostics) { fDiagnostics = diagnostics; }
+};
+
+/// \brief Cost and evaluation method of a histogram formula, see rb::hist::PrintFormulaReport().
+struct FormulaProfile {
+	/// Name of the histogram using the formula
+	std::string fOwner;
+	/// What the formula is used for ("param 0", "gate", ...)
+	std::string fRole;
+	/// The formula
+	std::string fFormula;
+	/// DataFormula::GetBackend() of the formula
+	std::string fBackend;
+	/// DataFormula::GetDiagnostics() of the formula
+	std::string fDiagnostics;
+	/// Measured evaluation time, in nanoseconds
+	Double_t fNsPerEval;
 };
 
 /// \brief Derived class of DataFormula making use of ROOT's TTreeFormula to evaluate the data.
@@ -59,8 +150,15 @@ public:
 	TTreeDataFormula(const char* name, const char* formula, TTree* tree);
 	/// \brief Calls fFormula->EvalInstance(0)
 	virtual Double_t Evaluate() { return fTTreeFormula->EvalInstance(0); }
+	/// \brief Calls Evaluate() holding gFormulaMutex, TTreeFormula isn't reentrant
+	virtual Double_t EvaluateIn(FormulaContext&) {
+		rb::ScopedLock<TMutex> lock(gFormulaMutex);
+		return Evaluate();
+	}
 	/// \brief Returns true if GetNdim() == 0
 	virtual Bool_t IsZombie() { return fTTreeFormula->GetNdim() == 0; }
+	/// \brief Returns "TTreeFormula"
+	virtual const char* GetBackend() const { return "TTreeFormula"; }
 };
 
 /// \brief Derived class of DataFormula making use of our rb::data::Mapper functionality.
@@ -82,8 +180,16 @@ public:
 	virtual ~DirectDataFormula();
 	/// \brief Calls fReader->ReadValue();
 	virtual Double_t Evaluate();
+	/// \brief Calls Evaluate(), holding gFormulaMutex if fReader isn't reentrant
+	virtual Double_t EvaluateIn(FormulaContext&) {
+		if(fReader->IsReentrant()) return Evaluate();
+		rb::ScopedLock<TMutex> lock(gFormulaMutex);
+		return Evaluate();
+	}
 	/// \brief Returns true if fReader == 0
 	virtual Bool_t IsZombie() { return fReader == 0; }
+	/// \brief Returns "direct"
+	virtual const char* GetBackend() const { return "direct"; }
 };
 
 /// \brief Derived class of DataFormula evaluating a constant
@@ -104,6 +210,45 @@ public:
 	virtual Double_t Evaluate() { return fValue; }
 	/// \brief Returns true if fIsFormulaConstant == false
 	virtual Bool_t IsZombie() { return fIsFormulaConstant == false; }
+	/// \brief Returns "constant"
+	virtual const char* GetBackend() const { return "constant"; }
+};
+
+/// \brief DataFormula class using the compiled rb::Expression engine
+//! \details This is the preferred implementation for anything more than a single
+//! data member: the expression is compiled once to register bytecode and evaluated
+//! without going through TFormula.
+class ExpressionDataFormula : public DataFormula
+{
+private:
+	/// The compiled expression
+	Expression fExpression;
+public:
+	/// \brief Compiles the expression, see rb::Expression::Expression()
+	ExpressionDataFormula(const char* formula, const char* branchName, const char* className, void* classAddr,
+												const DerivedVariables* derived = 0):
+		fExpression(formula, branchName, className, classAddr, derived) { }
+	/// \brief Runs the compiled program
+	virtual Double_t Evaluate() { return fExpression.Eval(); }
+	/// \brief Runs the compiled program on a register frame from \e context
+	//! \details Holds gFormulaMutex if the expression's readers aren't reentrant.
+	virtual Double_t EvaluateIn(FormulaContext& context) {
+		Double_t* frame = context.PushFrame(fExpression.GetNregisters());
+		Double_t value;
+		if(fExpression.IsReentrant()) value = fExpression.Eval(frame);
+		else {
+			rb::ScopedLock<TMutex> lock(gFormulaMutex);
+			value = fExpression.Eval(frame);
+		}
+		context.PopFrame();
+		return value;
+	}
+	/// \brief Returns true if the expression could not be compiled
+	virtual Bool_t IsZombie() { return !fExpression.IsValid(); }
+	/// \brief Returns "compiled"
+	virtual const char* GetBackend() const { return "compiled"; }
+	/// \brief Returns the compiled expression
+	const Expression& GetExpression() const { return fExpression; }
 };
 
 /// \brief DataFormula class using rb::ClassFormula
@@ -117,7 +262,113 @@ public:
 	ClassDataFormula(const char* name, const char* formula, const char* branchName, const char* className, void* classAddr):
 		fClassFormula(name,formula,branchName,className,classAddr) { }
 	virtual Double_t Evaluate() { return fClassFormula.Eval(); }
+	/// \brief Calls Evaluate() holding gFormulaMutex, ClassFormula isn't reentrant
+	virtual Double_t EvaluateIn(FormulaContext&) {
+		rb::ScopedLock<TMutex> lock(gFormulaMutex);
+		return Evaluate();
+	}
 	virtual Bool_t IsZombie() { return !fClassFormula.GetNdim(); }
+	virtual const char* GetBackend() const { return "ClassFormula"; }
+};
+
+
+/// \brief Per-event registry of formulae shared between histograms.
+//! \details Each distinct (normalized) expression used by an event's histograms, gates or save
+//! columns is created once and evaluated at most once per event: the first evaluation after
+//! NextEvent() computes and stores the value, later ones return the stored value. Entries are
+//! reference counted by the CachedDataFormula handles pointing to them. Unused entries are kept, so
+//! that histograms re-created with the same expressions (loading a configuration, changing a gate
+//! back and forth, ...) reuse the compiled formula instead of parsing it again; they are dropped
+//! in bulk once they make up half of the cache. Unused entries that failed to compile are retried,
+//! as the cut or derived variable they lacked may exist now.
+//! \attention Not locked internally, all access should be done while holding gDataMutex.
+class FormulaCache
+{
+public:
+	/// Minimum number of entries before unused ones are dropped
+	enum { kMinPurge = 256 };
+	/// A shared formula and its memoized value
+	struct Entry {
+		/// Normalized expression
+		std::string fExpression;
+		/// Formula doing the actual evaluation
+		boost::scoped_ptr<DataFormula> fFormula;
+		/// Value at the last evaluation
+		Double_t fValue;
+		/// Event generation of fValue
+		ULong64_t fGeneration;
+		/// Unique index, used to find the entry's FormulaContext::Memo
+		Int_t fId;
+		/// Create the formula via rb::Event::InitFormula
+		Entry(rb::Event* event, const std::string& expression, Int_t id);
+	};
+	typedef boost::shared_ptr<Entry> EntryPtr_t;
+private:
+	/// Map of normalized expression -> entry
+	std::map<std::string, EntryPtr_t> fEntries;
+	/// Event counter, incremented by NextEvent()
+	ULong64_t fGeneration;
+	/// Id for the next new entry
+	Int_t fNextId;
+	/// Size of fEntries at which unused entries are dropped
+	size_t fPurgeAt;
+public:
+	/// Starts at generation 1 (entries start at 0, i.e. stale)
+	FormulaCache(): fEntries(), fGeneration(1), fNextId(0), fPurgeAt(kMinPurge) { }
+	/// \brief Return the shared entry for \e expression, creating it if needed
+	//! \param event Event used to create new formulae
+	//! \param expression The formula expression
+	EntryPtr_t Get(rb::Event* event, const char* expression);
+	/// Invalidate all memoized values, to be called once per event before any evaluation
+	void NextEvent() { ++fGeneration; }
+	/// Return the value of \e entry for the current event, evaluating if needed
+	Double_t Evaluate(Entry& entry) {
+		if(entry.fGeneration != fGeneration) {
+			entry.fValue = entry.fFormula->Evaluate();
+			entry.fGeneration = fGeneration;
+		}
+		return entry.fValue;
+	}
+	/// Reentrant version of Evaluate(), memoizing in \e context instead of \e entry
+	Double_t Evaluate(Entry& entry, FormulaContext& context) {
+		FormulaContext::Memo& memo = context.GetMemo(entry.fId);
+		if(memo.fGeneration != fGeneration) {
+			memo.fValue = entry.fFormula->EvaluateIn(context);
+			memo.fGeneration = fGeneration;
+		}
+		return memo.fValue;
+	}
+	/// Number of distinct expressions currently in use
+	Int_t GetNentries();
+	/// Strip whitespace and convert \c -> to \c . so equivalent spellings share an entry
+	static std::string Normalize(const char* expression);
+private:
+	/// Drop the entries no CachedDataFormula refers to, and set fPurgeAt
+	void Purge();
+};
+
+/// \brief DataFormula handle to a shared rb::FormulaCache entry
+class CachedDataFormula : public DataFormula
+{
+private:
+	/// Cache owning the memoized value
+	FormulaCache* fCache;
+	/// The shared entry
+	FormulaCache::EntryPtr_t fEntry;
+public:
+	/// Sets fCache, fEntry
+	CachedDataFormula(FormulaCache* cache, FormulaCache::EntryPtr_t entry):
+		fCache(cache), fEntry(entry) { }
+	/// \brief Returns the memoized value for the current event
+	virtual Double_t Evaluate() { return fCache->Evaluate(*fEntry); }
+	/// \brief Returns the value memoized in \e context for the current event
+	virtual Double_t EvaluateIn(FormulaContext& context) { return fCache->Evaluate(*fEntry, context); }
+	/// \brief Returns true if the shared formula is a zombie
+	virtual Bool_t IsZombie() { return fEntry->fFormula->IsZombie(); }
+	/// \brief Returns the backend of the shared formula
+	virtual const char* GetBackend() const { return fEntry->fFormula->GetBackend(); }
+	/// \brief Returns the shared formula
+	virtual DataFormula* GetShared() { return fEntry->fFormula.get(); }
 };
 
 
@@ -137,7 +388,13 @@ public:
 	Double_t EvalUnlocked(Int_t index);
 	void EvalAll(std::vector<Double_t>& out);
 	void EvalAllUnlocked(std::vector<Double_t>& out);
+	/// Reentrant evaluation, for use from worker threads (each with its own \e context)
+	Double_t EvalUnlocked(Int_t index, FormulaContext& context);
+	/// Reentrant evaluation, for use from worker threads (each with its own \e context)
+	void EvalAllUnlocked(std::vector<Double_t>& out, FormulaContext& context);
 	Bool_t Change(Int_t index, std::string new_formula);
+	/// Time \e nloops evaluations of formula \e index, and describe how it is evaluated
+	FormulaProfile Profile(Int_t index, Int_t nloops);
 private:
 	void ThrowBad(const char* formula, Int_t index);
 	TreeFormulae(const TreeFormulae& other): kEventCode(-1001), fDataFormulae(0, gDataMutex) {}
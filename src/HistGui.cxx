@@ -710,6 +710,17 @@ void TGHistVarFrame::HistGuiLayout()
 	fCompositeFrame717->AddFrame(fMkdirButton, new TGLayoutHints(kLHintsLeft | kLHintsTop,2,2,2,2));
 	fMkdirButton->MoveResize(230,361,96,22);
 
+	/* TGTextButton* */ fFormulaReportButton = new TGTextButton(fCompositeFrame717,"Formula Report");
+	fFormulaReportButton->SetFont(ufont->GetFontStruct());
+	fFormulaReportButton->SetTextJustify(36);
+	fFormulaReportButton->SetMargins(0,0,0,0);
+	fFormulaReportButton->SetWrapLength(-1);
+	fFormulaReportButton->Resize(96,22);
+
+	fFormulaReportButton->ChangeBackground(ucolor);
+	fCompositeFrame717->AddFrame(fFormulaReportButton, new TGLayoutHints(kLHintsLeft | kLHintsTop,2,2,2,2));
+	fFormulaReportButton->MoveResize(330,361,96,22);
+
 
 	// graphics context changes
 	GCValues_t vall855;
@@ -1100,6 +1111,7 @@ void TGHistVarFrame::MakeHistConnections() {
 	fCommandOk->Connect("Pressed()", "rb::HistSignals", RB_HIST_SIGNALS, "HistMemberFn()");
 	fCommandEntry->Connect("ReturnPressed()", "rb::HistSignals", RB_HIST_SIGNALS, "HistMemberFn()");
 	fMkdirButton->Connect("Pressed()",  "rb::HistSignals", RB_HIST_SIGNALS, "Mkdir()");
+	fFormulaReportButton->Connect("Pressed()",  "rb::HistSignals", RB_HIST_SIGNALS, "FormulaReport()");
 	fHistRegateButton->Connect("Pressed()", "rb::HistSignals", RB_HIST_SIGNALS, "RegateHist()");
 	fHistReplaceButton->Connect("Pressed()", "rb::HistSignals", RB_HIST_SIGNALS, "ToggleCreateReplace()");
 
@@ -1220,6 +1232,7 @@ void TGHistVarFrame::DeleteMembers() {
 	delete fHistLoadButton;
 	delete fDrawOptionEntry;
 	delete fMkdirButton;
+	delete fFormulaReportButton;
 	delete fDrawOptionLabel;
 	delete fVariablesFrame;
 	delete fVariablesCanvas;
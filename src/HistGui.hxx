@@ -204,6 +204,7 @@ protected:
 	TGTextButton *fHistLoadButton; // "Load"
 	TGTextEntry *fDrawOptionEntry;
 	TGTextButton *fMkdirButton; // "New Directory"
+	TGTextButton *fFormulaReportButton; // "Formula Report"
 	TGLabel *fDrawOptionLabel; // "Draw option:"
 	TGGroupFrame *fVariablesFrame; // "Variables"
 	TGCanvas *fVariablesCanvas;
@@ -0,0 +1,122 @@
+//! \file PolygonGate.cxx
+//! \brief Implements PolygonGate.hxx
+#include <algorithm>
+#include <TROOT.h>
+#include <TCutG.h>
+#include <TList.h>
+#include "PolygonGate.hxx"
+
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Helper Functions                                      //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+namespace {
+//
+// Does the segment (x1,y1)-(x2,y2) touch the closed rectangle [rx0,rx1]x[ry0,ry1]?
+bool segment_hits_rect(Double_t x1, Double_t y1, Double_t x2, Double_t y2,
+											 Double_t rx0, Double_t ry0, Double_t rx1, Double_t ry1) {
+	if(std::max(x1, x2) < rx0 || std::min(x1, x2) > rx1) return false;
+	if(std::max(y1, y2) < ry0 || std::min(y1, y2) > ry1) return false;
+	const Double_t dx = x2 - x1, dy = y2 - y1;
+	const Double_t cx[4] = { rx0, rx1, rx1, rx0 };
+	const Double_t cy[4] = { ry0, ry0, ry1, ry1 };
+	Int_t above = 0, below = 0;
+	for(Int_t i=0; i< 4; ++i) {
+		const Double_t side = dx*(cy[i] - y1) - dy*(cx[i] - x1);
+		if(side > 0) ++above;
+		else if(side < 0) ++below;
+		else return true;
+	}
+	return above && below; // corners on both sides of the line
+} }
+
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Constructor                                           //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::PolygonGate::PolygonGate(const TCutG* cut):
+	fName(cut->GetName()) {
+	SetPoints(cut->GetN(), cut->GetX(), cut->GetY());
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Bool_t rb::PolygonGate::IsInsideExact()               //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Bool_t rb::PolygonGate::IsInsideExact(Double_t xp, Double_t yp) const {
+	const Int_t np = fX.size();
+	Bool_t oddNodes = kFALSE;
+	for(Int_t i=0, j = np-1; i< np; j = i++) {
+		if((fY[i] < yp && fY[j] >= yp) || (fY[j] < yp && fY[i] >= yp)) {
+			if(fX[i] + (yp - fY[i]) / (fY[j] - fY[i]) * (fX[j] - fX[i]) < xp)
+				oddNodes = !oddNodes;
+		}
+	}
+	return oddNodes;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::PolygonGate::SetPoints()                     //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::PolygonGate::SetPoints(Int_t n, const Double_t* x, const Double_t* y) {
+	fX.assign(x, x + n);
+	fY.assign(y, y + n);
+	BuildGrid();
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::PolygonGate::BuildGrid()                     //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::PolygonGate::BuildGrid() {
+	fGrid.assign(kGridSize*kGridSize, kOutside);
+	if(fX.empty()) { // nothing is inside, make the bounding box empty
+		fXmin = fYmin = 1; fXmax = fYmax = -1;
+		fInvDx = fInvDy = 0;
+		return;
+	}
+	fXmin = *std::min_element(fX.begin(), fX.end());
+	fXmax = *std::max_element(fX.begin(), fX.end());
+	fYmin = *std::min_element(fY.begin(), fY.end());
+	fYmax = *std::max_element(fY.begin(), fY.end());
+	const Double_t dx = (fXmax - fXmin) / kGridSize, dy = (fYmax - fYmin) / kGridSize;
+	fInvDx = dx > 0 ? 1. / dx : 0;
+	fInvDy = dy > 0 ? 1. / dy : 0;
+
+	// cells are widened slightly so rounding in IsInside() can never pick a
+	// "pure" cell for a point that is really on an edge
+	const Double_t padx = 1e-6*dx, pady = 1e-6*dy;
+	const Int_t np = fX.size();
+	for(Int_t iy = 0; iy < kGridSize; ++iy) {
+		const Double_t y0 = fYmin + iy*dy - pady, y1 = fYmin + (iy+1)*dy + pady;
+		for(Int_t ix = 0; ix < kGridSize; ++ix) {
+			const Double_t x0 = fXmin + ix*dx - padx, x1 = fXmin + (ix+1)*dx + padx;
+			UChar_t& cell = fGrid[iy*kGridSize + ix];
+			for(Int_t i=0, j = np-1; i< np; j = i++) {
+				if(segment_hits_rect(fX[j], fY[j], fX[i], fY[i], x0, y0, x1, y1)) {
+					cell = kBoundary;
+					break;
+				}
+			}
+			if(cell != kBoundary)
+				cell = IsInsideExact(0.5*(x0 + x1), 0.5*(y0 + y1)) ? kInside : kOutside;
+		}
+	}
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::PolygonGate::Sync()                          //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::PolygonGate::Sync() {
+	/*!
+	 * If the cut was deleted, the last known shape stays in use.
+	 */
+	TObject* obj = gROOT->GetListOfSpecials()->FindObject(fName.c_str());
+	if(!obj || !obj->InheritsFrom(TCutG::Class())) return;
+	TCutG* cut = static_cast<TCutG*>(obj);
+	const Int_t n = cut->GetN();
+	if(n == Int_t(fX.size()) &&
+		 std::equal(fX.begin(), fX.end(), cut->GetX()) &&
+		 std::equal(fY.begin(), fY.end(), cut->GetY())) return;
+	SetPoints(n, cut->GetX(), cut->GetY());
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Double_t rb::PolygonGate::GetBoundaryFraction()       //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Double_t rb::PolygonGate::GetBoundaryFraction() const {
+	return std::count(fGrid.begin(), fGrid.end(), UChar_t(kBoundary)) / Double_t(fGrid.size());
+}
@@ -0,0 +1,80 @@
+//! \file PolygonGate.hxx
+//! \brief Defines a fast native evaluator for graphical (TCutG) cuts.
+#ifndef RB_POLYGON_GATE_HXX
+#define RB_POLYGON_GATE_HXX
+#include <string>
+#include <vector>
+#include <Rtypes.h>
+
+
+class TCutG;
+
+namespace rb
+{
+
+/// \brief Native 2D polygon gate, equivalent to TCutG::IsInside().
+//! \details The polygon is rasterized onto a kGridSize x kGridSize grid covering its bounding
+//! box. Every grid cell not touched by a polygon edge is entirely inside or entirely outside,
+//! and is classified once; only points falling into cells crossed by an edge need the exact
+//! (crossing number) test. Points outside the bounding box are rejected with four comparisons.
+//!
+//! The gate keeps a copy of the cut's points. To follow graphical edits of the original cut,
+//! Sync() re-reads the TCutG (found by name in `gROOT->GetListOfSpecials()`) and rebuilds the
+//! grid if the points changed. IsInside() never modifies the gate, so it may be called from
+//! several threads at once; Sync() must be called from a serial point by the owner (rb::Expression
+//! does so from its single-threaded evaluation at most once every kSyncPeriod seconds, so an
+//! edited cut takes effect within about a second whatever the event rate).
+class PolygonGate
+{
+public:
+	/// Grid resolution, and seconds between checks of the original cut
+	enum { kGridSize = 64, kSyncPeriod = 1 };
+	/// Grid cell classification
+	enum Cell_t { kOutside = 0, kInside = 1, kBoundary = 2 };
+private:
+	/// Name of the original TCutG
+	std::string fName;
+	/// Polygon vertices
+	std::vector<Double_t> fX, fY;
+	/// Bounding box
+	Double_t fXmin, fXmax, fYmin, fYmax;
+	/// Inverse grid cell sizes
+	Double_t fInvDx, fInvDy;
+	/// Cell classifications (Cell_t), row major in y
+	std::vector<UChar_t> fGrid;
+
+public:
+	/// \brief Copy the points of \e cut and build the grid
+	PolygonGate(const TCutG* cut);
+	/// \brief Is (\e x, \e y) inside the polygon?
+	Bool_t IsInside(Double_t x, Double_t y) const;
+	/// \brief Crossing number test on the vertices, identical to TMath::IsInside()
+	Bool_t IsInsideExact(Double_t x, Double_t y) const;
+	/// \brief Replace the vertices and rebuild the grid
+	void SetPoints(Int_t n, const Double_t* x, const Double_t* y);
+	/// \brief Update from the original TCutG if its points changed
+	void Sync();
+	/// \brief Name of the original cut
+	const char* GetName() const { return fName.c_str(); }
+	/// \brief Fraction of grid cells needing the exact test
+	Double_t GetBoundaryFraction() const;
+private:
+	/// Classify every grid cell
+	void BuildGrid();
+};
+
+} // namespace rb
+
+
+inline Bool_t rb::PolygonGate::IsInside(Double_t x, Double_t y) const {
+	if(!(x >= fXmin && x <= fXmax && y >= fYmin && y <= fYmax)) return kFALSE; // also rejects NaN
+	Int_t ix = static_cast<Int_t>((x - fXmin) * fInvDx);
+	Int_t iy = static_cast<Int_t>((y - fYmin) * fInvDy);
+	if(ix >= kGridSize) ix = kGridSize - 1;
+	if(iy >= kGridSize) iy = kGridSize - 1;
+	const UChar_t cell = fGrid[iy*kGridSize + ix];
+	return cell == kBoundary ? IsInsideExact(x, y) : cell == kInside;
+}
+
+
+#endif
@@ -0,0 +1,90 @@
+//! \file Reflect.cxx
+//! \brief Implements Reflect.hxx
+#include <cstdlib>
+#include "Reflect.hxx"
+
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Static registries                                     //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+std::map<std::string, rb::data::Reflection::Class*>& rb::data::Reflection::fgByName() {
+	static std::map<std::string, Class*>* m = new std::map<std::string, Class*>();
+	return *m;
+}
+std::map<std::string, rb::data::Reflection::Class*>& rb::data::Reflection::fgByType() {
+	static std::map<std::string, Class*>* m = new std::map<std::string, Class*>();
+	return *m;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Reflection::Class& Reflection::AddClass() [static]    //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::data::Reflection::Class& rb::data::Reflection::AddClass(const char* name, const std::type_info& type) {
+	std::map<std::string, Class*>::iterator it = fgByName().find(name);
+	if(it != fgByName().end()) return *(it->second);
+	Class* cl = new Class();
+	cl->fName = name;
+	fgByName().insert(std::make_pair(cl->fName, cl));
+	fgByType().insert(std::make_pair(std::string(type.name()), cl));
+	return *cl;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// const Reflection::Class* Reflection::Find() [static]  //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+const rb::data::Reflection::Class* rb::data::Reflection::Find(const char* className) {
+	if(fgByName().empty()) return 0; // nothing registered, skip the string copy
+	std::map<std::string, Class*>::const_iterator it = fgByName().find(className);
+	return it != fgByName().end() ? it->second : 0;
+}
+const rb::data::Reflection::Class* rb::data::Reflection::Find(const std::type_info& type) {
+	std::map<std::string, Class*>::const_iterator it = fgByType().find(type.name());
+	return it != fgByType().end() ? it->second : 0;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// const Reflection::Member* Class::FindMember()         //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+const rb::data::Reflection::Member*
+rb::data::Reflection::Class::FindMember(const char* name, size_t length) const {
+	for(std::vector<Member>::const_iterator it = fMembers.begin(); it != fMembers.end(); ++it) {
+		if(it->fName.size() == length && !it->fName.compare(0, length, name, length)) return &*it;
+	}
+	return 0;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// const Reflection::Member* Reflection::Resolve()       //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+const rb::data::Reflection::Member*
+rb::data::Reflection::Resolve(const char* className, const char* name, Long_t base, Long_t* addr) {
+	/*!
+	 * Walks \e name one component at a time, e.g. <tt>"mcp[2].tac"</tt> is member \c mcp of
+	 * \e className, element 2, then member \c tac of the class of \c mcp. Every component has to
+	 * be registered, arrays need an index in range, and the last component has to be basic.
+	 */
+	const Class* cl = Find(className);
+	Long_t address = base;
+	const char* p = name;
+	while(cl) {
+		const size_t length = strcspn(p, ".[");
+		const Member* m = cl->FindMember(p, length);
+		if(!m || m->fType == kUnsupported) return 0;
+		address += m->fOffset;
+		p += length;
+
+		if(m->fLength) { // array, needs an index
+			if(*p != '[') return 0;
+			char* end = 0;
+			const long index = strtol(p + 1, &end, 10);
+			if(end == p + 1 || *end != ']' || index < 0 || index >= m->fLength) return 0;
+			address += index * m->fSize;
+			p = end + 1;
+		}
+		if(*p == 0) { // end of the name, has to be a leaf
+			if(m->fType < 0) return 0;
+			*addr = address;
+			return m;
+		}
+		if(*p != '.' || m->fType != kClass) return 0;
+		++p;
+		cl = Find(*m->fTypeId); // 0 if the class isn't reflected
+	}
+	return 0;
+}
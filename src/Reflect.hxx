@@ -0,0 +1,189 @@
+//! \file Reflect.hxx
+//! \brief Compile-time registration of the members of user data classes.
+//! \details Opt-in alternative to walking the CINT dictionary: members listed with the RB_REFLECT
+//! macros are registered with their offsets and types, known at compile time, e.g.
+//! \code
+//! // MyAnalysis.cxx //
+//! #include "Reflect.hxx"
+//! RB_REFLECT_BEGIN(Experiment)
+//!   RB_REFLECT_MEMBER(tdc)       // Int_t tdc[32]
+//!   RB_REFLECT_MEMBER(mcp)       // Mcp mcp, itself reflected below
+//! RB_REFLECT_END(Experiment)
+//!
+//! RB_REFLECT_BEGIN(Mcp)
+//!   RB_REFLECT_MEMBER(tac)       // Double_t tac
+//! RB_REFLECT_END(Mcp)
+//! \endcode
+//! Formulas on reflected members are read with a typed rb::data::Reader set up from the registered
+//! offset, with no TClass lookup, and rb::data::Mapper maps reflected classes without reading the
+//! dictionary. Names not found in the registry (members left out, STL containers, classes that
+//! aren't reflected) are still resolved through the dictionary, which remains needed for TTree
+//! output.
+//!
+//! The class name given to RB_REFLECT_BEGIN must be the name known to ROOT (i.e. an unqualified
+//! class at global scope), and the members must be public basic types, one dimensional arrays of
+//! them, or classes (possibly in one dimensional arrays).
+#ifndef RB_REFLECT_HXX
+#define RB_REFLECT_HXX
+
+#ifndef __MAKECINT__
+#include <map>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <typeinfo>
+#include "Data.hxx"
+
+
+namespace rb
+{
+
+namespace data
+{
+
+/// \brief Registry of the members of classes listed with RB_REFLECT_BEGIN()
+class Reflection
+{
+public:
+	/// Member kinds in addition to MReader::Type_t
+	enum { kClass = -1, kUnsupported = -2 };
+	/// A registered member
+	struct Member {
+		std::string fName;             ///< Member name
+		Long_t fOffset;                ///< Offset from the start of the class
+		Int_t fType;                   ///< MReader::Type_t of the elements, kClass or kUnsupported
+		Int_t fLength;                 ///< Number of array elements, 0 if not an array
+		Int_t fSize;                   ///< Size of one element
+		Bool_t fConst;                 ///< Is the member const?
+		const std::type_info* fTypeId; ///< Type of the elements
+	};
+	/// A registered class
+	struct Class {
+		std::string fName;             ///< Name of the class known to ROOT
+		std::vector<Member> fMembers;  ///< Members, in order of registration
+		/// Member named \e name (\e length characters), 0 if it isn't registered
+		const Member* FindMember(const char* name, size_t length) const;
+	};
+private:
+	/// Classes by name
+	static std::map<std::string, Class*>& fgByName();
+	/// Classes by std::type_info::name()
+	static std::map<std::string, Class*>& fgByType();
+public:
+	/// \brief Register class \e C under \e name, or return the existing registration
+	template <class C> static Class& Add(const char* name);
+	/// \brief Register \e member of class \e C (ignored if already registered)
+	template <class C, class M> static void AddMember(Class& cl, const char* name, M C::* member);
+	/// \brief Registered class named \e className, 0 if there is none
+	static const Class* Find(const char* className);
+	/// \brief Registered class of type \e type, 0 if there is none
+	static const Class* Find(const std::type_info& type);
+	/// \brief Resolve a basic leaf of a registered class.
+	//! \param className Name of the class.
+	//! \param name Leaf name relative to the class, e.g. <tt>"mcp.tac"</tt> or <tt>"tdc[3]"</tt>.
+	//! \param base Address of the class instance.
+	//! \param [out] addr Address of the leaf.
+	//! \returns The member holding the leaf, or 0 if any part of \e name isn't registered
+	//! (in which case the dictionary should be used instead).
+	static const Member* Resolve(const char* className, const char* name, Long_t base, Long_t* addr);
+private:
+	/// Implements Add(), \e type is typeid(C)
+	static Class& AddClass(const char* name, const std::type_info& type);
+};
+
+/// \brief Describes the type of a reflected member.
+//! \details kValue is the MReader::Type_t of basic types, Reflection::kClass for anything else;
+//! kLength is the array length (0 for non-arrays); Element_t is the type of the elements.
+template <class T> struct ReflectType {
+	enum { kValue = Reflection::kClass, kLength = 0, kConst = 0 };
+	typedef T Element_t;
+};
+template <class T> struct ReflectType<const T> {
+	enum { kValue = ReflectType<T>::kValue, kLength = ReflectType<T>::kLength, kConst = 1 };
+	typedef typename ReflectType<T>::Element_t Element_t;
+};
+template <class T, size_t N> struct ReflectType<T[N]> {
+	enum {
+		kValue = ReflectType<T>::kLength != 0 ? Int_t(Reflection::kUnsupported) : Int_t(ReflectType<T>::kValue),
+		kLength = N, kConst = ReflectType<T>::kConst
+	};
+	typedef typename ReflectType<T>::Element_t Element_t;
+};
+template <class T, size_t N> struct ReflectType<const T[N]> {
+	enum { kValue = ReflectType<T[N]>::kValue, kLength = N, kConst = 1 };
+	typedef typename ReflectType<T>::Element_t Element_t;
+};
+#define RB_REFLECT_TYPE(type)																						\
+	template <> struct ReflectType<type> {																\
+		enum { kValue = ReaderType<type>::kValue, kLength = 0, kConst = 0 };	\
+		typedef type Element_t;																							\
+	}
+RB_REFLECT_TYPE(double);
+RB_REFLECT_TYPE(float);
+RB_REFLECT_TYPE(long long);
+RB_REFLECT_TYPE(long);
+RB_REFLECT_TYPE(int);
+RB_REFLECT_TYPE(short);
+RB_REFLECT_TYPE(char);
+RB_REFLECT_TYPE(bool);
+RB_REFLECT_TYPE(unsigned long long);
+RB_REFLECT_TYPE(unsigned long);
+RB_REFLECT_TYPE(unsigned int);
+RB_REFLECT_TYPE(unsigned short);
+RB_REFLECT_TYPE(unsigned char);
+#undef RB_REFLECT_TYPE
+
+} // namespace data
+
+} // namespace rb
+
+
+template <class C>
+inline rb::data::Reflection::Class& rb::data::Reflection::Add(const char* name) {
+	return AddClass(name, typeid(C));
+}
+
+template <class C, class M>
+inline void rb::data::Reflection::AddMember(Class& cl, const char* name, M C::* member) {
+	if(cl.FindMember(name, strlen(name))) return;
+	// offset from a dummy (non-null, suitably aligned) address, as offsetof() isn't
+	// allowed on classes that aren't PODs
+	C* const dummy = reinterpret_cast<C*>(0x1000);
+	Member m;
+	m.fName = name;
+	m.fOffset = reinterpret_cast<Long_t>(&(dummy->*member)) - reinterpret_cast<Long_t>(dummy);
+	m.fType = ReflectType<M>::kValue;
+	m.fLength = ReflectType<M>::kLength;
+	m.fSize = m.fLength ? sizeof(M) / m.fLength : sizeof(M);
+	m.fConst = ReflectType<M>::kConst;
+	m.fTypeId = &typeid(typename ReflectType<M>::Element_t);
+	cl.fMembers.push_back(m);
+}
+
+
+/// \brief Starts the list of reflected members of \e CLASS
+//! \details Use at global scope in a source file, followed by RB_REFLECT_MEMBER() for each
+//! member and RB_REFLECT_END(). Registration happens during static initialization.
+#define RB_REFLECT_BEGIN(CLASS)																					\
+	namespace { struct RbReflect_##CLASS { RbReflect_##CLASS() {					\
+		typedef CLASS Class_t;																							\
+		rb::data::Reflection::Class& rbClass = rb::data::Reflection::Add<CLASS>(#CLASS);
+
+/// \brief Registers \e MEMBER of the class given to RB_REFLECT_BEGIN()
+#define RB_REFLECT_MEMBER(MEMBER)																				\
+		rb::data::Reflection::AddMember(rbClass, #MEMBER, &Class_t::MEMBER);
+
+/// \brief Ends the list started by RB_REFLECT_BEGIN(\e CLASS)
+#define RB_REFLECT_END(CLASS)																						\
+	} } gRbReflect_##CLASS; }
+
+#else // CINT doesn't need to see any of this
+
+#define RB_REFLECT_BEGIN(CLASS)
+#define RB_REFLECT_MEMBER(MEMBER)
+#define RB_REFLECT_END(CLASS)
+
+#endif // #ifndef __MAKECINT__
+
+
+#endif
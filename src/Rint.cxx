@@ -1,10 +1,14 @@
 //! \file Rint.cxx
 //! \brief Implements Rint.hxx
 #include <set>
+#include <TROOT.h>
+#include <TThread.h>
+#include <RVersion.h>
 #include "Rint.hxx"
 #include "Rootbeer.hxx"
 #include "Gui.hxx"
 #include "HistGui.hxx"
+#include "Attach.hxx"
 #include "hist/Hist.hxx"
 
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
@@ -21,6 +25,12 @@ rb::Rint::Rint(const char* appClassName, int* argc, char** argv,
 	fSaveData(false), fSaveHists(false) {
 	std::set<std::string> flags(argv, argv + *argc);
 
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,0,0)
+	// Before any of our threads (fill timers, file closers, ...) exist
+	TThread::Initialize();
+	ROOT::EnableThreadSafety();
+#endif
+
 	RegisterEvents();
 	SetPrompt("rootbeer [%d] ");
 
@@ -49,6 +59,7 @@ void rb::Rint::Terminate(Int_t status) {
   }
 	DeleteSignals();
 	DeleteHistSignals();
+	rb::WaitSaveClose();
   TRint::Terminate(status);
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
@@ -1,12 +1,18 @@
 //! \file Rootbeer.cxx 
 //! \brief Implements the user interface functions.
 #include <memory>
+#include <vector>
+#include <set>
+#include <string>
+#include <sstream>
 #include <iostream>
+#include <TROOT.h>
 #include <TString.h>
 #include <TObjArray.h>
 #include <TVirtualPad.h>
 #include "hist/Hist.hxx"
 #include "utils/Error.hxx"
+#include "utils/Assorted.hxx"
 #include "Rint.hxx"
 #include "Buffer.hxx"
 #include "Data.hxx"
@@ -51,6 +57,104 @@ void rb::Unattach() {
 	rb::ListAttach::Stop();
 }
 
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::SetSavePolicy                                //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::SetSavePolicy(Int_t event_code, const char* compression, Int_t level,
+											 Int_t basket_size, Long64_t autoflush, Long64_t autosave, Bool_t implicit_mt) {
+	rb::Event* event = rb::Rint::gApp()->GetEvent(event_code);
+	if(!event) {
+		rb::err::Error("rb::SetSavePolicy") << "Invalid event code: " << event_code;
+		return;
+	}
+	Int_t algorithm = rb::SavePolicy::ParseAlgorithm(compression);
+	if(algorithm < 0) {
+		rb::err::Error("rb::SetSavePolicy") << "Unknown compression algorithm \"" << compression
+																				<< "\", valid options are \"zlib\", \"lzma\", \"lz4\" or \"default\"";
+		return;
+	}
+	if(basket_size <= 0) {
+		rb::err::Error("rb::SetSavePolicy") << "Invalid basket size: " << basket_size;
+		return;
+	}
+	rb::SavePolicy policy = event->GetSavePolicy(); // keeps the column list
+	policy.fAlgorithm  = algorithm;
+	policy.fLevel      = level;
+	policy.fBasketSize = basket_size;
+	policy.fAutoFlush  = autoflush;
+	policy.fAutoSave   = autosave;
+	policy.fImplicitMT = implicit_mt;
+	event->SetSavePolicy(policy);
+}
+
+namespace {
+//
+// Split a comma separated column list, ignoring commas inside parentheses
+// (so function arguments in formulae are kept together)
+std::vector<std::string> split_columns(const char* columns) {
+	std::vector<std::string> out;
+	std::string current;
+	Int_t depth = 0;
+	for(const char* c = columns; c && *c; ++c) {
+		if(*c == '(') ++depth;
+		if(*c == ')') --depth;
+		if(*c == ',' && depth == 0) {
+			TString col(current.c_str()); col = col.Strip(TString::kBoth);
+			if(col.Length()) out.push_back(col.Data());
+			current = "";
+		}
+		else current.push_back(*c);
+	}
+	TString col(current.c_str()); col = col.Strip(TString::kBoth);
+	if(col.Length()) out.push_back(col.Data());
+	return out;
+} }
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::SetSaveColumns                               //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::SetSaveColumns(Int_t event_code, const char* columns) {
+	rb::Event* event = rb::Rint::gApp()->GetEvent(event_code);
+	if(!event) {
+		rb::err::Error("rb::SetSaveColumns") << "Invalid event code: " << event_code;
+		return;
+	}
+	rb::SavePolicy policy = event->GetSavePolicy();
+	policy.fColumns = split_columns(columns);
+	event->SetSavePolicy(policy);
+}
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::PrintSavePolicy                              //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::PrintSavePolicy(Int_t event_code) {
+	rb::EventVector_t events = rb::Rint::gApp()->GetEventVector();
+	for(rb::EventVector_t::iterator it = events.begin(); it != events.end(); ++it) {
+		if(event_code != -1 && it->first != event_code) continue;
+		rb::SavePolicy policy = rb::Rint::gApp()->GetEvent(it->first)->GetSavePolicy();
+		std::cout << it->second << " (code " << it->first << "):"
+							<< " compression = " << rb::SavePolicy::AlgorithmName(policy.fAlgorithm)
+							<< ", level = " << policy.fLevel
+							<< ", basket size = " << policy.fBasketSize
+							<< ", autoflush = " << policy.fAutoFlush
+							<< ", autosave = " << policy.fAutoSave
+							<< ", implicit MT = " << (policy.fImplicitMT ? "yes" : "no") << "\n";
+		if(!policy.fColumns.empty()) {
+			std::cout << "   columns:";
+			for(size_t i=0; i< policy.fColumns.size(); ++i)
+				std::cout << (i ? ", " : " ") << policy.fColumns[i];
+			std::cout << "\n";
+		}
+	}
+}
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::SetOnlineRollover                            //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::SetOnlineRollover(Double_t max_mb, Double_t max_minutes, Bool_t on_run) {
+	rb::OnlineAttach::SetRollover(max_mb, max_minutes, on_run);
+}
+
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // TVirtualPad* rb::CdPad                                //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
@@ -167,6 +271,61 @@ void rb::data::SetValue(const char* name, Double_t newvalue) {
   basicData->SetValue(newvalue);
 }
 
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Int_t rb::data::GetHandle                             //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Int_t rb::data::GetHandle(const char* name) {
+	Int_t handle = data::MBasic::FindHandle(name);
+	if(handle < 0) Error("GetHandle", "%s not found.", name);
+	return handle;
+}
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Double_t rb::data::GetValueAt                         //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Double_t rb::data::GetValueAt(Int_t handle) {
+	data::MBasic* basicData = data::MBasic::Get(handle);
+	if(!basicData) {
+		Error("GetValueAt", "Invalid handle: %d.", handle);
+		return -1.;
+	}
+	return basicData->GetValue();
+}
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::data::SetValueAt                             //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::data::SetValueAt(Int_t handle, Double_t newvalue) {
+	data::MBasic* basicData = data::MBasic::Get(handle);
+	if(!basicData) {
+		Error("SetValueAt", "Invalid handle: %d.", handle);
+		return;
+	}
+	basicData->SetValue(newvalue);
+}
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::data::GetValues                              //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::data::GetValues(const Int_t* handles, Double_t* values, Int_t n) {
+	RB_LOCKGUARD(gDataMutex);
+	for(Int_t i=0; i< n; ++i) {
+		data::MBasic* basicData = data::MBasic::Get(handles[i]);
+		values[i] = basicData ? basicData->GetValueUnlocked() : -1.;
+	}
+}
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::data::SetValues                              //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::data::SetValues(const Int_t* handles, const Double_t* values, Int_t n) {
+	RB_LOCKGUARD(gDataMutex);
+	for(Int_t i=0; i< n; ++i) {
+		data::MBasic* basicData = data::MBasic::Get(handles[i]);
+		if(basicData) basicData->SetValueUnlocked(values[i]);
+	}
+}
+
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // void rb::data::PrintAll                               //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
@@ -175,6 +334,50 @@ void rb::data::PrintAll() {
   p.PrintAll();
 }
 
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::data::SetContainerDefault                    //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::data::SetContainerDefault(Double_t value) {
+	RB_LOCKGUARD(gDataMutex);
+	data::ContainerReader::SetDefault(value);
+}
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Bool_t rb::data::Define                               //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Bool_t rb::data::Define(const char* name, const char* expression, Int_t event_code) {
+	rb::Event* event = rb::Rint::gApp()->GetEvent(event_code);
+	if(!event) {
+		rb::err::Error("rb::data::Define") << "Invalid event code: " << event_code;
+		return false;
+	}
+	return event->Define(name, expression, false);
+}
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Bool_t rb::data::DefineGate                           //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Bool_t rb::data::DefineGate(const char* name, const char* condition, Int_t event_code) {
+	rb::Event* event = rb::Rint::gApp()->GetEvent(event_code);
+	if(!event) {
+		rb::err::Error("rb::data::DefineGate") << "Invalid event code: " << event_code;
+		return false;
+	}
+	return event->Define(name, condition, true);
+}
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::data::PrintDerived                           //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::data::PrintDerived(Int_t event_code) {
+	rb::Event* event = rb::Rint::gApp()->GetEvent(event_code);
+	if(!event) {
+		rb::err::Error("rb::data::PrintDerived") << "Invalid event code: " << event_code;
+		return;
+	}
+	event->PrintDerived();
+}
+
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // Histogram Creation Helper Function                    //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
@@ -189,12 +392,13 @@ namespace { rb::hist::Manager* const find_manager(Int_t code) {
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 rb::hist::Base* rb::hist::New(const char* name, const char* title,
 															Int_t bx, Double_t xl, Double_t xh,
-															const char* param, const char* gate, Int_t event_code) {
+															const char* param, const char* gate, Int_t event_code,
+															Option_t* storage) {
 	Bool_t from_gui =
 		 Rint::gApp()->GetHistSignals() ? Rint::gApp()->GetHistSignals()->IsHistFromGui() : 0;
   rb::hist::Base* hist = 0;
   try {
-    hist = find_manager(event_code)->Create<D1>(name, title, param, gate, event_code, bx, xl, xh);
+    hist = find_manager(event_code)->Create<D1>(name, title, param, gate, event_code, bx, xl, xh, storage);
   }
   catch (std::exception& e) {
 		if(!from_gui) rb::err::Error("rb::hist::New") << e.what();
@@ -209,12 +413,13 @@ rb::hist::Base* rb::hist::New(const char* name, const char* title,
 rb::hist::Base* rb::hist::New(const char* name, const char* title,
 															Int_t bx, Double_t xl, Double_t xh,
 															Int_t by, Double_t yl, Double_t yh,
-															const char* param, const char* gate, Int_t event_code) {
+															const char* param, const char* gate, Int_t event_code,
+															Option_t* storage) {
   Bool_t from_gui =
 		 Rint::gApp()->GetHistSignals() ? Rint::gApp()->GetHistSignals()->IsHistFromGui() : 0;
   rb::hist::Base* hist = 0;
   try {
-    hist = find_manager(event_code)->Create<D2>(name, title, param, gate, event_code, bx, xl, xh, by, yl, yh);
+    hist = find_manager(event_code)->Create<D2>(name, title, param, gate, event_code, bx, xl, xh, by, yl, yh, storage);
   }
   catch (std::exception& e) {
 		if(!from_gui) rb::err::Error("rb::hist::New") << e.what();
@@ -230,13 +435,14 @@ rb::hist::Base* rb::hist::New(const char* name, const char* title,
 															Int_t bx, Double_t xl, Double_t xh,
 															Int_t by, Double_t yl, Double_t yh,
 															Int_t bz, Double_t zl, Double_t zh,
-															const char* param, const char* gate, Int_t event_code) {
+															const char* param, const char* gate, Int_t event_code,
+															Option_t* storage) {
 	Bool_t from_gui =
 		 Rint::gApp()->GetHistSignals() ? Rint::gApp()->GetHistSignals()->IsHistFromGui() : 0;
 
   rb::hist::Base* hist = 0;
   try {
-		hist = find_manager(event_code)->Create<D3>(name, title, param, gate, event_code, bx, xl, xh, by, yl, yh, bz, zl, zh);
+		hist = find_manager(event_code)->Create<D3>(name, title, param, gate, event_code, bx, xl, xh, by, yl, yh, bz, zl, zh, storage);
   }
   catch (std::exception& e) {
 		if(!from_gui) rb::err::Error("rb::hist::New") << e.what();
@@ -267,18 +473,69 @@ rb::hist::Base* rb::hist::NewSummary(const char* name, const char* title,
   return hist;
 }
 
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+//  rb::hist::NewFamily                                  //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+namespace { void set_channel_gate(rb::hist::Base*& hist, const char* channel_gate) {
+	if(!channel_gate || !*channel_gate) return;
+	if(static_cast<rb::hist::Family*>(hist)->RegateChannels(channel_gate) == 0) return;
+	delete hist;
+	hist = 0;
+	rb::err::Throw() << "Invalid channel gate: \"" << channel_gate << "\"";
+}}
+rb::hist::Base* rb::hist::NewFamily(const char* name, const char* title,
+																		Int_t nbins, Double_t low, Double_t high,
+																		const char* params, const char* gate, Int_t event_code,
+																		const char* channel_gate, Option_t* storage) {
+	Bool_t from_gui =
+		 Rint::gApp()->GetHistSignals() ? Rint::gApp()->GetHistSignals()->IsHistFromGui() : 0;
+
+  rb::hist::Base* hist = 0;
+  try {
+    hist = find_manager(event_code)->Create<Family>(name, title, params, gate, event_code,
+																										nbins, low, high, storage);
+		set_channel_gate(hist, channel_gate);
+  }
+  catch (std::exception& e) {
+		if(!from_gui) rb::err::Error("rb::hist::NewFamily") << e.what();
+		else throw;
+  }
+  return hist;
+}
+rb::hist::Base* rb::hist::NewFamily(const char* name, const char* title,
+																		Int_t nbinsx, Double_t xlow, Double_t xhigh,
+																		Int_t nbinsy, Double_t ylow, Double_t yhigh,
+																		const char* params, const char* gate, Int_t event_code,
+																		const char* channel_gate, Option_t* storage) {
+	Bool_t from_gui =
+		 Rint::gApp()->GetHistSignals() ? Rint::gApp()->GetHistSignals()->IsHistFromGui() : 0;
+
+  rb::hist::Base* hist = 0;
+  try {
+    hist = find_manager(event_code)->Create<Family>(name, title, params, gate, event_code,
+																										nbinsx, xlow, xhigh, nbinsy, ylow, yhigh, storage);
+		set_channel_gate(hist, channel_gate);
+  }
+  catch (std::exception& e) {
+		if(!from_gui) rb::err::Error("rb::hist::NewFamily") << e.what();
+		else throw;
+  }
+  return hist;
+}
+
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 //  rb::hist::NewGamma (One-dimensional)                 //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 rb::hist::Base* rb::hist::NewGamma(const char* name, const char* title,
 																	 Int_t nbinsx, Double_t xlow, Double_t xhigh,
-																	 const char* param, const char* gate, Int_t event_code) {
+																	 const char* param, const char* gate, Int_t event_code,
+																	 Option_t* storage) {
 	Bool_t from_gui =
 		 Rint::gApp()->GetHistSignals() ? Rint::gApp()->GetHistSignals()->IsHistFromGui() : 0;
 
   rb::hist::Base* hist = 0;
   try {
-    hist = find_manager(event_code)->Create<Gamma>(name, title, param, gate, event_code, nbinsx, xlow, xhigh);
+    hist = find_manager(event_code)->Create<Gamma>(name, title, param, gate, event_code, nbinsx, xlow, xhigh, storage);
   }
   catch (std::exception& e) {
 		if(!from_gui) rb::err::Error("rb::hist::New") << e.what();
@@ -293,14 +550,15 @@ rb::hist::Base* rb::hist::NewGamma(const char* name, const char* title,
 rb::hist::Base* rb::hist::NewGamma(const char* name, const char* title,
 																	 Int_t nbinsx, Double_t xlow, Double_t xhigh,
 																	 Int_t nbinsy, Double_t ylow, Double_t yhigh,
-																	 const char* param, const char* gate, Int_t event_code) {
+																	 const char* param, const char* gate, Int_t event_code,
+																	 Option_t* storage) {
 	Bool_t from_gui =
 		 Rint::gApp()->GetHistSignals() ? Rint::gApp()->GetHistSignals()->IsHistFromGui() : 0;
 
   rb::hist::Base* hist = 0;
   try {
     hist = find_manager(event_code)->Create<Gamma>(name, title, param, gate, event_code,
-																									 nbinsx, xlow, xhigh, nbinsy, ylow, yhigh);
+																									 nbinsx, xlow, xhigh, nbinsy, ylow, yhigh, storage);
   }
   catch (std::exception& e) {
 		if(!from_gui) rb::err::Error("rb::hist::New") << e.what();
@@ -316,14 +574,15 @@ rb::hist::Base* rb::hist::NewGamma(const char* name, const char* title,
 																	 Int_t nbinsx, Double_t xlow, Double_t xhigh,
 																	 Int_t nbinsy, Double_t ylow, Double_t yhigh,
 																	 Int_t nbinsz, Double_t zlow, Double_t zhigh,
-																	 const char* params,  const char* gate, Int_t event_code) {
+																	 const char* params,  const char* gate, Int_t event_code,
+																	 Option_t* storage) {
 	Bool_t from_gui =
 		 Rint::gApp()->GetHistSignals() ? Rint::gApp()->GetHistSignals()->IsHistFromGui() : 0;
 
   rb::hist::Base* hist = 0;
   try {
     hist = find_manager(event_code)->Create<Gamma>(name, title, params, gate, event_code,
-																									 nbinsx, xlow, xhigh, nbinsy, ylow, yhigh, nbinsz, zlow, zhigh);
+																									 nbinsx, xlow, xhigh, nbinsy, ylow, yhigh, nbinsz, zlow, zhigh, storage);
   }
   catch (std::exception& e) {
 		if(!from_gui) rb::err::Error("rb::hist::New") << e.what();
@@ -352,6 +611,44 @@ rb::hist::Base* rb::hist::NewScaler(const char* name, const char* title,
   return hist;
 }
 
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+//  rb::hist::NewStrip                                   //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::hist::Base* rb::hist::NewStrip(const char* name, const char* title, Int_t nbins, const char* param,
+																	 const char* gate, Int_t event_code, Double_t seconds) {
+	Bool_t from_gui =
+		Rint::gApp()->GetHistSignals() ? Rint::gApp()->GetHistSignals()->IsHistFromGui() : 0;
+
+  rb::hist::Base* hist = 0;
+  try {
+    hist = find_manager(event_code)->Create<Strip>(name, title, param, gate, event_code, nbins, seconds, 0.);
+  }
+  catch (std::exception& e) {
+		if(!from_gui) rb::err::Error("rb::hist::NewStrip") << e.what();
+		else throw;
+  }
+  return hist;
+}
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+//  rb::hist::NewRate                                    //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::hist::Base* rb::hist::NewRate(const char* name, const char* title, Int_t nbins, const char* timestamp,
+																	const char* gate, Int_t event_code, Double_t interval) {
+	Bool_t from_gui =
+		Rint::gApp()->GetHistSignals() ? Rint::gApp()->GetHistSignals()->IsHistFromGui() : 0;
+
+  rb::hist::Base* hist = 0;
+  try {
+    hist = find_manager(event_code)->Create<Rate>(name, title, timestamp, gate, event_code, nbins, interval, 0.);
+  }
+  catch (std::exception& e) {
+		if(!from_gui) rb::err::Error("rb::hist::NewRate") << e.what();
+		else throw;
+  }
+  return hist;
+}
+
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 //  rb::hist::NewBit                                     //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
@@ -370,6 +667,51 @@ rb::hist::Base* rb::hist::NewBit(const char* name, const char* title, Int_t nbit
   return hist;
 }
 
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+//  rb::hist::NewChannels                                //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Int_t rb::hist::NewChannels(const char* name, const char* title, Int_t first, Int_t last,
+														Int_t nbins, Double_t low, Double_t high,
+														const char* param, const char* gate, Int_t event_code,
+														Option_t* storage) {
+	std::vector<std::string> names;
+	std::set<std::string> unique;
+	for(Int_t channel = first; channel <= last; ++channel) {
+		names.push_back(channel_string(name, channel));
+		const std::string& current = names.back();
+		if(current.empty() || !unique.insert(current).second) {
+			rb::err::Error("rb::hist::NewChannels") << "Empty or repeated histogram name: \"" << current
+																							<< "\" (channel " << channel << ").";
+			return 0;
+		}
+		if(!rb::hist::Base::GetOverwrite() && rb::Rint::gApp()->FindHistogram(current.c_str())) {
+			rb::err::Error("rb::hist::NewChannels") << "The name \"" << current << "\" is already in use.";
+			return 0;
+		}
+	}
+
+	rb::hist::Manager* manager = 0;
+	std::vector<rb::hist::Base*> created;
+	try {
+		manager = find_manager(event_code);
+		manager->BeginBulk();
+		for(Int_t channel = first; channel <= last; ++channel)
+			created.push_back(manager->Create<D1>(names[channel - first].c_str(),
+																						channel_string(title, channel).c_str(),
+																						channel_string(param, channel).c_str(),
+																						channel_string(gate, channel).c_str(),
+																						event_code, nbins, low, high, storage));
+	}
+	catch (std::exception& e) {
+		rb::err::Error("rb::hist::NewChannels") << e.what() << " (no histograms created).";
+		for(std::vector<rb::hist::Base*>::iterator it = created.begin(); it != created.end(); ++it)
+			delete *it;
+		created.clear();
+	}
+	if(manager) manager->EndBulk();
+	return static_cast<Int_t>(created.size());
+}
+
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 //  rb::hist::ClearAll                                   //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
@@ -380,3 +722,32 @@ void rb::hist::ClearAll() {
 		if(manager) manager->ClearAll();
 	}	
 }
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+//  rb::hist::SetBatchSize                               //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::SetBatchSize(Int_t n, Int_t event_code) {
+	if(event_code != -1) {
+		rb::hist::Manager* manager = find_manager(event_code);
+		if(manager) manager->SetBatchSize(n);
+		else rb::err::Error("rb::hist::SetBatchSize") << "Invalid event code: " << event_code;
+		return;
+	}
+	rb::EventVector_t events = Rint::gApp()->GetEventVector();
+	for(EventVector_t::iterator it = events.begin(); it != events.end(); ++it) {
+		rb::hist::Manager* manager = find_manager(it->first);
+		if(manager) manager->SetBatchSize(n);
+	}
+}
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+//  rb::hist::PrintFormulaReport                         //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::PrintFormulaReport(Int_t event_code, Int_t nloops) {
+	rb::EventVector_t events = Rint::gApp()->GetEventVector();
+	for(EventVector_t::iterator it = events.begin(); it != events.end(); ++it) {
+		if(event_code != -1 && it->first != event_code) continue;
+		std::cout << "\n==== Event " << it->first << " (" << it->second << ") ====\n";
+		find_manager(it->first)->PrintFormulaReport(std::cout, nloops);
+	}
+	std::cout << std::flush;
+}
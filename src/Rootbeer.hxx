@@ -35,6 +35,44 @@ void AttachList(const char* filename);
 //! Stops all reading of data and closes out the relevant threads.
 void Unattach();
 
+/// \brief Set how tree data are written to disk for a given event type.
+//! \details Takes effect the next time saving starts (i.e. on the next attach).
+//! \param event_code Code of the event type whose saved tree is affected.
+//! \param compression Compression algorithm: "zlib", "lzma" (small files, slow), "lz4"
+//!  (fast, larger files; ROOT >= 6.10) or "default" (leave as is).
+//! \param level Compression level, 0-9. -1 means use the file default.
+//! \param basket_size Basket buffer size in bytes.
+//! \param autoflush TTree::SetAutoFlush() argument (<0 is bytes, >0 is entries).
+//! \param autosave TTree::SetAutoSave() argument (<0 is bytes, >0 is entries).
+//! \param implicit_mt Turn on ROOT implicit multi-threading (parallel compression).
+void SetSavePolicy(Int_t event_code, const char* compression = "default", Int_t level = -1,
+									 Int_t basket_size = 32000, Long64_t autoflush = -30000000,
+									 Long64_t autosave = -300000000, Bool_t implicit_mt = kFALSE);
+
+/// \brief Save only a selected list of columns for an event type (flat-ntuple mode).
+//! \details Instead of streaming the full user class, the saved tree gets one Double_t
+//! leaf per column. Plain leaves are read directly from their memory address.
+//! \param event_code Code of the event type whose saved tree is affected.
+//! \param columns Comma separated list of leaf names or formulae, e.g.
+//!  <tt>"dragon.head.bgo.ecal[], dragon.tof"</tt>. A trailing <tt>[]</tt> expands to every
+//!  element of an array. Passing "" goes back to saving the full class. Leaves are named
+//!  after their column with non-alphanumeric characters replaced by '_' ("a.b[3]" -> "a_b_3");
+//!  a name already taken gets a numbered suffix ("a_b_3_1").
+void SetSaveColumns(Int_t event_code, const char* columns = "");
+
+/// \brief Print the save policy for an event type (-1 prints all of them).
+void PrintSavePolicy(Int_t event_code = -1);
+
+/// \brief Set when online saving should switch to a new output file.
+//! \details The previous file is finished and closed in a background thread, so
+//! unpacking is not held up (with ROOT 6; ROOT 5 isn't thread safe enough for that, so
+//! there it's closed before unpacking goes on). All conditions are checked; any one of them triggers a rollover.
+//! \param max_mb Start a new file once the current one exceeds this many megabytes (0 = never).
+//! \param max_minutes Start a new file once the current one is this many minutes old (0 = never).
+//! \param on_run Start a new file at every run start and stop transition (file names are
+//!  tagged with the run number).
+void SetOnlineRollover(Double_t max_mb = 0, Double_t max_minutes = 0, Bool_t on_run = kFALSE);
+
 /// \brief Write canvas configuration file.
 Int_t WriteCanvasXML(const char* filename, Bool_t prompt = kTRUE);
 
@@ -147,10 +185,65 @@ Double_t GetValue(const char* name);
 //! \param [in] newvalue What you want to set the data keyed by <i>name</i> to.
 void SetValue(const char* name, Double_t newvalue);
 
+/// \brief Look up the handle of a user class data member, for the handle based functions below.
+//! \details Handles never change, so scripts that access the same members repeatedly (e.g. once
+//! per event) can look the names up once and avoid a search by name on every access:
+//! \code
+//! Int_t h[2] = { rb::data::GetHandle("mine.a"), rb::data::GetHandle("mine.b") };
+//! Double_t v[2];
+//! rb::data::GetValues(h, v, 2);
+//! \endcode
+//! \returns The handle, or -1 if there is no data member named \e name.
+Int_t GetHandle(const char* name);
+
+/// Get the value of the data member with handle \e handle (see GetHandle()).
+Double_t GetValueAt(Int_t handle);
+
+/// Set the value of the data member with handle \e handle (see GetHandle()).
+void SetValueAt(Int_t handle, Double_t newvalue);
+
+/// \brief Get the values of \e n data members at once.
+//! \details Locks the data only once for the whole set.
+//! \param [in] handles Handles of the data members (see GetHandle()).
+//! \param [out] values Their values; -1 for invalid handles.
+//! \param [in] n Number of data members.
+void GetValues(const Int_t* handles, Double_t* values, Int_t n);
+
+/// \brief Set the values of \e n data members at once.
+//! \details Locks the data only once for the whole set. Invalid handles are skipped.
+void SetValues(const Int_t* handles, const Double_t* values, Int_t n);
+
 
 /// Print the fill name and current value of every data member in every listed class.
 void PrintAll();
 
+/// \brief Set the value read for elements past the end of an STL container.
+//! \details Histogram parameters and gates may refer to any element of a (basic type) STL
+//! member, e.g. `"data.hits[3]"`; in events where the container is shorter, the element
+//! reads as \e value (0 by default, as in TTree::Draw()).
+void SetContainerDefault(Double_t value);
+
+/// \brief Define a named derived variable.
+//! \details The value is computed once per event (before any histogram is filled) and can be
+//! used by name in histogram parameters, gates and other definitions of the same event type:
+//! \code
+//! rb::data::Define("tof", "tail.mcp.tac - head.tail_time");
+//! rb::hist::New("hTof", "Time of flight", 200, 0, 100, "tof");
+//! \endcode
+//! Redefining a variable updates everything that uses it.
+//! \param [in] name Identifier used to refer to the variable.
+//! \param [in] expression Formula defining it.
+//! \param [in] event_code Event type the variable belongs to.
+//! \returns true on success.
+Bool_t Define(const char* name, const char* expression, Int_t event_code = 1);
+
+/// \brief Define a named gate.
+//! \details Same as Define(), but the value is 1 if \e condition is true and 0 otherwise.
+Bool_t DefineGate(const char* name, const char* condition, Int_t event_code = 1);
+
+/// Print the derived variables and gates of an event type, in evaluation order.
+void PrintDerived(Int_t event_code = 1);
+
 } // namespace data
 
 /// Creation functions for histograms
@@ -158,23 +251,31 @@ namespace hist
 {
 class Base;
 
-/// One-dimensional creation function
+/// \brief One-dimensional creation function
+//! \details \e storage selects the bin type: "D" (double, default), "F" (float), "I", "S" or "C"
+//! (32, 16 or 8 bit integer). Narrow bins are promoted automatically before they overflow, see
+//! rb::hist::Base::SetStorage(). "sparse" stores only the filled bins, for large, mostly empty
+//! 2d and 3d histograms; they are written to file as THnSparseD, and GetHist() makes a dense copy
+//! (or, if that's too big, a projection onto the x and y axes).
 rb::hist::Base* New(const char* name, const char* title,
 										Int_t nbinsx, Double_t xlow, Double_t xhigh,
-										const char* param, const char* gate = "", Int_t event_code = 1);
+										const char* param, const char* gate = "", Int_t event_code = 1,
+										Option_t* storage = "D");
 
 /// Two-dimensional creation function
 rb::hist::Base* New(const char* name, const char* title,
 										Int_t nbinsx, Double_t xlow, Double_t xhigh,
 										Int_t nbinsy, Double_t ylow, Double_t yhigh,
-										const char* param, const char* gate = "", Int_t event_code = 1);
+										const char* param, const char* gate = "", Int_t event_code = 1,
+										Option_t* storage = "D");
 
 /// Three-dimensional creation function
 rb::hist::Base* New(const char* name, const char* title,
 										Int_t nbinsx, Double_t xlow, Double_t xhigh,
 										Int_t nbinsy, Double_t ylow, Double_t yhigh,
 										Int_t nbinsz, Double_t zlow, Double_t zhigh,
-										const char* param, const char* gate = "", Int_t event_code = 1);
+										const char* param, const char* gate = "", Int_t event_code = 1,
+										Option_t* storage = "D");
 
 /// Summary histogram creation
 rb::hist::Base* NewSummary(const char* name, const char* title,
@@ -182,23 +283,44 @@ rb::hist::Base* NewSummary(const char* name, const char* title,
 													 const char* paramList,  const char* gate = "", Int_t event_code = 1,
 													 const char* orientation = "v");
 
+/// \brief Histogram family creation (1d channels)
+//! \details One histogram per channel, all with the same binning and filled together; see
+//! rb::hist::Family. \e params lists one parameter per channel, e.g. <tt>"ecal[0-29]"</tt>, and
+//! \e channel_gate is an optional gate for each channel, with <tt>"%d"</tt> standing for the
+//! channel index, e.g. <tt>"ecal.t[%d] > 0"</tt>.
+rb::hist::Base* NewFamily(const char* name, const char* title,
+													Int_t nbins, Double_t low, Double_t high,
+													const char* params, const char* gate = "", Int_t event_code = 1,
+													const char* channel_gate = "", Option_t* storage = "D");
+
+/// \brief Histogram family creation (2d channels)
+//! \details As above, \e params being <tt>"ylist:xlist"</tt>, e.g. <tt>"ecal.t[0-29]:ecal.e[0-29]"</tt>.
+rb::hist::Base* NewFamily(const char* name, const char* title,
+													Int_t nbinsx, Double_t xlow, Double_t xhigh,
+													Int_t nbinsy, Double_t ylow, Double_t yhigh,
+													const char* params, const char* gate = "", Int_t event_code = 1,
+													const char* channel_gate = "", Option_t* storage = "D");
+
 /// Gamma hist creation (1d)
 rb::hist::Base* NewGamma(const char* name, const char* title,
 												 Int_t nbinsx, Double_t xlow, Double_t xhigh,
-												 const char* params,  const char* gate = "", Int_t event_code = 1);
+												 const char* params,  const char* gate = "", Int_t event_code = 1,
+												 Option_t* storage = "D");
 
 /// Gamma hist creation (2d)
 rb::hist::Base* NewGamma(const char* name, const char* title,
 												 Int_t nbinsx, Double_t xlow, Double_t xhigh,
 												 Int_t nbinsy, Double_t ylow, Double_t yhigh,
-												 const char* params,  const char* gate = "", Int_t event_code = 1);
+												 const char* params,  const char* gate = "", Int_t event_code = 1,
+												 Option_t* storage = "D");
 
 /// Gamma hist creation (3d)
 rb::hist::Base* NewGamma(const char* name, const char* title,
 												 Int_t nbinsx, Double_t xlow, Double_t xhigh,
 												 Int_t nbinsy, Double_t ylow, Double_t yhigh,
 												 Int_t nbinsz, Double_t zlow, Double_t zhigh,
-												 const char* params,  const char* gate = "", Int_t event_code = 1);
+												 const char* params,  const char* gate = "", Int_t event_code = 1,
+												 Option_t* storage = "D");
 
 /// Scaler hist creation
 rb::hist::Base* NewScaler(const char* name, const char* title,
@@ -206,13 +328,60 @@ rb::hist::Base* NewScaler(const char* name, const char* title,
 													const char* params, const char* gate = "", Int_t event_code = 1);
 																 
 
+/// \brief Strip chart hist creation
+//! \details Shows \e param over the last \e nbins samples or, if \e seconds isn't 0, over the last
+//! \e seconds (in \e nbins slots, wall clock time unless \e param is <tt>"value:timestamp"</tt>).
+//! Uses fixed memory; see rb::hist::Strip.
+rb::hist::Base* NewStrip (const char* name, const char* title, Int_t nbins, const char* param,
+													const char* gate = "", Int_t event_code = 1, Double_t seconds = 0);
+
+/// \brief Rate meter hist creation
+//! \details Counts per second in each of the last \e nbins intervals of \e interval seconds,
+//! timed by the wall clock or, if given, the \e timestamp parameter (in seconds).
+//! Uses fixed memory; see rb::hist::Rate. Like NewStrip(), the time option comes last.
+rb::hist::Base* NewRate (const char* name, const char* title, Int_t nbins, const char* timestamp = "",
+												 const char* gate = "", Int_t event_code = 1, Double_t interval = 1);
+
 /// Bit hist creation
 rb::hist::Base* NewBit (const char* name, const char* title, Int_t nbits, const char* param,
 												const char* gate = "", Int_t event_code = 1);
 
+/// \brief Create one 1d histogram per channel, as a single batch.
+//! \details Each occurrence of <tt>"%d"</tt> in \e name, \e title, \e param and \e gate is replaced
+//! by the channel number, e.g.
+//! \code
+//! rb::hist::NewChannels("tdc%d", "TDC channel %d", 0, 31, 4096, 0, 4096, "tdc[%d]");
+//! \endcode
+//! All names are checked before anything is created: if any is empty, repeated, or (unless
+//! overwriting is on) already in use, nothing is created. The histograms are added to the
+//! fill plan together and the GUI is notified once, at the end.
+//! \returns The number of histograms created (0 on failure).
+Int_t NewChannels(const char* name, const char* title, Int_t first, Int_t last,
+									Int_t nbins, Double_t low, Double_t high,
+									const char* param, const char* gate = "", Int_t event_code = 1,
+									Option_t* storage = "D");
+
 /// Zero all histograms
 void ClearAll();
 
+/// \brief Set the number of events collected before histograms are filled.
+/// \details In batch mode, gates and parameters are still evaluated event-by-event,
+/// but the values are stored and the histograms filled in one pass every \e n events
+/// (and whenever the attach thread yields or stops, and before histograms are written).
+/// Canvas updates in between show the histograms as of the last of these.
+/// \param n Events per batch; 0 or 1 fills every event (the default behavior).
+/// \param event_code Event code to apply to, -1 applies to all events.
+void SetBatchSize(Int_t n, Int_t event_code = -1);
+
+/// \brief Print how every histogram parameter and gate is evaluated, and what it costs.
+/// \details Formulae are listed slowest first, with the evaluation method chosen for each
+/// ("compiled", "ClassFormula", "constant", "direct" or "TTreeFormula") and, for those
+/// not compiled, why the faster methods were rejected. Each formula is timed on the data
+/// of the most recent event. The same report is available from the histogram GUI.
+/// \param event_code Event code to report on, -1 reports on all events.
+/// \param nloops Number of evaluations to time each formula over.
+void PrintFormulaReport(Int_t event_code = -1, Int_t nloops = 1000);
+
 } // namespace hist
 
 } // namespace rb
@@ -9,6 +9,7 @@
 #include <TGMsgBox.h>
 #include <TGFileDialog.h>
 #include <TGInputDialog.h>
+#include <TRootHelpDialog.h>
 #include "TGSelectDialog.h"
 #include "TGDivideSelect.h"
 #include "Signals.hxx"
@@ -620,6 +621,22 @@ void rb::HistSignals::Mkdir() {
   SyncHistTree();
 }
 
+void rb::HistSignals::FormulaReport() {
+  rb::Rint::gApp()->fHistFrame->fFormulaReportButton->SetDown(false);
+  std::stringstream report;
+  rb::EventVector_t events = rb::Rint::gApp()->GetEventVector();
+  for(EventVector_t::iterator it = events.begin(); it != events.end(); ++it) {
+    rb::Event* event = rb::Rint::gApp()->GetEvent(it->first);
+    if(!event) continue;
+    report << "==== Event " << it->first << " (" << it->second << ") ====\n";
+    event->GetHistManager()->PrintFormulaReport(report, 1000);
+    report << "\n";
+  }
+  TRootHelpDialog* dialog = new TRootHelpDialog(gClient->GetRoot(), "Formula Report", 900, 500);
+  dialog->SetText(report.str().c_str());
+  dialog->Popup();
+}
+
 void rb::HistSignals::DrawHist() {
   TGListTreeItem* item = rb::Rint::gApp()->fHistFrame->fHistTree->GetSelected();
   return DrawHist(item, 1);
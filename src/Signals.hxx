@@ -86,6 +86,7 @@ public:
 	void DrawHist(TGListTreeItem* item);
 	void DrawHist();
 	void Mkdir();
+	void FormulaReport();
 	void Cd(TGListTreeItem*, Int_t);
 	void Cd(TGListTreeItem* item);
 	void Cd();
@@ -579,6 +579,62 @@ void rb::ReadCanvasXML(const char* filename) {
 }
 
 
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// XML SAVE POLICY                      //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+
+namespace {
+void write_save_nodes(rb::XmlWriter* writer) {
+	mxml_write_comment(writer, "Tree Save Policy");
+	mxml_start_element(writer, "save");
+	rb::EventVector_t events = rb::Rint::gApp()->GetEventVector();
+	for(rb::EventVector_t::iterator it = events.begin(); it != events.end(); ++it) {
+		rb::SavePolicy policy = rb::Rint::gApp()->GetEvent(it->first)->GetSavePolicy();
+		mxml_start_element(writer, "policy");
+		mxml_write_attribute(writer, "code",        Form("%d", it->first));
+		mxml_write_attribute(writer, "compression", rb::SavePolicy::AlgorithmName(policy.fAlgorithm));
+		mxml_write_attribute(writer, "level",       Form("%d", policy.fLevel));
+		mxml_write_attribute(writer, "basket",      Form("%d", policy.fBasketSize));
+		mxml_write_attribute(writer, "autoflush",   Form("%lld", policy.fAutoFlush));
+		mxml_write_attribute(writer, "autosave",    Form("%lld", policy.fAutoSave));
+		mxml_write_attribute(writer, "imt",         Form("%d", policy.fImplicitMT));
+		if(!policy.fColumns.empty()) {
+			std::string columns;
+			for(size_t i=0; i< policy.fColumns.size(); ++i)
+				columns += (i ? ", " : "") + policy.fColumns[i];
+			mxml_write_attribute(writer, "columns", columns.c_str());
+		}
+		mxml_end_element(writer);
+	}
+	mxml_end_element(writer);
+}
+
+void read_save_tree(rb::XmlNode* tree) {
+	rb::XmlNode* savenode = rb::mxml_find_node(tree, "save");
+	if(!savenode) return; // optional, older files don't have it
+
+	for(int i=0; i< rb::mxml_get_number_of_children(savenode); ++i) {
+		rb::XmlNode* child = rb::mxml_subnode(savenode, i);
+		if(strcmp(rb::mxml_get_name(child), "policy")) continue;
+		const char* code = rb::mxml_get_attribute(child, "code");
+		if(!code) continue;
+		rb::SavePolicy dflt;
+		const char* attr[] = { "compression", "level", "basket", "autoflush", "autosave", "imt" };
+		const char* val[6];
+		for(int j=0; j< 6; ++j) val[j] = rb::mxml_get_attribute(child, attr[j]);
+		rb::SetSavePolicy(atoi(code),
+											val[0] ? val[0] : "default",
+											val[1] ? atoi(val[1]) : dflt.fLevel,
+											val[2] ? atoi(val[2]) : dflt.fBasketSize,
+											val[3] ? atoll(val[3]) : dflt.fAutoFlush,
+											val[4] ? atoll(val[4]) : dflt.fAutoSave,
+											val[5] ? atoi(val[5]) : dflt.fImplicitMT);
+		const char* columns = rb::mxml_get_attribute(child, "columns");
+		rb::SetSaveColumns(atoi(code), columns ? columns : "");
+	}
+} }
+
+
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // XML ALL                              //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
@@ -595,6 +651,7 @@ Int_t rb::WriteConfigXML(const char* filename, Bool_t prompt) {
 	write_hist_nodes(writer);
 	write_canvas_nodes(writer);
 	write_variable_nodes(writer);
+	write_save_nodes(writer);
 
 	mxml_close_file(writer);
 	return 0;
@@ -613,6 +670,7 @@ void rb::ReadConfigXML(const char* filename, Option_t* option) {
 		read_hist_tree(tree, option, true);
 		read_canvas_tree(tree, true);
 		read_variables_tree(tree, true);
+		read_save_tree(tree);
 	}
 
 	if(tree) rb::mxml_free_tree(tree);
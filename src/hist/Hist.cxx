@@ -1,8 +1,13 @@
 //! \file Hist.cxx
 //! \brief Implements the histogram class member functions.
 #include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <TTimeStamp.h>
+#include <TVirtualMutex.h>
 #include "boost/dynamic_bitset.hpp"
 #include "Hist.hxx"
 #include "Formula.hxx"
@@ -10,6 +15,7 @@
 #include "Signals.hxx"
 #include "Rootbeer.hxx"
 #include "mxml/mxml.hxx"
+#include "utils/Assorted.hxx"
 
 typedef std::vector<std::string> StringVector_t;
 
@@ -18,19 +24,20 @@ typedef std::vector<std::string> StringVector_t;
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 namespace
 {
-  // Name checking function
+  // Name checking function; looks names up in the histogram managers' hashed
+  // indices (rb::Rint::FindHistogram()) rather than scanning every ROOT directory
   inline std::string check_name(const char* name) {
     std::string ret = name;
-    if(gROOT->FindObject(name)) {
+    if(rb::Rint::gApp()->FindHistogram(name)) {
       Int_t n = 1;
       while(1) {
 	std::stringstream sstr;
 	sstr << name << "_" << n++;
 	ret = sstr.str();
-	if(!gROOT->FindObject(ret.c_str())) break;
+	if(!rb::Rint::gApp()->FindHistogram(ret.c_str())) break;
       }
       rb::err::Info("rb::hist::Base") << "The name " << name <<
-	" is already in use, creating " << name << "_" << n-1 << " instead.";
+	" is already in use, creating " << ret << " instead.";
     }
     return ret;
   }
@@ -64,6 +71,92 @@ namespace
 		   << ndimensions << " dimensional histogram.";
     return par;
   }
+  // Is the storage argument "sparse" (any case)?
+  inline Bool_t is_sparse(Option_t* storage) {
+    return storage && !TString(storage).CompareTo("sparse", TString::kIgnoreCase);
+  }
+  // Storage code from a user argument ("D", "F", "I", "S" or "C", any case; "sparse" bins are doubles)
+  inline Char_t storage_code(Option_t* storage) {
+    if(!storage || !*storage || is_sparse(storage)) return 'D';
+    const Char_t code = toupper(storage[0]);
+    if(storage[1] != 0 || !strchr("DFISC", code))
+      rb::err::Throw() << "Invalid bin storage specification: \"" << storage
+		       << "\" (must be one of \"D\", \"F\", \"I\", \"S\", \"C\" or \"sparse\").";
+    return code;
+  }
+  // Bin content at which a storage type stops counting exactly (0 = never)
+  inline Double_t storage_limit(Char_t code) {
+    switch(code) {
+    case 'C': return 127;
+    case 'S': return 32767;
+    case 'I': return 2147483647;
+    case 'F': return 16777216; // 2^24
+    default:  return 0;
+    }
+  }
+  // Next wider storage type
+  inline Char_t wider_storage(Char_t code) {
+    switch(code) {
+    case 'C': return 'S';
+    case 'S': return 'I';
+    default:  return 'D';
+    }
+  }
+  // Create the histogram variant with the requested storage; for sparse storage only the
+  // axes are set, with a single bin allocated (the contents go in rb::hist::Base::fSparse)
+  inline rb::HistVariant make_hist(Option_t* storage, const char* name, const char* title,
+				   Int_t bx, Double_t xl, Double_t xh) {
+    if(is_sparse(storage)) {
+      TH1D shape(name, title, 1, xl, xh);
+      shape.GetXaxis()->Set(bx, xl, xh);
+      return shape;
+    }
+    switch(storage_code(storage)) {
+    case 'F': return TH1F(name, title, bx, xl, xh);
+    case 'I': return TH1I(name, title, bx, xl, xh);
+    case 'S': return TH1S(name, title, bx, xl, xh);
+    case 'C': return TH1C(name, title, bx, xl, xh);
+    default:  return TH1D(name, title, bx, xl, xh);
+    }
+  }
+  inline rb::HistVariant make_hist(Option_t* storage, const char* name, const char* title,
+				   Int_t bx, Double_t xl, Double_t xh,
+				   Int_t by, Double_t yl, Double_t yh) {
+    if(is_sparse(storage)) {
+      TH2D shape(name, title, 1, xl, xh, 1, yl, yh);
+      shape.GetXaxis()->Set(bx, xl, xh);
+      shape.GetYaxis()->Set(by, yl, yh);
+      return shape;
+    }
+    switch(storage_code(storage)) {
+    case 'F': return TH2F(name, title, bx, xl, xh, by, yl, yh);
+    case 'I': return TH2I(name, title, bx, xl, xh, by, yl, yh);
+    case 'S': return TH2S(name, title, bx, xl, xh, by, yl, yh);
+    case 'C': return TH2C(name, title, bx, xl, xh, by, yl, yh);
+    default:  return TH2D(name, title, bx, xl, xh, by, yl, yh);
+    }
+  }
+  inline rb::HistVariant make_hist(Option_t* storage, const char* name, const char* title,
+				   Int_t bx, Double_t xl, Double_t xh,
+				   Int_t by, Double_t yl, Double_t yh,
+				   Int_t bz, Double_t zl, Double_t zh) {
+    if(is_sparse(storage)) {
+      TH3D shape(name, title, 1, xl, xh, 1, yl, yh, 1, zl, zh);
+      shape.GetXaxis()->Set(bx, xl, xh);
+      shape.GetYaxis()->Set(by, yl, yh);
+      shape.GetZaxis()->Set(bz, zl, zh);
+      return shape;
+    }
+    switch(storage_code(storage)) {
+    case 'F': return TH3F(name, title, bx, xl, xh, by, yl, yh, bz, zl, zh);
+    case 'I': return TH3I(name, title, bx, xl, xh, by, yl, yh, bz, zl, zh);
+    case 'S': return TH3S(name, title, bx, xl, xh, by, yl, yh, bz, zl, zh);
+    case 'C': return TH3C(name, title, bx, xl, xh, by, yl, yh, bz, zl, zh);
+    default:  return TH3D(name, title, bx, xl, xh, by, yl, yh, bz, zl, zh);
+    }
+  }
+  // Most cells a sparse histogram is copied into densely (2^24 doubles, 128 MB), see rb::hist::Base::Densify()
+  const Double_t kMaxDenseCells = 16777216;
 }
 
 
@@ -79,10 +172,15 @@ Bool_t rb::hist::Base::fgOverwrite = false;
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 rb::hist::Base::Base(const char* name, const char* title, const char* param, const char* gate,
 		     hist::Manager* manager, Int_t event_code,
-		     Int_t nbinsx, Double_t xlow, Double_t xhigh):
-  kEventCode(event_code), kDimensions(1), fManager(manager), fHistogramClone(0), kInitialParams(param), fParams(0), fGate(0),
-  fHistVariant(TH1D(name, title, nbinsx, xlow, xhigh))
-{  }
+		     Int_t nbinsx, Double_t xlow, Double_t xhigh, Option_t* storage):
+  kEventCode(event_code), kDimensions(1), fManager(manager), fHistogramClone(0), fGeneration(0), fCloneGeneration(0), fCloneLag(0), fNameHash(0), kInitialParams(param), fParams(0), fGate(0),
+  fHistVariant(new HistVariant(make_hist(storage, name, title, nbinsx, xlow, xhigh))),
+  fTarget(visit::hist::Cast::Do(*fHistVariant)),
+  fLimit(storage_limit(storage_code(storage)))
+{
+  fVariants.push_back(fHistVariant);
+  if(is_sparse(storage)) InitSparse();
+}
 
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // Constructor (2d)                                      //
@@ -90,10 +188,15 @@ rb::hist::Base::Base(const char* name, const char* title, const char* param, con
 rb::hist::Base::Base(const char* name, const char* title, const char* param, const char* gate,
 		     hist::Manager* manager, Int_t event_code,
 		     Int_t nbinsx, Double_t xlow, Double_t xhigh,
-		     Int_t nbinsy, Double_t ylow, Double_t yhigh):
-  kEventCode(event_code), kDimensions(2), fManager(manager), fHistogramClone(0), kInitialParams(param), fParams(0), fGate(0),
-  fHistVariant(TH2D(name, title, nbinsx, xlow, xhigh, nbinsy, ylow, yhigh))
-{  }
+		     Int_t nbinsy, Double_t ylow, Double_t yhigh, Option_t* storage):
+  kEventCode(event_code), kDimensions(2), fManager(manager), fHistogramClone(0), fGeneration(0), fCloneGeneration(0), fCloneLag(0), fNameHash(0), kInitialParams(param), fParams(0), fGate(0),
+  fHistVariant(new HistVariant(make_hist(storage, name, title, nbinsx, xlow, xhigh, nbinsy, ylow, yhigh))),
+  fTarget(visit::hist::Cast::Do(*fHistVariant)),
+  fLimit(storage_limit(storage_code(storage)))
+{
+  fVariants.push_back(fHistVariant);
+  if(is_sparse(storage)) InitSparse();
+}
 
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // Constructor (3d)                                      //
@@ -102,11 +205,30 @@ rb::hist::Base::Base(const char* name, const char* title, const char* param, con
 		     hist::Manager* manager, Int_t event_code,
 		     Int_t nbinsx, Double_t xlow, Double_t xhigh,
 		     Int_t nbinsy, Double_t ylow, Double_t yhigh,
-		     Int_t nbinsz, Double_t zlow, Double_t zhigh):
-  kEventCode(event_code), kDimensions(3), fManager(manager), fHistogramClone(0), kInitialParams(param), fParams(0), fGate(0),
-  fHistVariant(TH3D(name, title, nbinsx, xlow, xhigh, nbinsy, ylow, yhigh, nbinsz, zlow, zhigh))
-{  }
+		     Int_t nbinsz, Double_t zlow, Double_t zhigh, Option_t* storage):
+  kEventCode(event_code), kDimensions(3), fManager(manager), fHistogramClone(0), fGeneration(0), fCloneGeneration(0), fCloneLag(0), fNameHash(0), kInitialParams(param), fParams(0), fGate(0),
+  fHistVariant(new HistVariant(make_hist(storage, name, title, nbinsx, xlow, xhigh, nbinsy, ylow, yhigh, nbinsz, zlow, zhigh))),
+  fTarget(visit::hist::Cast::Do(*fHistVariant)),
+  fLimit(storage_limit(storage_code(storage)))
+{
+  fVariants.push_back(fHistVariant);
+  if(is_sparse(storage)) InitSparse();
+}
 
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::hist::Base::InitSparse()                     //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Base::InitSparse() {
+  const TH1* shape = visit::hist::Cast::Do(*fHistVariant);
+  const TAxis* axes[3] = { shape->GetXaxis(), shape->GetYaxis(), shape->GetZaxis() };
+  Int_t bins[3]; Double_t low[3], high[3];
+  for(UInt_t i=0; i< kDimensions; ++i) {
+    bins[i] = axes[i]->GetNbins();
+    low[i]  = axes[i]->GetXmin();
+    high[i] = axes[i]->GetXmax();
+  }
+  fSparse.reset(new THnSparseD("sparse", "", kDimensions, bins, low, high));
+}
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // void rb::hist::Base::Init()                           //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
@@ -114,7 +236,7 @@ void rb::hist::Base::Init(const char* name, const char* title, const char* param
   // Set name & title
   if(!fgOverwrite) fName = check_name(name).c_str();
 	else {
-		Base* hist_base = dynamic_cast<Base*>(gROOT->FindObject(name));
+		Base* hist_base = Rint::gApp()->FindHistogram(name);
 		if(hist_base) delete hist_base;
 		fName = name;
 	}
@@ -124,7 +246,7 @@ void rb::hist::Base::Init(const char* name, const char* title, const char* param
 
 	std::stringstream sstr;
 	sstr << std::hex << "(rb::hist::Base*)" << this;
-  visit::hist::DoMember(fHistVariant, &TH1::SetNameTitle, sstr.str().c_str() /*fName.Data()*/, fTitle.Data());
+  AsTH1()->SetNameTitle(sstr.str().c_str() /*fName.Data()*/, fTitle.Data());
 
   // Set gate and parameters
   InitParams(param, event_code);
@@ -133,8 +255,11 @@ void rb::hist::Base::Init(const char* name, const char* title, const char* param
   // Add to ROOT container
   if(gDirectory) {
     fDirectory = gDirectory;
-    fDirectory->Append(this, kTRUE);
-		if(Rint::gApp()->GetHistSignals()) Rint::gApp()->GetHistSignals()->NewOrDeleteHist();
+    // The name is unique among histograms by now; in bulk creation skip the directory's own
+    // (linear) search for an object to replace
+    fDirectory->Append(this, !fManager->InBulk());
+		if(Rint::gApp()->GetHistSignals() && !fManager->InBulk())
+			Rint::gApp()->GetHistSignals()->NewOrDeleteHist(); // else sent by Manager::EndBulk()
   }
   else {
     rb::err::Warning("Hist::Init") << "gDirectory == 0; not adding to any ROOT collections.";
@@ -146,7 +271,21 @@ void rb::hist::Base::Init(const char* name, const char* title, const char* param
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 rb::hist::Base::~Base() {
 	fManager->Remove(this); // locks TTHREAD_GLOBAL_MUTEX while running
-	if(Rint::gApp()->GetHistSignals()) Rint::gApp()->GetHistSignals()->NewOrDeleteHist();
+	if(Rint::gApp()->GetHistSignals() && !fManager->InBulk()) Rint::gApp()->GetHistSignals()->NewOrDeleteHist();
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::hist::Base::SetName()                        //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Base::SetName(const char* name) {
+	if(fManager) fManager->Rename(this, name);
+	else TNamed::SetName(name);
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::hist::Base::SetNameTitle()                   //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Base::SetNameTitle(const char* name, const char* title) {
+	SetName(name);
+	SetTitle(title);
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // void rb::hist::Base::InitParams()                     //
@@ -168,11 +307,12 @@ void rb::hist::Base::InitGate(const char* gate, Int_t event_code) {
 Int_t rb::hist::Base::Regate(const char* newgate) {
   Bool_t success = fGate->Change(0, newgate);
   if(!success) return -1;
+  if(fManager) fManager->InvalidateGateGroups();
 
   // Change title if appropriate
   if(kUseDefaultTitle) {
     fTitle = default_title(fGate->Get(0).c_str(), kInitialParams.c_str()).c_str();
-    visit::hist::DoMember(fHistVariant, &TH1::SetTitle, fTitle.Data());
+    AsTH1()->SetTitle(fTitle.Data());
   }
   return 0;
 }
@@ -180,17 +320,340 @@ Int_t rb::hist::Base::Regate(const char* newgate) {
 // rb::hist::Base::GetHist()                             //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 TH1* rb::hist::Base::GetHist() {
+  Render();
+  // The window moves on without fills: expired slices are left out of the copy, but the
+  // rotation itself is left to the fill thread
+  const Double_t now = fWindow ? TTimeStamp().AsDouble() : 0;
+  const Long64_t lag = fWindow ? fWindow->Due(now) : 0;
+  if(fHistogramClone && fCloneGeneration == fGeneration && fCloneLag == lag) return fHistogramClone.get();
+  const ULong64_t generation = fGeneration; // fills during the copy make the next call copy again
   hist::StopAddDirectory stop_add;
-  visit::hist::Clone::Do(fHistVariant, fHistogramClone);
+  if(fWindow) fHistogramClone.reset(Compose(now));
+  else if(fSparse) fHistogramClone.reset(Densify());
+  else visit::hist::Clone::Do(*fHistVariant, fHistogramClone);
+  fCloneGeneration = generation;
+  fCloneLag = lag;
   return fHistogramClone.get();
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::GetAttributes()                       //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Base::GetAttributes(TAttLine& line, TAttFill& fill, TAttMarker& marker) const {
+  rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
+  fTarget->TAttLine::Copy(line);
+  fTarget->TAttFill::Copy(fill);
+  fTarget->TAttMarker::Copy(marker);
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::Densify() [protected]                 //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+TH1* rb::hist::Base::Densify() {
+	rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
+	const TAxis* axes[3] = { fTarget->GetXaxis(), fTarget->GetYaxis(), fTarget->GetZaxis() };
+	UInt_t ndims = 0; // leading axes that fit in kMaxDenseCells
+	Double_t cells = 1;
+	while(ndims < kDimensions && (cells *= axes[ndims]->GetNbins() + 2) <= kMaxDenseCells) ++ndims;
+	if(ndims < kDimensions) {
+		TH1* projection = 0;
+		if(ndims < 2) projection = fSparse->Projection(0);
+		else projection = fSparse->Projection(1, 0); // y axis first
+		projection->SetNameTitle(GetName(), fTarget->GetTitle());
+		projection->GetXaxis()->SetTitle(axes[0]->GetTitle());
+		if(ndims == 2) projection->GetYaxis()->SetTitle(axes[1]->GetTitle());
+		fTarget->TAttLine::Copy(*projection);
+		fTarget->TAttFill::Copy(*projection);
+		fTarget->TAttMarker::Copy(*projection);
+		return projection;
+	}
+
+	TH1* dense = static_cast<TH1*>(visit::hist::Cast::Do(*fHistVariant)->Clone());
+
+	// Allocate all the bins, keeping the axes
+	const TAxis* ax = dense->GetXaxis(), *ay = dense->GetYaxis(), *az = dense->GetZaxis();
+	switch(kDimensions) {
+	case 1:
+		dense->SetBins(ax->GetNbins(), ax->GetXmin(), ax->GetXmax());
+		break;
+	case 2:
+		dense->SetBins(ax->GetNbins(), ax->GetXmin(), ax->GetXmax(),
+									 ay->GetNbins(), ay->GetXmin(), ay->GetXmax());
+		break;
+	default:
+		dense->SetBins(ax->GetNbins(), ax->GetXmin(), ax->GetXmax(),
+									 ay->GetNbins(), ay->GetXmin(), ay->GetXmax(),
+									 az->GetNbins(), az->GetXmin(), az->GetXmax());
+		break;
+	}
+
+	Int_t coord[3] = { 0, 0, 0 };
+	for(Long64_t i=0; i< fSparse->GetNbins(); ++i) {
+		const Double_t content = fSparse->GetBinContent(i, coord);
+		dense->SetBinContent(dense->GetBin(coord[0], coord[1], coord[2]), content);
+	}
+	dense->ResetStats();
+	dense->SetEntries(fSparse->GetEntries());
+	return dense;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::SparseStub() [protected]              //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+TH1* rb::hist::Base::SparseStub() const {
+	rb::err::Error("rb::hist::Base") << "The bins of the sparse histogram \"" << GetName()
+																	 << "\" aren't held in a TH1, use GetHist() to get a copy of them.";
+	static TH1* stubs[3] = { 0, 0, 0 }; // never deleted
+	const UInt_t i = kDimensions > 1 ? kDimensions - 1 : 0;
+	if(!stubs[i]) {
+		hist::StopAddDirectory stop_add;
+		switch(i) {
+		case 0:  stubs[i] = new TH1D("sparse_stub", "", 1, 0, 1); break;
+		case 1:  stubs[i] = new TH2D("sparse_stub", "", 1, 0, 1, 1, 0, 1); break;
+		default: stubs[i] = new TH3D("sparse_stub", "", 1, 0, 1, 1, 0, 1, 1, 0, 1); break;
+		}
+	}
+	stubs[i]->Reset();
+	return stubs[i];
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::SetWindow()                           //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Bool_t rb::hist::Base::SetWindow(Double_t seconds, Int_t slices) {
+	return InitWindow(seconds, slices, false);
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::SetDecay()                            //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Bool_t rb::hist::Base::SetDecay(Double_t halflife, Int_t steps) {
+	return InitWindow(halflife, steps, true);
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::GetWindow()                           //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Double_t rb::hist::Base::GetWindow() const {
+	return fWindow ? fWindow->fLength : 0;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::IsDecaying()                          //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Bool_t rb::hist::Base::IsDecaying() const {
+	return fWindow && fWindow->fDecay != 0;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::GetWindowSlices()                     //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Int_t rb::hist::Base::GetWindowSlices() const {
+	return fWindow ? fWindow->fNslices : 0;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::InitWindow() [protected]              //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Bool_t rb::hist::Base::InitWindow(Double_t length, Int_t slices, Bool_t decay) {
+	if(fSparse || dynamic_cast<Strip*>(this) || dynamic_cast<Rate*>(this) || dynamic_cast<Scaler*>(this)) {
+		rb::err::Error("rb::hist::Base::SetWindow")
+			<< "Time windows aren't available for sparse, scaler, strip chart or rate histograms.";
+		return false;
+	}
+	rb::ScopedLock<rb::Mutex> set_lock(fManager->fSetMutex); // no fills meanwhile (see Manager::FillAll())
+	rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
+	++fGeneration;
+	if(length <= 0) { // back to accumulating, keeping the contents of the window
+		if(fWindow) {
+			Widen(fWindow->fHistory->GetMaximum() + fTarget->GetMaximum());
+			fTarget->Add(fWindow->fHistory.get());
+			fWindow.reset(0);
+			fManager->InvalidateGateGroups();
+		}
+		return true;
+	}
+	if(slices < 1) slices = 1;
+	if(!decay && slices < 2) slices = 2; // the current slice plus at least one completed one
+
+	hist::StopAddDirectory stop_add;
+	boost::scoped_ptr<hist::Window> window(new hist::Window());
+	window->fLength  = length;
+	window->fNslices = slices;
+	window->fSlice   = length / slices;
+	window->fDecay   = decay ? TMath::Power(0.5, 1. / slices) : 0;
+	window->fNextRotation = TTimeStamp().AsDouble() + window->fSlice;
+	window->fOldest  = 0;
+
+	HistVariant shape; // double storage, whatever the storage of fHistVariant
+	visit::hist::Convert::Do(*fHistVariant, 'D', shape);
+	window->fHistory.reset(static_cast<TH1*>(visit::hist::Cast::Do(shape)->Clone()));
+	window->fHistory->Reset();
+	if(!decay) {
+		for(Int_t i=0; i< slices - 1; ++i)
+			window->fSlices.push_back(static_cast<TH1*>(window->fHistory->Clone()));
+	}
+	if(fWindow) { // changing the window: fold the old history into the current slice
+		Widen(fWindow->fHistory->GetMaximum() + fTarget->GetMaximum());
+		fTarget->Add(fWindow->fHistory.get());
+	}
+	fWindow.swap(window);
+	fManager->InvalidateGateGroups(); // the fill plan lists the histograms to rotate
+	return true;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::Rotate() [protected]                  //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Base::Rotate(Double_t now) {
+	/*!
+	 * Runs on the fill thread only, from Manager::FillAll(), so fills and rotations never overlap.
+	 * If several slices have gone by, the current slice is completed and the rest are empty.
+	 */
+	if(!fWindow || now < fWindow->fNextRotation) return;
+	hist::Window& w = *fWindow;
+	const Long64_t steps = w.Due(now);
+	w.fNextRotation += steps * w.fSlice;
+	++fGeneration;
+
+	if(w.fDecay != 0) {
+		w.fHistory->Scale(w.fDecay);
+		w.fHistory->Add(fTarget);
+		if(steps > 1) w.fHistory->Scale(TMath::Power(w.fDecay, Double_t(steps - 1)));
+	}
+	else if(steps > Long64_t(w.fSlices.size())) { // the whole window has gone by
+		w.fHistory->Reset();
+		for(UInt_t i=0; i< w.fSlices.size(); ++i) w.fSlices[i].Reset();
+	}
+	else { // replace the oldest slices by the one just completed, then by empty ones
+		for(Long64_t i=0; i< steps; ++i) {
+			TH1& oldest = w.fSlices[w.fOldest];
+			w.fHistory->Add(&oldest, -1);
+			oldest.Reset();
+			if(i == 0) {
+				oldest.Add(fTarget);
+				w.fHistory->Add(fTarget);
+			}
+			w.fOldest = (w.fOldest + 1) % w.fSlices.size();
+		}
+	}
+	fTarget->Reset();
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::Compose() [protected]                 //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+TH1* rb::hist::Base::Compose(Double_t now) {
+	/*!
+	 * Mirrors Rotate() for the slices due at \e now: a decaying history is scaled as it would
+	 * be, and a sliding window drops its oldest slices from the sum.
+	 */
+	rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
+	const hist::Window& w = *fWindow;
+	const Long64_t steps = w.Due(now);
+	TH1* sum = static_cast<TH1*>(w.fHistory->Clone());
+	if(w.fDecay != 0) {
+		if(steps > 0) sum->Scale(w.fDecay);
+		sum->Add(fTarget);
+		if(steps > 1) sum->Scale(TMath::Power(w.fDecay, Double_t(steps - 1)));
+	}
+	else if(steps > Long64_t(w.fSlices.size())) { // the whole window has gone by
+		sum->Reset();
+	}
+	else {
+		for(Long64_t i=0; i< steps; ++i)
+			sum->Add(&w.fSlices[(w.fOldest + i) % w.fSlices.size()], -1);
+		sum->Add(fTarget);
+	}
+	sum->SetNameTitle(fTarget->GetName(), fTarget->GetTitle());
+	fTarget->TAttLine::Copy(*sum);
+	fTarget->TAttFill::Copy(*sum);
+	fTarget->TAttMarker::Copy(*sum);
+	return sum;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::ClearWindow() [protected]             //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Base::ClearWindow() {
+	fWindow->fHistory->Reset();
+	for(UInt_t i=0; i< fWindow->fSlices.size(); ++i) fWindow->fSlices[i].Reset();
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::SetStorage()                          //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Bool_t rb::hist::Base::SetStorage(Option_t* storage) {
+	Char_t code;
+	try { code = storage_code(storage); }
+	catch (std::exception& e) {
+		rb::err::Error("rb::hist::Base::SetStorage") << e.what();
+		return false;
+	}
+	rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
+	if(fSparse || is_sparse(storage)) {
+		if(fSparse && is_sparse(storage)) return true;
+		rb::err::Error("rb::hist::Base::SetStorage")
+			<< "Sparse storage can only be chosen when \"" << GetName() << "\" is created.";
+		return false;
+	}
+	if(code == GetStorage()) return true;
+	const Double_t limit = storage_limit(code);
+	if(limit != 0 && visit::hist::MaxContent::Do(*fHistVariant) >= limit) {
+		rb::err::Error("rb::hist::Base::SetStorage")
+			<< "The bin contents of \"" << GetName() << "\" don't fit in storage \"" << storage << "\".";
+		return false;
+	}
+	ConvertStorage(code);
+	fVariants.erase(fVariants.begin(), fVariants.end() - 1); // asked for: drop the old storage
+	return true;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::GetStorage()                          //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Char_t rb::hist::Base::GetStorage() const {
+	return visit::hist::Storage::Do(*fHistVariant);
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::Promote() [protected]                 //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Base::Promote() {
+	const Char_t code = wider_storage(GetStorage());
+	rb::err::Info("rb::hist::Base") << "Promoting the bins of \"" << GetName()
+																	<< "\" to storage \"" << code << "\" to avoid overflow.";
+	ConvertStorage(code);
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::WidenBin() [protected]                //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Base::WidenBin(Int_t bin, Double_t w) {
+	if(fLimit != 0) Widen(TMath::Abs(fTarget->GetBinContent(bin)) + TMath::Abs(w));
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::WidenBins() [protected]               //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Base::WidenBins(Double_t w) {
+	if(fLimit != 0) Widen(visit::hist::MaxContent::Do(*fHistVariant) + TMath::Abs(w));
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::WidenAll() [protected]                //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Base::WidenAll() {
+	if(fLimit == 0) return;
+	rb::err::Info("rb::hist::Base") << "Promoting the bins of \"" << GetName()
+																	<< "\" to storage \"D\" to avoid overflow.";
+	ConvertStorage('D');
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::ConvertStorage() [protected]          //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Base::ConvertStorage(Char_t code) {
+	hist::StopAddDirectory stop_add;
+	HistVariant* converted = new HistVariant();
+	fVariants.push_back(converted); // keeps the old variant alive for whoever still points into it
+	visit::hist::Convert::Do(*fHistVariant, code, *converted);
+	TH1* old = visit::hist::Cast::Do(*fHistVariant);
+	old->SetBinsLength(0); // the superseded TH1 stays, its bins don't
+	old->GetSumw2()->Set(0);
+	fHistVariant = converted;
+	fTarget = visit::hist::Cast::Do(*fHistVariant);
+	++fGeneration;
+	fLimit = storage_limit(code);
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // rb::hist::Base::DoFill() [virtual]                    //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 Int_t rb::hist::Base::DoFill(const std::vector<Double_t>& params) {
   std::vector<Double_t> axes(params.begin(), params.end());
   for(Int_t i=axes.size(); i< 3; ++i) axes.push_back(0);
-  return visit::hist::Fill::Do(fHistVariant, axes[0], axes[1], axes[2]);
+  return FillHist(axes[0], axes[1], axes[2]);
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // rb::hist::Base::FillUnlocked()                        //
@@ -214,10 +677,82 @@ Int_t rb::hist::Base::Fill() {
   return DoFill(axes);
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::Collect()                             //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Base::Collect() {
+  Double_t gate = fGate->Eval(0);
+  if(!Bool_t(gate)) return;
+  std::vector<Double_t> axes;
+  fParams->EvalAll(axes);
+  CollectValues(axes);
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::CollectValues()                       //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Base::CollectValues(const std::vector<Double_t>& axes) {
+  if(fBatch.size() != axes.size()) fBatch.resize(axes.size());
+  for(UInt_t i=0; i< axes.size(); ++i) fBatch[i].push_back(axes[i]);
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::FlushBatch()                          //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Int_t rb::hist::Base::FlushBatch() {
+	if(fBatch.empty() || fBatch[0].empty()) return 0;
+	Int_t ret = DoFillBatch();
+	ClearBatch();
+	return ret;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::ClearBatch()                          //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Base::ClearBatch() {
+	for(UInt_t i=0; i< fBatch.size(); ++i) fBatch[i].clear(); // keeps capacity
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::ProfileFormulae()                     //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Base::ProfileFormulae(std::vector<rb::FormulaProfile>& out, Int_t nloops) {
+	for(Int_t i=0; i< fParams->GetN(); ++i) {
+		std::stringstream role;
+		role << "param " << i;
+		out.push_back(fParams->Profile(i, nloops));
+		out.back().fOwner = GetName();
+		out.back().fRole = role.str();
+	}
+	out.push_back(fGate->Profile(0, nloops));
+	out.back().fOwner = GetName();
+	out.back().fRole = "gate";
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Base::DoFillBatch() [virtual]               //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Int_t rb::hist::Base::DoFillBatch() {
+	Int_t ret = 0;
+	std::vector<Double_t> params(fBatch.size());
+	for(UInt_t row = 0; row< fBatch[0].size(); ++row) {
+		for(UInt_t col = 0; col< fBatch.size(); ++col) params[col] = fBatch[col][row];
+		ret += DoFill(params);
+	}
+	return ret;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // rb::hist::Base::Write()                               //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 Int_t rb::hist::Base::Write(const char* name, Int_t option, Int_t bufsize) {
-	return visit::hist::Write::Do(fHistVariant, name, option, bufsize);
+	Render();
+	if(fSparse) { // as is, densifying could take far more memory than the filled bins
+		rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
+		fSparse->SetTitle(fTarget->GetTitle());
+		const TAxis* axes[3] = { fTarget->GetXaxis(), fTarget->GetYaxis(), fTarget->GetZaxis() };
+		for(UInt_t i=0; i< kDimensions; ++i) fSparse->GetAxis(i)->SetTitle(axes[i]->GetTitle());
+		return fSparse->Write(name ? name : GetName(), option, bufsize);
+	}
+	if(fWindow) {
+		hist::StopAddDirectory stop_add;
+		boost::scoped_ptr<TH1> composed(Compose(TTimeStamp().AsDouble()));
+		return composed->Write(name, option, bufsize);
+	}
+	return visit::hist::Write::Do(*fHistVariant, name, option, bufsize);
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // rb::hist::Base::WriteXML()                            //
@@ -229,7 +764,7 @@ void rb::hist::Base::WriteXML(rb::XmlWriter*) {
 }
 
 Bool_t rb::hist::Base::CompareTH1 (TH1* th1) {
-	TH1* this_ = visit::hist::Cast::Do(fHistVariant);
+	TH1* this_ = visit::hist::Cast::Do(*fHistVariant);
 	if(th1 == this_) return true;
 	else return false;
 }
@@ -313,13 +848,13 @@ void rb::hist::Summary::InitParams(const char* param, Int_t event_code) {
   TAxis* paxis = 0;
   if(kOrientation == VERTICAL) {
     visit::hist::DoMember<void, HistVariant, TH1, Int_t, Double_t, Double_t, Int_t, Double_t, Double_t>
-      (fHistVariant, &TH1::SetBins, npar, 0, npar, fBins, fLow, fHigh);
-    paxis = visit::hist::DoConstMember(fHistVariant, &TH1::GetXaxis);
+      (*fHistVariant, &TH1::SetBins, npar, 0, npar, fBins, fLow, fHigh);
+    paxis = visit::hist::DoConstMember(*fHistVariant, &TH1::GetXaxis);
   }
   else {
     visit::hist::DoMember<void, HistVariant, TH1, Int_t, Double_t, Double_t, Int_t, Double_t, Double_t>
-      (fHistVariant, &TH1::SetBins, fBins, fLow, fHigh, npar, 0, npar);
-    paxis = visit::hist::DoConstMember(fHistVariant, &TH1::GetYaxis);
+      (*fHistVariant, &TH1::SetBins, fBins, fLow, fHigh, npar, 0, npar);
+    paxis = visit::hist::DoConstMember(*fHistVariant, &TH1::GetYaxis);
   }
   if(paxis) paxis->SetNdivisions(119);
 }
@@ -330,9 +865,196 @@ Int_t rb::hist::Summary::DoFill(const std::vector<Double_t>& params) {
   Int_t ret = 0;
   for(UInt_t i=0; i< params.size(); ++i) {
     if(kOrientation == VERTICAL)
-      ret += visit::hist::Fill::Do(fHistVariant, i, params[i], 0);
+      ret += FillHist(i, params[i]);
     else
-      ret += visit::hist::Fill::Do(fHistVariant, params[i], i, 0);
+      ret += FillHist(params[i], i);
+  }
+  return ret;
+}
+
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Class                                                 //
+// rb::hist::Family                                      //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+namespace
+{
+  // Number of channels in the parameter argument of a histogram family; every axis needs the same number
+  inline Int_t family_channels(const char* param, Int_t dims) {
+    StringVector_t lists = parse_params(param, dims);
+    const Int_t n = parse_multiple_params(lists[0].c_str()).size();
+    for(UInt_t i=1; i< lists.size(); ++i) {
+      if(Int_t(parse_multiple_params(lists[i].c_str()).size()) != n)
+	rb::err::Throw() << "Invalid parameter specification: \"" << param
+			 << "\" (every axis of a histogram family needs the same number of channels).";
+    }
+    if(n == 0) rb::err::Throw() << "Invalid parameter specification: \"" << param << "\" (no channels).";
+    return n;
+  }
+}
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Constructor (1d channels)                             //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::hist::Family::Family (const char* name, const char* title, const char* param, const char* gate,
+			  hist::Manager* manager, Int_t event_code,
+			  Int_t nbins, Double_t low, Double_t high, Option_t* storage):
+  Base(name, title, param, gate, manager, event_code, nbins, low, high,
+       family_channels(param, 1), 0, family_channels(param, 1), storage),
+  kNchannels(family_channels(param, 1)), kChannelDims(1)
+{  }
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Constructor (2d channels)                             //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::hist::Family::Family (const char* name, const char* title, const char* param, const char* gate,
+			  hist::Manager* manager, Int_t event_code,
+			  Int_t nbinsx, Double_t xlow, Double_t xhigh,
+			  Int_t nbinsy, Double_t ylow, Double_t yhigh, Option_t* storage):
+  Base(name, title, param, gate, manager, event_code, nbinsx, xlow, xhigh, nbinsy, ylow, yhigh,
+       family_channels(param, 2), 0, family_channels(param, 2), storage),
+  kNchannels(family_channels(param, 2)), kChannelDims(2)
+{  }
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::hist::Family::InitParams() [virtual]         //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Family::InitParams(const char* param, Int_t event_code) {
+  fParamArgs = parse_params(param, kChannelDims);
+  fChannelParams.clear();
+  for(StringVector_t::iterator it = fParamArgs.begin(); it != fParamArgs.end(); ++it) {
+    StringVector_t pars = parse_multiple_params(it->c_str());
+    fChannelParams.insert(fChannelParams.end(), pars.begin(), pars.end());
+  }
+  StringVector_t pars(fChannelParams);
+  fParams.reset(new rb::TreeFormulae(pars, event_code));
+
+  TAxis* caxis = kChannelDims == 1 ? fTarget->GetYaxis() : fTarget->GetZaxis();
+  caxis->SetTitle("channel");
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Int_t rb::hist::Family::RegateChannels()              //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Int_t rb::hist::Family::RegateChannels(const char* channel_gate) {
+  const std::string arg = channel_gate ? channel_gate : "";
+  StringVector_t pars(fChannelParams);
+  if(!arg.empty())
+    for(Int_t c = 0; c< kNchannels; ++c) pars.push_back(channel_string(arg.c_str(), c));
+
+  boost::scoped_ptr<rb::TreeFormulae> params;
+  try {
+    params.reset(new rb::TreeFormulae(pars, kEventCode));
+  }
+  catch (std::exception& e) {
+    rb::err::Error("rb::hist::Family::RegateChannels") << e.what();
+    return -1;
+  }
+
+  // The fill thread evaluates fParams into slots sized by its fill plan, so the swap is left
+  // to it (ApplyPending(), just before the plan is rebuilt) rather than done here
+  {
+    R__LOCKGUARD2(gCINTMutex);
+    fPendingParams.swap(params);
+    fChannelGateArg = arg;
+  }
+  fManager->InvalidateGateGroups();
+  return 0;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::hist::Family::ApplyPending() [virtual]       //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Family::ApplyPending() {
+  R__LOCKGUARD2(gCINTMutex);
+  if(!fPendingParams) return;
+  FlushBatch(); // stored rows have the old number of columns
+  fParams.swap(fPendingParams);
+  fPendingParams.reset();
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Family::DoFill() [virtual]                  //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Int_t rb::hist::Family::DoFill(const std::vector<Double_t>& params) {
+  const Double_t* x = &params[0], *y = x + kNchannels, *gates = x + kChannelDims * kNchannels;
+  const Bool_t gated = Int_t(params.size()) > kChannelDims * kNchannels;
+  Int_t ret = 0;
+  for(Int_t c = 0; c< kNchannels; ++c) {
+    if(gated && !Bool_t(gates[c])) continue;
+    if(kChannelDims == 1)
+      ret += FillHist(x[c], c);
+    else
+      ret += FillHist(x[c], y[c], c);
+  }
+  return ret;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Family::GetParam() [virtual]                //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+std::string rb::hist::Family::GetParam(Int_t axis) {
+  if(axis < 0 || axis >= kChannelDims) {
+    err::Error("GetParam") << "Invalid axis specification: " << axis
+			   << " (must be in the range of 0 - " << kChannelDims-1 << ")";
+    return "";
+  }
+  return fParamArgs[axis];
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// TH1* rb::hist::Family::GetChannel()                   //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+TH1* rb::hist::Family::GetChannel(Int_t channel) {
+  if(channel < 0 || channel >= kNchannels) {
+    err::Error("rb::hist::Family::GetChannel") << "Invalid channel: " << channel
+					      << " (must be in the range of 0 - " << kNchannels-1 << ")";
+    return 0;
+  }
+  hist::StopAddDirectory stop_add;
+  boost::scoped_ptr<TH1> dense;
+  if(fWindow) dense.reset(Compose(TTimeStamp().AsDouble()));
+  rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
+  const TH1* source = dense ? dense.get() : fTarget; // for sparse storage, just the axes
+
+  std::stringstream name, title;
+  name  << GetName()  << "_" << channel;
+  title << GetTitle() << " [" << channel << "]";
+  const TAxis* ax = source->GetXaxis(), *ay = source->GetYaxis();
+  TH1* out = 0;
+  if(kChannelDims == 1)
+    out = new TH1D(name.str().c_str(), title.str().c_str(), ax->GetNbins(), ax->GetXmin(), ax->GetXmax());
+  else
+    out = new TH2D(name.str().c_str(), title.str().c_str(), ax->GetNbins(), ax->GetXmin(), ax->GetXmax(),
+		   ay->GetNbins(), ay->GetXmin(), ay->GetXmax());
+  if(fSparse) { // pick the channel's filled bins out of fSparse
+    Int_t coord[3] = { 0, 0, 0 };
+    for(Long64_t i=0; i< fSparse->GetNbins(); ++i) {
+      const Double_t content = fSparse->GetBinContent(i, coord);
+      if(coord[kChannelDims] != channel+1) continue;
+      out->SetBinContent(kChannelDims == 1 ? coord[0] : out->GetBin(coord[0], coord[1]), content);
+    }
+  }
+  else if(kChannelDims == 1) {
+    for(Int_t bx = 0; bx <= ax->GetNbins()+1; ++bx)
+      out->SetBinContent(bx, source->GetBinContent(source->GetBin(bx, channel+1)));
+  }
+  else {
+    for(Int_t by = 0; by <= ay->GetNbins()+1; ++by)
+      for(Int_t bx = 0; bx <= ax->GetNbins()+1; ++bx)
+	out->SetBinContent(out->GetBin(bx, by), source->GetBinContent(source->GetBin(bx, by, channel+1)));
+  }
+  source->TAttLine::Copy(*out);
+  source->TAttFill::Copy(*out);
+  source->TAttMarker::Copy(*out);
+  out->ResetStats();
+  return out;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// rb::hist::Family::Write()                             //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Int_t rb::hist::Family::Write(const char* name, Int_t option, Int_t bufsize) {
+  if(fSparse) return Base::Write(name, option, bufsize);
+  const std::string base = name ? name : GetName();
+  Int_t ret = 0;
+  for(Int_t c = 0; c< kNchannels; ++c) {
+    boost::scoped_ptr<TH1> channel(GetChannel(c));
+    ret += channel->Write(channel_string((base + "_%d").c_str(), c).c_str(), option, bufsize);
   }
   return ret;
 }
@@ -348,8 +1070,8 @@ Int_t rb::hist::Summary::DoFill(const std::vector<Double_t>& params) {
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 rb::hist::Gamma::Gamma (const char* name, const char* title, const char* param, const char* gate,
 			hist::Manager* manager, Int_t event_code,
-			Int_t nbins, Double_t low, Double_t high):
-  Base(name, title, param, gate, manager, event_code, nbins, low, high)
+			Int_t nbins, Double_t low, Double_t high, Option_t* storage):
+  Base(name, title, param, gate, manager, event_code, nbins, low, high, storage)
 {  }
 
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
@@ -359,8 +1081,8 @@ rb::hist::Gamma::Gamma (const char* name, const char* title, const char* param,
 			hist::Manager* manager, Int_t event_code,
 			Int_t nbinsx, Double_t xlow, Double_t xhigh,
 			Int_t nbinsy, Double_t ylow, Double_t yhigh,
-			Int_t nbinsz, Double_t zlow, Double_t zhigh):
-  Base(name, title, param, gate, manager, event_code, nbinsx, xlow, xhigh, nbinsy, ylow, yhigh, nbinsz, zlow, zhigh)
+			Int_t nbinsz, Double_t zlow, Double_t zhigh, Option_t* storage):
+  Base(name, title, param, gate, manager, event_code, nbinsx, xlow, xhigh, nbinsy, ylow, yhigh, nbinsz, zlow, zhigh, storage)
 {  }
 
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
@@ -369,8 +1091,8 @@ rb::hist::Gamma::Gamma (const char* name, const char* title, const char* param,
 rb::hist::Gamma::Gamma (const char* name, const char* title, const char* param, const char* gate,
 			hist::Manager* manager, Int_t event_code,
 			Int_t nbinsx, Double_t xlow, Double_t xhigh,
-			Int_t nbinsy, Double_t ylow, Double_t yhigh):
-  Base(name, title, param, gate, manager, event_code, nbinsx, xlow, xhigh, nbinsy, ylow, yhigh)
+			Int_t nbinsy, Double_t ylow, Double_t yhigh, Option_t* storage):
+  Base(name, title, param, gate, manager, event_code, nbinsx, xlow, xhigh, nbinsy, ylow, yhigh, storage)
 {  }
 
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
@@ -402,7 +1124,7 @@ Int_t rb::hist::Gamma::DoFill(const std::vector<Double_t>& params) {
     for(UInt_t j=0; j< kDimensions; ++j) {
       axes[j] = params.at(i+fStops[0]*j);
     }
-    ret += visit::hist::Fill::Do(fHistVariant, axes[0], axes[1], axes[2]);
+    ret += FillHist(axes[0], axes[1], axes[2]);
   }
   return ret;
 }
@@ -430,7 +1152,7 @@ void rb::hist::Bit::InitParams(const char* params, Int_t event_code) {
   std::vector<std::string> par(1, params);
   fParams.reset(new rb::TreeFormulae(par, event_code));
 
-  TAxis* paxis = visit::hist::DoConstMember(fHistVariant, &TH1::GetXaxis);
+  TAxis* paxis = visit::hist::DoConstMember(*fHistVariant, &TH1::GetXaxis);
   if(paxis) paxis->SetNdivisions(119);
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
@@ -441,7 +1163,7 @@ Int_t rb::hist::Bit::DoFill(const std::vector<Double_t>& params) {
   boost::dynamic_bitset<> bits(kNumBits, (unsigned long)params[0]);
   for(Int_t i=0; i< kNumBits; ++i) {
     if(bits[i]) {
-      visit::hist::Fill::Do(fHistVariant, i, 0, 0);
+      FillHist(i);
       ++ret;
     }
   }
@@ -476,7 +1198,9 @@ void rb::hist::Scaler::Clear(Option_t* option) {
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 Int_t rb::hist::Scaler::DoFill(const std::vector<Double_t>& params) {
 	// this->Extend(1.5);
-	visit::hist::SetBinContent::Do(fHistVariant, 1 + fNumEvents++, params[0]);
+	Widen(params[0]);
+	++fGeneration;
+	visit::hist::SetBinContent::Do(*fHistVariant, 1 + fNumEvents++, params[0]);
 	return params[0];
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
@@ -484,7 +1208,7 @@ Int_t rb::hist::Scaler::DoFill(const std::vector<Double_t>& params) {
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 void rb::hist::Scaler::Extend(double factor) {
 	rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-	TH1* pHist = visit::hist::Cast::Do(fHistVariant);
+	TH1* pHist = AsTH1();
 
 	if (pHist->GetNbinsX() <= fNumEvents) {
 		const double Max = pHist->GetBinLowEdge(pHist->GetNbinsX() + 1);
@@ -500,6 +1224,173 @@ void rb::hist::Scaler::Extend(double factor) {
 
 
 
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Class                                                 //
+// rb::hist::Strip                                       //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+namespace
+{
+  // Wall clock time in seconds
+  inline Double_t wall_clock() {
+    return TTimeStamp().AsDouble();
+  }
+  // Slot of the ring holding time t, for slots of the given width
+  inline Long64_t time_slot(Double_t t, Double_t width) {
+    return Long64_t(TMath::Floor(t / width));
+  }
+}
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Constructor                                           //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::hist::Strip::Strip(const char* name, const char* title, const char* param, const char* gate,
+											 hist::Manager* manager, Int_t event_code,
+											 Int_t nbins, Double_t seconds, Double_t ignored):
+  Base(name, title, param, gate, manager, event_code, nbins, seconds > 0 ? -seconds : -nbins, 0),
+	fRing(nbins), kSpan(seconds > 0 ? seconds : 0), fNumSamples(0), fRenderGeneration(0), fRenderLag(0)
+{  }
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::hist::Strip::InitParams() [virtual]          //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Strip::InitParams(const char* param, Int_t event_code) {
+  StringVector_t par = parse_params(param, tokenize(param, ':').size() == 2 ? 2 : 1);
+  fParams.reset(new rb::TreeFormulae(par, event_code));
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::hist::Strip::Clear() [virtual]               //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Strip::Clear(Option_t* option) {
+	rb::hist::Base::Clear(option);
+	fRing.Clear();
+	fNumSamples = 0;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// std::string rb::hist::Strip::GetParam() [virtual]     //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+std::string rb::hist::Strip::GetParam(Int_t axis) {
+	if(axis != 0) {
+		err::Error("GetParam")  << "Invalid axis specification; only 0 is allowed for strip chart histograms.";
+		return "";
+	}
+	return GetInitialParams();
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Int_t rb::hist::Strip::DoFill() [virtual]             //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Int_t rb::hist::Strip::DoFill(const std::vector<Double_t>& params) {
+	if(kSpan == 0)
+		fRing.Add(fNumSamples, params.back());
+	else {
+		const Double_t t = params.size() == 2 ? params[0] : wall_clock();
+		fRing.Add(time_slot(t, kSpan / fRing.Size()), params.back());
+	}
+	++fNumSamples;
+	++fGeneration;
+	return 1;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::hist::Strip::Render() [virtual]              //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Strip::Render() {
+	/*!
+	 * Runs on the reading thread, so fRing is left to DoFill(): time moving on without fills
+	 * just shifts the slots to the left by their lag behind the wall clock.
+	 */
+	rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
+	const Bool_t wall = kSpan != 0 && fParams->GetN() == 1;
+	const Long64_t lag = wall ? fRing.Lag(time_slot(wall_clock(), kSpan / fRing.Size())) : 0;
+	if(fRenderGeneration == fGeneration && fRenderLag == lag) return;
+
+	const Int_t nbins = fRing.Size();
+	for(Int_t bin = 1; bin <= nbins; ++bin) {
+		const Long64_t age = nbins - bin - lag;
+		const Double_t n = age < 0 ? 0 : fRing.Count(age);
+		fTarget->SetBinContent(bin, n != 0 ? fRing.Sum(age) / n : 0);
+	}
+	fTarget->SetEntries(fNumSamples);
+	if(lag != fRenderLag) ++fGeneration; // the bins moved without fills, GetHist() copies again
+	fRenderGeneration = fGeneration;
+	fRenderLag = lag;
+}
+
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Class                                                 //
+// rb::hist::Rate                                        //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Constructor                                           //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+rb::hist::Rate::Rate(const char* name, const char* title, const char* param, const char* gate,
+										 hist::Manager* manager, Int_t event_code,
+										 Int_t nbins, Double_t interval, Double_t ignored):
+  Base(name, title, param, gate, manager, event_code, nbins, -nbins * (interval > 0 ? interval : 1), 0),
+	fRing(nbins), kInterval(interval > 0 ? interval : 1), fRenderGeneration(0), fRenderLag(0)
+{  }
+
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::hist::Rate::InitParams() [virtual]           //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Rate::InitParams(const char* param, Int_t event_code) {
+  StringVector_t par;
+  if(std::string(param).find_first_not_of(" \t") != std::string::npos)
+    par = parse_params(param, 1);
+  fParams.reset(new rb::TreeFormulae(par, event_code));
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::hist::Rate::Clear() [virtual]                //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Rate::Clear(Option_t* option) {
+	rb::hist::Base::Clear(option);
+	fRing.Clear();
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// std::string rb::hist::Rate::GetParam() [virtual]      //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+std::string rb::hist::Rate::GetParam(Int_t axis) {
+	if(axis != 0) {
+		err::Error("GetParam")  << "Invalid axis specification; only 0 is allowed for rate histograms.";
+		return "";
+	}
+	return fParams->GetN() ? fParams->Get(0) : "";
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// Int_t rb::hist::Rate::DoFill() [virtual]              //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+Int_t rb::hist::Rate::DoFill(const std::vector<Double_t>& params) {
+	const Double_t t = params.empty() ? wall_clock() : params[0];
+	fRing.Add(time_slot(t, kInterval), 1);
+	++fGeneration;
+	return 1;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::hist::Rate::Render() [virtual]               //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Rate::Render() {
+	/*!
+	 * Like Strip::Render(), reads fRing without advancing it.
+	 */
+	rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
+	const Long64_t lag = fParams->GetN() == 0 ? fRing.Lag(time_slot(wall_clock(), kInterval)) : 0;
+	if(fRenderGeneration == fGeneration && fRenderLag == lag) return;
+
+	const Int_t nbins = fRing.Size();
+	Double_t entries = 0;
+	for(Int_t bin = 1; bin <= nbins; ++bin) {
+		const Long64_t age = nbins - bin - lag;
+		const Double_t counts = age < 0 ? 0 : fRing.Sum(age);
+		fTarget->SetBinContent(bin, counts / kInterval);
+		entries += counts;
+	}
+	fTarget->SetEntries(entries);
+	if(lag != fRenderLag) ++fGeneration; // the bins moved without fills, GetHist() copies again
+	fRenderGeneration = fGeneration;
+	fRenderLag = lag;
+}
+
+
 
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // rb::hist::XXXXX:WriteXML()                            //
@@ -521,16 +1412,23 @@ const char* get_axis(Int_t n) {
 }
 
 void write_attributes(rb::XmlWriter* w, rb::hist::Base* hist) {
-	rb::mxml_write_attribute(w, "linecolor",   Form("%d", hist->GetHist()->GetLineColor()));
-	rb::mxml_write_attribute(w, "linewidth",   Form("%d", hist->GetHist()->GetLineWidth()));
-	rb::mxml_write_attribute(w, "linestyle",   Form("%d", hist->GetHist()->GetLineStyle()));
+	TAttLine line; TAttFill fill; TAttMarker marker;
+	hist->GetAttributes(line, fill, marker);
+	rb::mxml_write_attribute(w, "linecolor",   Form("%d", line.GetLineColor()));
+	rb::mxml_write_attribute(w, "linewidth",   Form("%d", line.GetLineWidth()));
+	rb::mxml_write_attribute(w, "linestyle",   Form("%d", line.GetLineStyle()));
 																												                                
-	rb::mxml_write_attribute(w, "markercolor", Form("%d", hist->GetHist()->GetMarkerColor()));
-	rb::mxml_write_attribute(w, "markersize",  Form("%f", hist->GetHist()->GetMarkerSize ()));
-	rb::mxml_write_attribute(w, "markerstyle", Form("%d", hist->GetHist()->GetMarkerStyle()));
+	rb::mxml_write_attribute(w, "markercolor", Form("%d", marker.GetMarkerColor()));
+	rb::mxml_write_attribute(w, "markersize",  Form("%f", marker.GetMarkerSize ()));
+	rb::mxml_write_attribute(w, "markerstyle", Form("%d", marker.GetMarkerStyle()));
 																												                                
-	rb::mxml_write_attribute(w, "fillcolor",   Form("%d", hist->GetHist()->GetFillColor()));
-	rb::mxml_write_attribute(w, "fillstyle",   Form("%d", hist->GetHist()->GetFillStyle()));
+	rb::mxml_write_attribute(w, "fillcolor",   Form("%d", fill.GetFillColor()));
+	rb::mxml_write_attribute(w, "fillstyle",   Form("%d", fill.GetFillStyle()));
+
+	if(hist->GetWindow() != 0) {
+		rb::mxml_write_attribute(w, hist->IsDecaying() ? "halflife" : "window", Form("%f", hist->GetWindow()));
+		rb::mxml_write_attribute(w, "slices", Form("%d", hist->GetWindowSlices()));
+	}
 }
 
 void write_xml(rb::XmlWriter* w, rb::hist::Base* h, Int_t ndim) {
@@ -549,6 +1447,7 @@ void write_xml(rb::XmlWriter* w, rb::hist::Base* h, Int_t ndim) {
 	mxml_write_attribute(w, "param", h->GetInitialParams());
 	mxml_write_attribute(w, "gate",  h->GetGate().c_str());
 	mxml_write_attribute(w, "event", Form("%d", h->GetEventCode()));
+	mxml_write_attribute(w, "storage", h->IsSparse() ? "sparse" : Form("%c", h->GetStorage()));
 
 	write_attributes(w, h);
 	mxml_end_element(w);
@@ -566,6 +1465,24 @@ void rb::hist::D3::WriteXML(rb::XmlWriter* w) {
 	write_xml(w, this, 3);
 }
 
+Int_t rb::hist::D1::DoFillBatch() {
+	if(fLimit != 0 || fSparse) return Base::DoFillBatch(); // fill one by one
+	++fGeneration;
+	return visit::hist::FillN::Do(*fHistVariant, fBatch[0].size(), &fBatch[0][0]);
+}
+
+Int_t rb::hist::D2::DoFillBatch() {
+	if(fLimit != 0 || fSparse) return Base::DoFillBatch();
+	++fGeneration;
+	return visit::hist::FillN::Do(*fHistVariant, fBatch[0].size(), &fBatch[0][0], &fBatch[1][0]);
+}
+
+Int_t rb::hist::D3::DoFillBatch() {
+	if(fLimit != 0 || fSparse) return Base::DoFillBatch();
+	++fGeneration;
+	return visit::hist::FillN::Do(*fHistVariant, fBatch[0].size(), &fBatch[0][0], &fBatch[1][0], &fBatch[2][0]);
+}
+
 void rb::hist::Summary::WriteXML(rb::XmlWriter* w) {
 	std::string title = UseDefaultTitle() ? "" : GetTitle();
 
@@ -590,6 +1507,31 @@ void rb::hist::Summary::WriteXML(rb::XmlWriter* w) {
 	mxml_end_element(w);
 }
 
+void rb::hist::Family::WriteXML(rb::XmlWriter* w) {
+	std::string title = UseDefaultTitle() ? "" : GetTitle();
+
+	mxml_start_element(w, "rb_hist_Family");
+	mxml_write_attribute(w, "name", GetName());
+	mxml_write_attribute(w, "title", title.c_str());
+	mxml_write_attribute(w, "dimensions", Form("%d", kChannelDims));
+
+	for(Int_t i=0; i< kChannelDims; ++i) {
+		Int_t nbins = get_axis(this, i)->GetNbins();
+		mxml_write_attribute(w, Form("%sbins",  get_axis(i)), Form("%d", nbins));
+		mxml_write_attribute(w, Form("%slow",   get_axis(i)), Form("%f", get_axis(this, i)->GetBinLowEdge(1)));
+		mxml_write_attribute(w, Form("%shigh",  get_axis(i)), Form("%f", get_axis(this, i)->GetBinLowEdge(nbins+1)));
+	}
+
+	mxml_write_attribute(w, "param", GetInitialParams());
+	mxml_write_attribute(w, "gate",  GetGate().c_str());
+	mxml_write_attribute(w, "channelgate", GetChannelGate());
+	mxml_write_attribute(w, "event", Form("%d", GetEventCode()));
+	mxml_write_attribute(w, "storage", IsSparse() ? "sparse" : Form("%c", GetStorage()));
+
+	write_attributes(w, this);
+	mxml_end_element(w);
+}
+
 void rb::hist::Scaler::WriteXML(rb::XmlWriter* w) {
 	std::string title = UseDefaultTitle() ? "" : GetTitle();
 
@@ -609,6 +1551,42 @@ void rb::hist::Scaler::WriteXML(rb::XmlWriter* w) {
 	mxml_end_element(w);
 }
 
+void rb::hist::Strip::WriteXML(rb::XmlWriter* w) {
+	std::string title = UseDefaultTitle() ? "" : GetTitle();
+
+	mxml_start_element(w, "rb_hist_Strip");
+	mxml_write_attribute(w, "name", GetName());
+	mxml_write_attribute(w, "title", title.c_str());
+
+	mxml_write_attribute(w, "bins", Form("%d", GetXaxis()->GetNbins()));
+	mxml_write_attribute(w, "span", Form("%f", GetSpan()));
+
+	mxml_write_attribute(w, "param", GetInitialParams());
+	mxml_write_attribute(w, "gate",  GetGate().c_str());
+	mxml_write_attribute(w, "event", Form("%d", GetEventCode()));
+
+	write_attributes(w, this);
+	mxml_end_element(w);
+}
+
+void rb::hist::Rate::WriteXML(rb::XmlWriter* w) {
+	std::string title = UseDefaultTitle() ? "" : GetTitle();
+
+	mxml_start_element(w, "rb_hist_Rate");
+	mxml_write_attribute(w, "name", GetName());
+	mxml_write_attribute(w, "title", title.c_str());
+
+	mxml_write_attribute(w, "bins", Form("%d", GetXaxis()->GetNbins()));
+	mxml_write_attribute(w, "interval", Form("%f", GetInterval()));
+
+	mxml_write_attribute(w, "param", GetInitialParams());
+	mxml_write_attribute(w, "gate",  GetGate().c_str());
+	mxml_write_attribute(w, "event", Form("%d", GetEventCode()));
+
+	write_attributes(w, this);
+	mxml_end_element(w);
+}
+
 void rb::hist::Bit::WriteXML(rb::XmlWriter* w) {
 	std::string title = UseDefaultTitle() ? "" : GetTitle();
 
@@ -647,18 +1625,20 @@ rb::hist::Base* construct_hist(rb::XmlNode* node) {
 	const char* param = mxml_get_attribute(node, "param");
 	const char* gate  = mxml_get_attribute(node, "gate");
 	Int_t event  = atoi(mxml_get_attribute(node, "event"));
+	const char* storage = mxml_get_attribute(node, "storage"); // absent in older files
+	if(!storage) storage = "D";
 
 	rb::hist::Base* hst = 0;
 	switch(N) {
 	case 1:
-		hst = rb::hist::New(name, title, bins[0], low[0], high[0], param, gate, event);
+		hst = rb::hist::New(name, title, bins[0], low[0], high[0], param, gate, event, storage);
 		break;
 	case 2:
-		hst = rb::hist::New(name, title, bins[0], low[0], high[0], bins[1], low[1], high[1], param, gate, event);
+		hst = rb::hist::New(name, title, bins[0], low[0], high[0], bins[1], low[1], high[1], param, gate, event, storage);
 		break;
 	case 3:
 		hst = rb::hist::New(name, title, bins[0], low[0], high[0], bins[1], low[1], high[1],
-												bins[2], low[2], high[2], param, gate, event);
+												bins[2], low[2], high[2], param, gate, event, storage);
 		break;
 	default:
 		break;
@@ -696,6 +1676,14 @@ rb::hist::Base* construct_hist1(rb::XmlNode* node) {
 	case 3:
 		hst = rb::hist::NewBit(name, title, bins, param, gate, event);
 		break;
+	case 4:
+		hst = rb::hist::NewStrip(name, title, bins, param, gate, event,
+														 atof(mxml_get_attribute(node, "span")));
+		break;
+	case 5:
+		hst = rb::hist::NewRate(name, title, bins, param, gate, event,
+														atof(mxml_get_attribute(node, "interval")));
+		break;
 	default:
 		break;
 	}
@@ -703,6 +1691,32 @@ rb::hist::Base* construct_hist1(rb::XmlNode* node) {
 	return hst;
 }
 
+rb::hist::Base* construct_family(rb::XmlNode* node) {
+	const char* name  = mxml_get_attribute(node, "name");
+	const char* title = mxml_get_attribute(node, "title");
+	Int_t dims        = atoi(mxml_get_attribute(node, "dimensions"));
+
+	Int_t bins[2]; Double_t low[2], high[2];
+	for(int i=0; i< dims && i< 2; ++i) {
+		bins[i]  = atoi(mxml_get_attribute(node, Form("%sbins",   get_axis(i))));
+		low[i]   = atof(mxml_get_attribute(node, Form("%slow",    get_axis(i))));
+		high[i]  = atof(mxml_get_attribute(node, Form("%shigh",   get_axis(i))));
+	}
+
+	const char* param = mxml_get_attribute(node, "param");
+	const char* gate  = mxml_get_attribute(node, "gate");
+	const char* channel_gate = mxml_get_attribute(node, "channelgate");
+	Int_t event  = atoi(mxml_get_attribute(node, "event"));
+	const char* storage = mxml_get_attribute(node, "storage");
+	if(!channel_gate) channel_gate = "";
+	if(!storage) storage = "D";
+
+	if(dims == 2)
+		return rb::hist::NewFamily(name, title, bins[0], low[0], high[0], bins[1], low[1], high[1],
+															 param, gate, event, channel_gate, storage);
+	return rb::hist::NewFamily(name, title, bins[0], low[0], high[0], param, gate, event, channel_gate, storage);
+}
+
 void set_attributes(rb::XmlNode* node, rb::hist::Base* hist) {
 	const char* lc = rb::mxml_get_attribute(node, "linecolor");
 	const char* lw = rb::mxml_get_attribute(node, "linewidth");
@@ -725,6 +1739,13 @@ void set_attributes(rb::XmlNode* node, rb::hist::Base* hist) {
 
 	if(fc) hist->SetFillColor(atoi(fc));
 	if(fs) hist->SetFillStyle(atoi(fs));
+
+	const char* window   = rb::mxml_get_attribute(node, "window");
+	const char* halflife = rb::mxml_get_attribute(node, "halflife");
+	const char* slices   = rb::mxml_get_attribute(node, "slices");
+	const Int_t nslices  = slices ? atoi(slices) : 10;
+	if(window)   hist->SetWindow(atof(window), nslices);
+	if(halflife) hist->SetDecay(atof(halflife), nslices);
 }
 
 typedef rb::hist::Base* (*XmlReader_t) (rb::XmlNode*);
@@ -740,6 +1761,9 @@ rb::hist::Base* rb::hist::Base::ConstructXML(rb::XmlNode* node, Bool_t replace)
 		readers.insert(std::make_pair("rb_hist_Summary", construct_hist1<1>));
 		readers.insert(std::make_pair("rb_hist_Scaler",  construct_hist1<2>));
 		readers.insert(std::make_pair("rb_hist_Bit",     construct_hist1<3>));
+		readers.insert(std::make_pair("rb_hist_Family",  construct_family));
+		readers.insert(std::make_pair("rb_hist_Strip",   construct_hist1<4>));
+		readers.insert(std::make_pair("rb_hist_Rate",    construct_hist1<5>));
 	}
 
 	rb::hist::Base* hist = 0;
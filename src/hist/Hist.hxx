@@ -10,6 +10,7 @@
 #include <vector>
 #include <bitset>
 #include <set>
+#include <algorithm>
 #include <TFile.h>
 #include <TTree.h>
 #include <TTreeFormula.h>
@@ -17,6 +18,7 @@
 #include <TError.h>
 #include <TObjArray.h>
 #include <TF1.h>
+#include <THnSparse.h>
 #include <TFitResultPtr.h>
 #include <TVirtualHistPainter.h>
 #include "Formula.hxx"
@@ -25,6 +27,7 @@
 #include "utils/LockingPointer.hxx"
 #include "utils/Critical.hxx"
 #include "utils/nocopy.h"
+#include "utils/boost_ptr_vector.h"
 
 
 namespace rb
@@ -50,6 +53,85 @@ struct StopAddDirectory
 	~StopAddDirectory() { BackOn(); }
 };
 
+/// \brief Fixed size ring of time (or sample) slots, for the strip chart and rate histograms.
+//! \details Holds the sum and number of values in each of the last N slots; moving on to a
+//! newer slot zeroes the slots skipped, so memory is fixed and each Add() is O(1) amortized.
+struct Ring
+{
+	/// Sum of the values in each slot
+	std::vector<Double_t> fSum;
+	/// Number of values in each slot
+	std::vector<Double_t> fCount;
+	/// Newest slot
+	Long64_t fHead;
+	/// Has anything been added yet?
+	Bool_t fEmpty;
+
+	Ring(Int_t n): fSum(n > 0 ? n : 1, 0), fCount(n > 0 ? n : 1, 0), fHead(0), fEmpty(true) { }
+	/// Number of slots
+	Long64_t Size() const { return fSum.size(); }
+	/// Position of \e slot in fSum and fCount
+	Long64_t Index(Long64_t slot) const { return ((slot % Size()) + Size()) % Size(); }
+	/// \brief Make \e slot the newest one, zeroing the slots in between.
+	//! \returns true if the head moved
+	Bool_t Advance(Long64_t slot) {
+		if(fEmpty) { fHead = slot; fEmpty = false; return true; }
+		if(slot <= fHead) return false;
+		for(Long64_t s = std::max(fHead + 1, slot - Size() + 1); s <= slot; ++s)
+			fSum[Index(s)] = fCount[Index(s)] = 0;
+		fHead = slot;
+		return true;
+	}
+	/// Add \e value to \e slot; values older than the whole ring are dropped
+	void Add(Long64_t slot, Double_t value) {
+		Advance(slot);
+		if(slot <= fHead - Size()) return;
+		fSum[Index(slot)] += value;
+		fCount[Index(slot)] += 1;
+	}
+	/// Sum of the values in the slot \e age slots before the newest
+	Double_t Sum(Long64_t age) const { return (fEmpty || age >= Size()) ? 0 : fSum[Index(fHead - age)]; }
+	/// Number of values in the slot \e age slots before the newest
+	Double_t Count(Long64_t age) const { return (fEmpty || age >= Size()) ? 0 : fCount[Index(fHead - age)]; }
+	/// Number of slots \e slot is past the newest one (0 if it isn't), i.e. how far Advance(slot) would move
+	Long64_t Lag(Long64_t slot) const { return (fEmpty || slot <= fHead) ? 0 : slot - fHead; }
+	/// Empty all slots
+	void Clear() {
+		std::fill(fSum.begin(), fSum.end(), 0);
+		std::fill(fCount.begin(), fCount.end(), 0);
+		fEmpty = true;
+	}
+};
+
+/// Time window state of a histogram, see rb::hist::Base::SetWindow()
+struct Window;
+#ifndef __MAKECINT__
+struct Window
+{
+	/// Length of the window (sliding) or half life (decaying), in seconds
+	Double_t fLength;
+	/// Number of slices per fLength
+	Int_t fNslices;
+	/// Length of one slice in seconds
+	Double_t fSlice;
+	/// Factor applied to fHistory at each rotation if decaying, 0 for a sliding window
+	Double_t fDecay;
+	/// Wall clock time at which the current slice ends
+	Double_t fNextRotation;
+	/// Sum of the completed slices in the window (or their decayed sum), double storage
+	boost::scoped_ptr<TH1> fHistory;
+	/// Completed slices of a sliding window, as a ring (fNslices - 1 of them)
+	boost::ptr_vector<TH1> fSlices;
+	/// Oldest entry of fSlices
+	Int_t fOldest;
+
+	/// Number of slices that have ended by wall clock time \e now (0 if the current one hasn't)
+	Long64_t Due(Double_t now) const {
+		return now < fNextRotation ? 0 : Long64_t((now - fNextRotation) / fSlice) + 1;
+	}
+};
+#endif
+
 struct LockOnConstruction
 {
 	Bool_t kIsLocked;
@@ -112,6 +194,20 @@ protected:
 	//! conflicts between the main thread and others that can modify the internal histogram.
 	boost::scoped_ptr<TH1> fHistogramClone;
 
+	/// \brief Modification count of the internal histogram.
+	//! \details Incremented by every fill, clear and non-const TH1 member function call.
+	ULong64_t fGeneration;
+
+	/// Value of fGeneration when fHistogramClone was made
+	ULong64_t fCloneGeneration;
+
+	/// Number of slices the time window had gone by without rotating when fHistogramClone was made
+	Long64_t fCloneLag;
+
+	/// \brief Hash of the name this histogram is filed under in fManager's name index.
+	//! \details Set by the manager when indexing, so it can find the entry again after a rename.
+	UInt_t fNameHash;
+
 	/// Default title, set from the parameters and gate condition.
 	std::string kDefaultTitle;
 
@@ -130,36 +226,69 @@ protected:
 	/// Wrapper for the TTreeFormulae to evaluate the gate condition
 	boost::scoped_ptr<rb::TreeFormulae> fGate;
 
-	/// \brief Internal histogram variant.
-	//! \details Variant class covers all possible dimensions from 1-3 in one object.
-	HistVariant fHistVariant;
+	/// \brief Every histogram variant held so far; the last one is fHistVariant.
+	//! \details Variants replaced by an automatic promotion (see Promote()) are kept rather than
+	//! deleted, so that pointers handed out by the TH1 wrappers (axes, functions, ...) stay valid;
+	//! their bin and error arrays are freed though, so only fHistVariant holds bins. There are at
+	//! most three (C to S to I to D); SetStorage() drops them.
+	boost::ptr_vector<HistVariant> fVariants;
+
+	/// \brief Internal histogram variant (owned by fVariants).
+	//! \details Variant class covers all possible dimensions from 1-3 and bin storage types in one object.
+	HistVariant* fHistVariant;
+
+	/// \brief The histogram held by fHistVariant.
+	//! \details Cached so that fills don't visit the variant; reset whenever the variant
+	//! is replaced (see ConvertStorage()).
+	TH1* fTarget;
+
+	/// \brief Bin content at which the storage of fHistVariant is widened (0 for double storage).
+	//! \details E.g. 127 for 8 bit bins: fills stop counting there, so the histogram is promoted
+	//! to 16 bit bins as soon as a bin reaches it (see FillHist()).
+	Double_t fLimit;
+
+	/// \brief Bin contents of histograms created with "sparse" storage, 0 otherwise.
+	//! \details Only the filled bins are stored (in chunks, see THnSparse); fHistVariant then keeps
+	//! just the axes and attributes, with a single bin allocated (so the TH1 wrappers that touch bins
+	//! are refused, see AsBins()). Write() saves fSparse itself, and GetHist() a dense copy built on
+	//! demand by Densify().
+	boost::scoped_ptr<THnSparse> fSparse;
+
+	/// \brief Time window, 0 if the histogram accumulates until cleared (see SetWindow()).
+	//! \details Fills go to fHistVariant, which then holds only the current time slice; completed
+	//! slices are summed in the window's history, and GetHist() and Write() present the sum.
+	boost::scoped_ptr<hist::Window> fWindow;
+
+	/// \brief Parameter values collected in batch mode, one column per parameter.
+	//! \details Only events passing the gate are stored. See rb::hist::Manager::SetBatchSize().
+	std::vector< std::vector<Double_t> > fBatch;
 
 	/// \brief Construction mode for duplicates
 	//! \details true means overwrite duplicate names in the same directory, false means append _1, _2, etc. until unique
 	static Bool_t fgOverwrite;
 
-	/// Constructor (1d)
+	/// Constructor (1d), see SetStorage() for \e storage
 	Base(const char* name, const char* title, const char* param, const char* gate,
 			 hist::Manager* manager, Int_t event_code,
-			 Int_t nbinsx, Double_t xlow, Double_t xhigh);
+			 Int_t nbinsx, Double_t xlow, Double_t xhigh, Option_t* storage = "D");
 
 	/// Constructor (2d)
 	Base(const char* name, const char* title, const char* param, const char* gate, 
 			 hist::Manager* manager, Int_t event_code,
 			 Int_t nbinsx, Double_t xlow, Double_t xhigh,
-			 Int_t nbinsy, Double_t ylow, Double_t yhigh);
+			 Int_t nbinsy, Double_t ylow, Double_t yhigh, Option_t* storage = "D");
 
 	/// Constructor (3d)
 	Base(const char* name, const char* title, const char* param, const char* gate, 
 			 hist::Manager* manager, Int_t event_code,
 			 Int_t nbinsx, Double_t xlow, Double_t xhigh,
 			 Int_t nbinsy, Double_t ylow, Double_t yhigh,
-			 Int_t nbinsz, Double_t zlow, Double_t zhigh);
+			 Int_t nbinsz, Double_t zlow, Double_t zhigh, Option_t* storage = "D");
 
 public:
 	/// \brief Default constructor.
 	//! \details Does nothing, just here to make rootcint happy.
-	Base() : kEventCode(0), kDimensions(0), fManager(0) {}
+	Base() : kEventCode(0), kDimensions(0), fManager(0), fGeneration(0), fCloneGeneration(0), fCloneLag(0), fNameHash(0), fHistVariant(0), fTarget(0), fLimit(0) {}
 
 public:
 	/// Construct a new histogram from an XML node
@@ -171,6 +300,12 @@ public:
 	/// Returns the event code
 	Int_t GetEventCode() { return kEventCode; }
 
+	/// Change the name, refiling the histogram under it in the manager (see Manager::FindByName())
+	virtual void SetName(const char* name);
+
+	/// Change the name and title, see SetName()
+	virtual void SetNameTitle(const char* name, const char* title);
+
 	/// Returns kUseDefaultTitle
 	Bool_t UseDefaultTitle() { return kUseDefaultTitle; }
 
@@ -198,20 +333,109 @@ public:
 #ifndef __MAKECINT__
 	/// Unlocked version of Fill().
 	Int_t FillUnlocked();
+
+	/// \brief Evaluate the gate only (call with gDataMutex locked).
+	Bool_t EvalGateUnlocked() { return Bool_t(fGate->EvalUnlocked(0)); }
+
+	/// \brief Evaluate the parameters only (call with gDataMutex locked).
+	void EvalParamsUnlocked(std::vector<Double_t>& axes) { fParams->EvalAllUnlocked(axes); }
+
+	/// \brief Evaluate the parameters into \e out, which has room for GetNparams() values (call with gDataMutex locked).
+	void EvalParamsUnlocked(Double_t* out) {
+		for(Int_t i=0; i< fParams->GetN(); ++i) out[i] = fParams->EvalUnlocked(i);
+	}
+
+	/// \brief Number of parameter formulae
+	Int_t GetNparams() { return fParams->GetN(); }
+
+	/// \brief Fill with parameter values evaluated beforehand, without checking the gate.
+	Int_t FillValues(const std::vector<Double_t>& axes) { return DoFill(axes); }
+
+	/// \brief Store parameter values evaluated beforehand in fBatch, without checking the gate.
+	void CollectValues(const std::vector<Double_t>& axes);
+#endif
+
+	/// \brief Evaluate the gate and parameters, storing the values in fBatch instead of filling.
+	void Collect();
+
+	/// \brief Fill the histogram from all values stored in fBatch, then empty it.
+	Int_t FlushBatch();
+
+	/// \brief Discard any values stored in fBatch
+	void ClearBatch();
+
+#ifndef __MAKECINT__
+	/// \brief Append a profile (see rb::TreeFormulae::Profile()) of each parameter and the gate to \e out
+	void ProfileFormulae(std::vector<rb::FormulaProfile>& out, Int_t nloops);
 #endif
 
 	/// \brief Returns a copy of fHistogram.
+	//! \details For sparse histograms too large to copy whole, this is a projection onto the x
+	//! (and y) axes, see Densify().
 	//! \Warning users should \em not delete the returned histogram. Internally, the class
-	//! maintains only a single copy; successive calls to GetHist() delete the copy currently
-	//! in memory and creates a new one.
+	//! maintains only a single copy, which is shared by successive calls to GetHist() until the
+	//! histogram changes (see GetGeneration()); only then is it deleted and a new one made.
+	//! Treat the copy as read-only.
 	TH1* GetHist();
 
+	/// \brief Modification count: GetHist() returns the same copy as long as this doesn't change.
+	ULong64_t GetGeneration() const { return fGeneration; }
+
+	/// \brief Copy the line, fill and marker attributes of the internal histogram, without copying the bins.
+	void GetAttributes(TAttLine& line, TAttFill& fill, TAttMarker& marker) const;
+
 	/// Clear function, zeros-out all axes of the internal histogram
-	virtual void Clear(Option_t* option = "") { visit::hist::Clear::Do(fHistVariant); }
+	virtual void Clear(Option_t* option = "") {
+		++fGeneration;
+		visit::hist::Clear::Do(*fHistVariant);
+		if(fSparse) fSparse->Reset();
+		if(fWindow) ClearWindow();
+	}
+
+	/// \brief Show only the data of the last \e seconds (a sliding window), instead of accumulating.
+	//! \details The window is kept as \e slices time slices: fills go to the current slice at the
+	//! cost of a plain fill, and once per slice the oldest slice is dropped (an O(bins) step,
+	//! amortized over all the fills of a slice). The contents already present become the first
+	//! slice. \e seconds = 0 turns the window off, keeping what's in it. Slices are started by the
+	//! fill thread; while no events come in, GetHist() and Write() still leave out expired slices.
+	//! \returns false if the window can't be used (sparse storage, Scaler, Strip and Rate histograms).
+	Bool_t SetWindow(Double_t seconds, Int_t slices = 10);
+
+	/// \brief Decay the contents exponentially, with a half life of \e halflife seconds.
+	//! \details Like SetWindow(), but older slices are scaled down instead of dropped: the
+	//! contents are halved every \e halflife, in \e steps steps.
+	Bool_t SetDecay(Double_t halflife, Int_t steps = 10);
+
+	/// Window length (or half life) in seconds, 0 if there is no window
+	Double_t GetWindow() const;
+
+	/// Is the window decaying (see SetDecay())?
+	Bool_t IsDecaying() const;
+
+	/// Number of slices of the window (or steps per half life)
+	Int_t GetWindowSlices() const;
 
 	/// Return the number of dimensions.
 	UInt_t GetNdimensions() { return kDimensions; }
 
+	/// \brief Change the bin storage type.
+	//! \details \e storage is one of the ROOT histogram suffixes: "D" (double), "F" (float),
+	//! "I" (32 bit integer), "S" (16 bit integer) or "C" (8 bit integer). Narrower bins use less
+	//! memory and make every fill, clone and write cheaper. Integer and float bins are promoted
+	//! automatically (C to S to I to D, F to D) before a bin's count overflows or loses precision.
+	//! "sparse" storage (see fSparse) can only be chosen at creation and isn't changed here.
+	//! Pointers into the histogram obtained from the TH1 wrappers (axes, functions, ...) are only
+	//! valid until the storage is changed here (automatic promotions keep them, see fVariants).
+	//! \returns false (leaving the storage unchanged) if \e storage isn't valid or the current bin
+	//! contents don't fit in it.
+	Bool_t SetStorage(Option_t* storage);
+
+	/// Return the bin storage code ('D', 'F', 'I', 'S' or 'C')
+	Char_t GetStorage() const;
+
+	/// Are the bins stored sparsely?
+	Bool_t IsSparse() const { return fSparse.get() != 0; }
+
 	/// Return the gate argument
 	virtual std::string GetGate() { return fGate->Get(0); }
 
@@ -244,6 +468,11 @@ public:
 		return ret;		 
 	}
 
+	/// Is overwriting of duplicate names turned on?
+	static Bool_t GetOverwrite() {
+		return fgOverwrite;
+	}
+
 protected:
 	/// Set name and title
 	virtual void Init(const char* name, const char* title, const char* param, const char* gate, Int_t event_code);
@@ -254,6 +483,101 @@ protected:
 	/// Set gate formula
 	virtual void InitGate(const char* gate, Int_t event_code);
 
+#ifndef __MAKECINT__
+	/// \brief Fill the wrapped histogram, promoting its storage if the filled bin is full.
+	//! \returns The bin filled, as TH1::Fill().
+	Int_t FillHist(Double_t x, Double_t y = 0, Double_t z = 0) {
+		++fGeneration;
+		if(fSparse) {
+			const Double_t xyz[3] = { x, y, z };
+			return Int_t(fSparse->Fill(xyz));
+		}
+		Int_t bin;
+		switch(kDimensions) {
+		case 1:  bin = fTarget->Fill(x); break;
+		case 2:  bin = static_cast<TH2*>(fTarget)->Fill(x, y); break;
+		default: bin = static_cast<TH3*>(fTarget)->Fill(x, y, z); break;
+		}
+		if(fLimit != 0 && bin >= 0 && fTarget->GetBinContent(bin) >= fLimit) Promote();
+		return bin;
+	}
+#endif
+
+	/// Promote the storage until it can hold \e content (fractions need floating point bins)
+	void Widen(Double_t content) {
+		const Bool_t fraction = content != TMath::Floor(content);
+		while(fLimit != 0 && (TMath::Abs(content) >= fLimit || (fraction && GetStorage() != 'F'))) Promote();
+	}
+
+	/// Promote the storage before a TH1 wrapper adds \e w to \e bin (see WrapTH1.hxx)
+	void WidenBin(Int_t bin, Double_t w);
+
+	/// Promote the storage before a TH1 wrapper adds up to \e w to bins it can't tell in advance
+	void WidenBins(Double_t w);
+
+	/// Promote to double storage before a TH1 wrapper rewrites the bins (Add(), Scale(), ...)
+	void WidenAll();
+
+	/// Wrapped histogram for the TH1 member function wrappers; non-const access counts as a modification
+	TH1* AsTH1() { ++fGeneration; return fTarget; }
+
+	/// Wrapped histogram for the const TH1 member function wrappers
+	const TH1* AsTH1() const { return fTarget; }
+
+	/// \brief Wrapped histogram for the TH1 wrappers that read or write bin contents.
+	//! \details As AsTH1(), except for sparse histograms: fHistVariant then has the full axes
+	//! but a single bin allocated, so these get SparseStub() instead.
+	TH1* AsBins() { return fSparse ? SparseStub() : AsTH1(); }
+
+	/// Wrapped histogram for the const TH1 wrappers that read bin contents, see AsBins()
+	const TH1* AsBins() const { return fSparse ? SparseStub() : AsTH1(); }
+
+	/// \brief Empty stand-in handed to the bin content wrappers of sparse histograms.
+	//! \details Prints an error (the contents are only available through GetHist()) and returns
+	//! a cleared, single bin histogram of the same dimension, shared by all sparse histograms.
+	TH1* SparseStub() const;
+
+	/// \brief Bring the wrapped histogram up to date before it's copied or written.
+	//! \details Called by GetHist() and Write(); for types that keep their contents elsewhere
+	//! (Strip, Rate) and only lay them out in bins when they're looked at.
+	virtual void Render() { }
+
+	/// \brief Apply changes queued for the fill thread.
+	//! \details Called by the manager on the fill thread, before it rebuilds the fill plan
+	//! (see Family::RegateChannels()).
+	virtual void ApplyPending() { }
+
+	/// Convert to the next wider storage type
+	void Promote();
+
+	/// \brief Convert to storage \e code and update fLimit (no checks)
+	//! \details The converted histogram is a new variant; the old one is kept in fVariants,
+	//! emptied of its bins.
+	void ConvertStorage(Char_t code);
+
+	/// Allocate fSparse with the axes of fHistVariant
+	void InitSparse();
+
+	/// \brief Dense copy of a sparse histogram (owned by the caller)
+	//! \details If all the bins would take too much memory (more than 2^24 cells, 128 MB), the copy
+	//! is a projection of fSparse onto the leading axes that fit (x and y, or x alone) instead.
+	TH1* Densify();
+
+	/// \brief Start a new time slice if the current one has ended at wall clock time \e now
+	//! \details Only called on the fill thread (see Manager::FillAll()).
+	void Rotate(Double_t now);
+
+	/// \brief Contents of the window at wall clock time \e now (owned by the caller).
+	//! \details The window's history plus the current slice, less what Rotate() would drop
+	//! if it ran at \e now; nothing is changed, so it's safe to call from any thread.
+	TH1* Compose(Double_t now);
+
+	/// Set up fWindow (shared by SetWindow() and SetDecay())
+	Bool_t InitWindow(Double_t length, Int_t slices, Bool_t decay);
+
+	/// Empty the window's history
+	void ClearWindow();
+
 private:
 	/// Prevent assigmnent
 	Base& operator= (const Base& other) { return *this; }
@@ -263,6 +587,11 @@ private:
 	//! \details Called from the public Fill() and FillAll(), does not do any mutex locking,
 	//! instead relies on being passed already locked components.
 	virtual Int_t DoFill(const std::vector<Double_t>& params);
+protected:
+	/// \brief Internal function to fill the histogram from fBatch.
+	//! \details Default implementation calls DoFill() once per stored event; derived
+	//! classes with a plain fill can override to fill whole columns at once.
+	virtual Int_t DoFillBatch();
 public:
 #include "WrapTH1.hxx"
 	friend class rb::hist::Manager;
@@ -275,12 +604,16 @@ class D1: public Base
 protected:
 	D1 (const char* name, const char* title, const char* param, const char* gate,
 			hist::Manager* manager, Int_t event_code,
-			Int_t nbinsx, Double_t xlow, Double_t xhigh):
-		Base(name, title, param, gate, manager, event_code, nbinsx, xlow, xhigh)
+			Int_t nbinsx, Double_t xlow, Double_t xhigh, Option_t* storage = "D"):
+		Base(name, title, param, gate, manager, event_code, nbinsx, xlow, xhigh, storage)
 		{ }
 public:
   /// \brief XML constructor output
 	virtual void WriteXML(rb::XmlWriter*);
+protected:
+	/// Fill from parameter columns in one call
+	virtual Int_t DoFillBatch();
+public:
 	friend class rb::hist::Manager;
 	ClassDef(rb::hist::D1, 0);
 };
@@ -291,12 +624,16 @@ protected:
 	D2 (const char* name, const char* title, const char* param, const char* gate,
 			hist::Manager* manager, Int_t event_code,
 			Int_t nbinsx, Double_t xlow, Double_t xhigh,
-			Int_t nbinsy, Double_t ylow, Double_t yhigh):
-		Base(name, title, param, gate, manager, event_code, nbinsx, xlow, xhigh, nbinsy, ylow, yhigh)
+			Int_t nbinsy, Double_t ylow, Double_t yhigh, Option_t* storage = "D"):
+		Base(name, title, param, gate, manager, event_code, nbinsx, xlow, xhigh, nbinsy, ylow, yhigh, storage)
 		{ }
 public:
   /// \brief XML constructor output
 	virtual void WriteXML(rb::XmlWriter*);
+protected:
+	/// Fill from parameter columns in one call
+	virtual Int_t DoFillBatch();
+public:
 	friend class rb::hist::Manager;
 	ClassDef(rb::hist::D2, 0);
 };
@@ -308,14 +645,18 @@ protected:
 			hist::Manager* manager, Int_t event_code,
 			Int_t nbinsx, Double_t xlow, Double_t xhigh,
 			Int_t nbinsy, Double_t ylow, Double_t yhigh,
-			Int_t nbinsz, Double_t zlow, Double_t zhigh):
+			Int_t nbinsz, Double_t zlow, Double_t zhigh, Option_t* storage = "D"):
 		Base(name, title, param, gate, manager, event_code, nbinsx, xlow, xhigh,
-				 nbinsy, ylow, yhigh, nbinsz, zlow, zhigh)
+				 nbinsy, ylow, yhigh, nbinsz, zlow, zhigh, storage)
 		{ }
 
 public:
   /// \brief XML constructor output
 	virtual void WriteXML(rb::XmlWriter*);
+protected:
+	/// Fill from parameter columns in one call
+	virtual Int_t DoFillBatch();
+public:
 	friend class rb::hist::Manager;
 	ClassDef(rb::hist::D3, 0);
 };
@@ -382,6 +723,78 @@ public:
 };
 
 
+/// \brief Family of same-binned histograms, one per channel of a detector array.
+//! \details The channels are held in one contiguous block: internally a 2d (3d) histogram whose
+//! last axis is the channel number, so each channel's 1d (2d) bins are adjacent in memory. The
+//! gate is evaluated once per event for the whole family, and all channels are filled in one pass
+//! from a list of parameters, in the syntax of Summary, e.g. <tt>"ecal[0-29]"</tt> (1d channels) or
+//! <tt>"ecal.t[0-29]:ecal.e[0-29]"</tt> (2d channels, y list first as for 2d histograms).
+//! Channels may also have a gate of their own (see RegateChannels()). Single channels are
+//! available as ordinary histograms through GetChannel(), and are written to file one by one
+//! (sparse families are written whole, as for rb::hist::Base::Write()).
+class Family: public Base
+{
+private:
+	/// Number of channels
+	const Int_t kNchannels;
+	/// Dimensions of each channel (1 or 2)
+	const Int_t kChannelDims;
+	/// Parameter list of each axis (x first)
+	std::vector<std::string> fParamArgs;
+	/// Parameter formula of each channel and axis, all channels of the x axis first
+	std::vector<std::string> fChannelParams;
+	/// Channel gate argument, "" if there is none
+	std::string fChannelGateArg;
+	/// Parameter formulae with new channel gates, waiting to replace fParams (see ApplyPending())
+	boost::scoped_ptr<rb::TreeFormulae> fPendingParams;
+
+public:
+  /// \brief XML constructor output
+	virtual void WriteXML(rb::XmlWriter*);
+	/// Override hist::Base parameter initialization
+	virtual void InitParams(const char* params, Int_t event_code);
+	/// Override hist::Base filling procedure
+	virtual Int_t DoFill(const std::vector<Double_t>& params);
+	/// Return the parameter list of \e axis
+	virtual std::string GetParam(Int_t axis = 0);
+	/// Write each channel as a separate histogram, named <tt>name_channel</tt> (the THnSparse for sparse storage)
+	Int_t Write(const char* name = 0, Int_t option = 0, Int_t bufsize = 0);
+	/// Return the number of channels
+	Int_t GetNchannels() const { return kNchannels; }
+	/// Return the number of dimensions of each channel
+	Int_t GetChannelDimensions() const { return kChannelDims; }
+	/// Return the channel gate argument
+	const char* GetChannelGate() const { return fChannelGateArg.c_str(); }
+	/// \brief Change the per-channel gate.
+	//! \details Each <tt>"%d"</tt> in \e channel_gate is replaced by the channel index (0 to
+	//! GetNchannels()-1), e.g. <tt>"ecal.t[%d] > 0"</tt>; a channel is filled only if the family's
+	//! gate and its own gate both pass. An empty argument removes the channel gates.
+	//! The new gates are used from the next time the fill thread rebuilds its fill plan.
+	//! \returns 0 if successful, -1 if a gate isn't valid (the old ones are kept).
+	Int_t RegateChannels(const char* channel_gate);
+	/// \brief Copy of one channel as a separate histogram (owned by the caller).
+	//! \returns 0 if \e channel is out of range.
+	TH1* GetChannel(Int_t channel);
+
+protected:
+	/// Swap in fPendingParams, on the fill thread
+	virtual void ApplyPending();
+	/// Constructor (1d channels)
+	Family (const char* name, const char* title, const char* param, const char* gate,
+					hist::Manager* manager, Int_t event_code,
+					Int_t nbins, Double_t low, Double_t high, Option_t* storage = "D");
+	/// Constructor (2d channels)
+	Family (const char* name, const char* title, const char* param, const char* gate,
+					hist::Manager* manager, Int_t event_code,
+					Int_t nbinsx, Double_t xlow, Double_t xhigh,
+					Int_t nbinsy, Double_t ylow, Double_t yhigh, Option_t* storage = "D");
+
+public:
+	friend class rb::hist::Manager;
+	ClassDef(rb::hist::Family, 0);
+};
+
+
 /// \brief Gamma histogram
 //! \details Histogram summarizing the values of multiple parameters.
 class Gamma: public Base
@@ -393,18 +806,18 @@ public:
 	/// Constructor (1d)
 	Gamma (const char* name, const char* title, const char* param, const char* gate,
 				 hist::Manager* manager, Int_t event_code,
-				 Int_t nbins, Double_t low, Double_t high);
+				 Int_t nbins, Double_t low, Double_t high, Option_t* storage = "D");
 	/// Constructor (2d)
 	Gamma (const char* name, const char* title, const char* param, const char* gate,
 				 hist::Manager* manager, Int_t event_code,
 				 Int_t nbinsx, Double_t xlow, Double_t xhigh,
-				 Int_t nbinsy, Double_t ylow, Double_t yhigh);
+				 Int_t nbinsy, Double_t ylow, Double_t yhigh, Option_t* storage = "D");
 	/// Constructor (3d)
 	Gamma (const char* name, const char* title, const char* param, const char* gate,
 				 hist::Manager* manager, Int_t event_code,
 				 Int_t nbinsx, Double_t xlow, Double_t xhigh,
 				 Int_t nbinsy, Double_t ylow, Double_t yhigh,
-				 Int_t nbinsz, Double_t zlow, Double_t zhigh);
+				 Int_t nbinsz, Double_t zlow, Double_t zhigh, Option_t* storage = "D");
 	/// Override hist::Base parameter initialization
 	virtual void InitParams(const char* params, Int_t event_code);
 	/// Override hist::Base filling procedure
@@ -460,7 +873,7 @@ protected:
 	virtual void Init(const char* name, const char* title, const char* param, const char* gate, Int_t event_code)
 		{
 			rb::hist::Base::Init(name, title, param, gate, event_code);
-			visit::hist::Cast::Do(fHistVariant)->SetFillColor(30);
+			visit::hist::Cast::Do(*fHistVariant)->SetFillColor(30);
 		}			
 	/// Override filling procedure
 	virtual Int_t DoFill(const std::vector<Double_t>& params);
@@ -473,6 +886,98 @@ public:
 	ClassDef(rb::hist::Scaler, 0);
 };
 
+
+/// \brief Strip chart histogram class.
+//! \details Shows a parameter against time over a fixed window: the last N samples, or the last
+//! T seconds in N slots (each showing the mean of the values in it). The values are kept in a
+//! ring (see rb::hist::Ring), so memory is fixed, each fill is O(1), and the chart never runs out
+//! of bins; the bins are laid out only when the histogram is looked at (see Render()). The x axis
+//! is the age, from -N (or -T) to 0 = now. Time is the wall clock, or an event timestamp
+//! (in seconds) given as a second parameter, <tt>"value:time"</tt>.
+//! \note In batch mode (see rb::hist::SetBatchSize()) wall clock times are taken at the end of each batch.
+class Strip: public Base
+{
+private:
+	/// Values in each slot
+	Ring fRing;
+	/// Window length in seconds, 0 for a window of the last N samples
+	const Double_t kSpan;
+	/// Samples filled so far
+	Long64_t fNumSamples;
+	/// Value of fGeneration when the bins were last laid out
+	ULong64_t fRenderGeneration;
+	/// Slots the wall clock was past the newest slot of fRing when the bins were last laid out
+	Long64_t fRenderLag;
+public:
+  /// \brief XML constructor output
+	virtual void WriteXML(rb::XmlWriter*);
+	/// Override clear, also empties fRing
+	virtual void Clear(Option_t* option = "");
+	/// Return the initial parameter argument (axis 0 only)
+	virtual std::string GetParam(Int_t axis = 0);
+	/// Return the window length in seconds (0 for a window in samples)
+	Double_t GetSpan() const { return kSpan; }
+protected:
+	/// Constructor, window of \e nbins samples (\e seconds = 0) or \e seconds in \e nbins slots
+	Strip (const char* name, const char* title, const char* param, const char* gate,
+				 hist::Manager* manager, Int_t event_code,
+				 Int_t nbins, Double_t seconds = 0, Double_t ignored = 0);
+	/// Override hist::Base parameter initialization, allows "value" or "value:time"
+	virtual void InitParams(const char* param, Int_t event_code);
+	/// Override filling procedure, adds the value to fRing
+	virtual Int_t DoFill(const std::vector<Double_t>& params);
+	/// Lay out fRing in the bins (newest last), without changing fRing
+	virtual void Render();
+
+public:
+	friend class rb::hist::Manager;
+	ClassDef(rb::hist::Strip, 0);
+};
+
+
+/// \brief Rate meter histogram class.
+//! \details Counts the events passing the gate in fixed intervals and shows the rate (counts per
+//! second) of the last N intervals, the x axis being the age in seconds (0 = now; the last bin is
+//! the interval in progress). Like Strip, it uses fixed memory and each fill is O(1). Time is the
+//! wall clock, or an event timestamp in seconds if a parameter is given.
+//! \note In batch mode (see rb::hist::SetBatchSize()) wall clock times are taken at the end of each batch.
+class Rate: public Base
+{
+private:
+	/// Counts in each interval
+	Ring fRing;
+	/// Interval length in seconds
+	const Double_t kInterval;
+	/// Value of fGeneration when the bins were last laid out
+	ULong64_t fRenderGeneration;
+	/// Intervals the wall clock was past the newest interval of fRing when the bins were last laid out
+	Long64_t fRenderLag;
+public:
+  /// \brief XML constructor output
+	virtual void WriteXML(rb::XmlWriter*);
+	/// Override clear, also empties fRing
+	virtual void Clear(Option_t* option = "");
+	/// Return the timestamp parameter (axis 0 only), "" for the wall clock
+	virtual std::string GetParam(Int_t axis = 0);
+	/// Return the interval length in seconds
+	Double_t GetInterval() const { return kInterval; }
+protected:
+	/// Constructor, \e nbins intervals of \e interval seconds
+	Rate (const char* name, const char* title, const char* param, const char* gate,
+				hist::Manager* manager, Int_t event_code,
+				Int_t nbins, Double_t interval = 1, Double_t ignored = 0);
+	/// Override hist::Base parameter initialization, allows an empty parameter (wall clock)
+	virtual void InitParams(const char* param, Int_t event_code);
+	/// Override filling procedure, counts the event in fRing
+	virtual Int_t DoFill(const std::vector<Double_t>& params);
+	/// Lay out fRing in the bins as rates (newest last), without changing fRing
+	virtual void Render();
+
+public:
+	friend class rb::hist::Manager;
+	ClassDef(rb::hist::Rate, 0);
+};
+
 } // namespace hist
 
 } // namespace rb
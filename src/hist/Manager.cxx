@@ -1,7 +1,14 @@
 //! \file Manager.cxx
 //! \brief Implements manager.hxx
+#include <iomanip>
+#include <map>
+#include <cctype>
+#include <algorithm>
+#include <TTimeStamp.h>
 #include "Hist.hxx"
 #include "hist/Manager.hxx"
+#include "Rint.hxx"
+#include "Signals.hxx"
 
 
 
@@ -12,6 +19,31 @@ namespace {
 struct HistFill { Int_t operator() (rb::hist::Base* const& hist) {
 	return hist->Fill();
 } } fill_hist;
+struct HistCollect { void operator() (rb::hist::Base* const& hist) {
+	hist->Collect();
+} } collect_hist;
+struct HistFlush { Int_t operator() (rb::hist::Base* const& hist) {
+	return hist->FlushBatch();
+} } flush_hist;
+// FNV-1a hash of a histogram name
+UInt_t name_hash(const char* name) {
+	UInt_t hash = 2166136261u;
+	for(const char* c = name; *c; ++c) {
+		hash ^= static_cast<unsigned char>(*c);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+bool is_space(char c) {
+	return isspace(static_cast<unsigned char>(c));
+}
+bool slower(const rb::FormulaProfile& lhs, const rb::FormulaProfile& rhs) {
+	return lhs.fNsPerEval > rhs.fNsPerEval;
+}
+bool plan_order(const rb::hist::Manager::FillStep& lhs, const rb::hist::Manager::FillStep& rhs) {
+	if(lhs.fPlain != rhs.fPlain) return lhs.fPlain;
+	return lhs.fDimensions < rhs.fDimensions;
+}
 class HistWrite
 {
 private:
@@ -39,13 +71,168 @@ public:
 // void rb::hist::Manager::FillAll()                     //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 void rb::hist::Manager::FillAll() {
+	/*!
+	 * Walks the flat fill plan: gates and parameters are evaluated under a single lock of
+	 * gDataMutex, one gate per block, a failing gate skipping the whole block, and the parameter
+	 * values are stored contiguously in fValues. After gDataMutex is released the histograms that
+	 * passed are filled (or collected, in batch mode); plain 1d/2d/3d histograms are filled
+	 * directly, without a virtual DoFill() or a visit of their variant.
+	 */
+  LockingPointer<hist::Container_t> pSet(fSet, fSetMutex);
+	if(!fGroupsValid) GroupByGate(*pSet);
+	if(!fWindowed.empty()) { // start new slices of the time windows (see Base::SetWindow())
+		const Double_t now = TTimeStamp().AsDouble();
+		for(std::vector<rb::hist::Base*>::iterator it = fWindowed.begin(); it != fWindowed.end(); ++it) (*it)->Rotate(now);
+	}
+	fPassed.clear();
+	{
+		RB_LOCKGUARD(gDataMutex);
+		for(std::vector<GateBlock>::const_iterator block = fBlocks.begin(); block != fBlocks.end(); ++block) {
+			if(!block->fGate->EvalGateUnlocked()) continue;
+			for(UInt_t i = block->fBegin; i< block->fEnd; ++i) {
+				fPlan[i].fHist->EvalParamsUnlocked(&fValues[fPlan[i].fOffset]);
+				fPassed.push_back(i);
+			}
+		}
+	}
+	if(fBatchSize <= 1) {
+		for(std::vector<UInt_t>::const_iterator it = fPassed.begin(); it != fPassed.end(); ++it) {
+			const FillStep& step = fPlan[*it];
+			const Double_t* v = &fValues[step.fOffset];
+			if(step.fPlain) {
+				switch(step.fDimensions) {
+				case 1:  step.fHist->FillHist(v[0]); break;
+				case 2:  step.fHist->FillHist(v[0], v[1]); break;
+				default: step.fHist->FillHist(v[0], v[1], v[2]); break;
+				}
+			}
+			else {
+				fScratch.assign(v, v + step.fNparams);
+				step.fHist->FillValues(fScratch);
+			}
+		}
+		return;
+	}
+	for(std::vector<UInt_t>::const_iterator it = fPassed.begin(); it != fPassed.end(); ++it) {
+		const FillStep& step = fPlan[*it];
+		fScratch.assign(&fValues[step.fOffset], &fValues[step.fOffset] + step.fNparams);
+		step.fHist->CollectValues(fScratch);
+	}
+	if(++fBatchCount >= fBatchSize) {
+		std::for_each(pSet->begin(), pSet->end(), flush_hist);
+		fBatchCount = 0;
+	}
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::hist::Manager::InvalidateGateGroups()        //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Manager::InvalidateGateGroups() {
   LockingPointer<hist::Container_t> pSet(fSet, fSetMutex);
-  std::for_each(pSet->begin(), pSet->end(), fill_hist);
+	fGroupsValid = false;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::hist::Manager::GroupByGate()                 //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Manager::GroupByGate(const Container_t& set) {
+	/*!
+	 * Gates are matched by their formula text with white space removed. Each gate gets one
+	 * contiguous block of fPlan, with the plain histograms first, ordered by dimension.
+	 * Changes queued for the fill thread (Base::ApplyPending()) are applied first, so the
+	 * parameter counts in the plan are the ones FillAll() will evaluate.
+	 */
+	std::map<std::string, UInt_t> index;
+	std::vector< std::vector<FillStep> > groups;
+	fWindowed.clear();
+	for(Container_t::const_iterator it = set.begin(); it != set.end(); ++it) {
+		(*it)->ApplyPending();
+		if((*it)->GetWindow() != 0) fWindowed.push_back(*it);
+		std::string gate = (*it)->GetGate();
+		gate.erase(std::remove_if(gate.begin(), gate.end(), is_space), gate.end());
+		std::map<std::string, UInt_t>::iterator found = index.find(gate);
+		if(found == index.end()) {
+			found = index.insert(std::make_pair(gate, UInt_t(groups.size()))).first;
+			groups.push_back(std::vector<FillStep>());
+		}
+		FillStep step;
+		step.fHist = *it;
+		step.fDimensions = (*it)->GetNdimensions();
+		step.fPlain = dynamic_cast<D1*>(*it) || dynamic_cast<D2*>(*it) || dynamic_cast<D3*>(*it);
+		step.fOffset = 0;
+		step.fNparams = (*it)->GetNparams();
+		groups[found->second].push_back(step);
+	}
+
+	fPlan.clear();
+	fBlocks.clear();
+	UInt_t nvalues = 0;
+	for(UInt_t g = 0; g< groups.size(); ++g) {
+		std::stable_sort(groups[g].begin(), groups[g].end(), plan_order);
+		GateBlock block;
+		block.fGate = groups[g].front().fHist;
+		block.fBegin = fPlan.size();
+		for(std::vector<FillStep>::iterator it = groups[g].begin(); it != groups[g].end(); ++it) {
+			it->fOffset = nvalues;
+			nvalues += std::max(it->fNparams, it->fDimensions); // plain steps read fDimensions values
+			fPlan.push_back(*it);
+		}
+		block.fEnd = fPlan.size();
+		fBlocks.push_back(block);
+	}
+	fValues.assign(nvalues, 0.);
+	fPassed.reserve(fPlan.size());
+	fGroupsValid = true;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::hist::Manager::FlushBatch()                  //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Manager::FlushBatch() {
+  LockingPointer<hist::Container_t> pSet(fSet, fSetMutex);
+	std::for_each(pSet->begin(), pSet->end(), flush_hist);
+	fBatchCount = 0;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::hist::Manager::PrintFormulaReport()          //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Manager::PrintFormulaReport(std::ostream& strm, Int_t nloops) {
+	/*!
+	 * For every formula not evaluated by the compiled engine, the reasons the faster
+	 * methods were rejected are printed below it.
+	 */
+	std::vector<rb::FormulaProfile> profiles;
+	{
+		LockingPointer<hist::Container_t> pSet(fSet, fSetMutex);
+		for(hist::Container_t::iterator it = pSet->begin(); it != pSet->end(); ++it)
+			(*it)->ProfileFormulae(profiles, nloops);
+	}
+	std::stable_sort(profiles.begin(), profiles.end(), slower);
+
+	Double_t total = 0.;
+	strm << std::setw(10) << "ns/eval" << "  " << std::setw(12) << std::left << "method"
+			 << std::setw(20) << "histogram" << std::setw(9) << "use" << "formula\n" << std::right;
+	for(std::vector<rb::FormulaProfile>::iterator it = profiles.begin(); it != profiles.end(); ++it) {
+		total += it->fNsPerEval;
+		strm << std::setw(10) << std::fixed << std::setprecision(1) << it->fNsPerEval << "  " << std::left
+				 << std::setw(12) << it->fBackend << std::setw(20) << it->fOwner << std::setw(9) << it->fRole
+				 << it->fFormula << "\n" << std::right;
+		if(it->fBackend != "compiled" && !it->fDiagnostics.empty())
+			strm << std::setw(14) << "" << "(" << it->fDiagnostics << ")\n";
+	}
+	strm << profiles.size() << " formulae, " << std::fixed << std::setprecision(1) << total
+			 << " ns per event if none were shared.\n";
+	strm.unsetf(std::ios::floatfield);
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::hist::Manager::SetBatchSize()                //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Manager::SetBatchSize(Int_t n) {
+	FlushBatch();
+	fBatchSize = n;
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // void rb::hist::Manager::WriteAll()                    //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 void rb::hist::Manager::WriteAll(TFile* file) {
+	FlushBatch();
 	HistWrite write_hist(file);
   LockingPointer<hist::Container_t> pSet(fSet, fSetMutex);
   std::for_each(pSet->begin(), pSet->end(), write_hist);
@@ -68,14 +255,21 @@ void rb::hist::Manager::ClearAll() {
   Int_t nhists = pSet->size();
 	if(!nhists) return;
   std::vector<rb::hist::Base*> addresses(pSet->begin(), pSet->end());
-  for(Int_t i=0; i< nhists; ++i) addresses[i]->Clear();
+  for(Int_t i=0; i< nhists; ++i) {
+		addresses[i]->ClearBatch();
+		addresses[i]->Clear();
+	}
+	fBatchCount = 0;
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // void rb::hist::Manager::Add()                         //
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 void rb::hist::Manager::Add(rb::hist::Base* hist) {
   LockingPointer<hist::Container_t> pSet(fSet, fSetMutex);
-  pSet->insert(hist);
+  if(!pSet->insert(hist).second) return;
+	Index(hist);
+	if(fBulkDepth > 0) ++fBulkCount; // published by EndBulk()
+	else fGroupsValid = false;
 }
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 // void rb::hist::Manager::Remove()                      //
@@ -84,6 +278,8 @@ void rb::hist::Manager::Remove(rb::hist::Base* hist) {
   LockingPointer<hist::Container_t> pSet(fSet, fSetMutex);
 	if(pSet->count(hist)) {
 		pSet->erase(hist);
+		Unindex(hist);
+		fGroupsValid = false;
 		TDirectory* directory = hist->fDirectory;
 		if(directory) directory->Remove(hist);
 	}
@@ -102,11 +298,68 @@ rb::hist::Base* rb::hist::Manager::FindByTH1(TH1* hist) {
 //\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
 rb::hist::Base* rb::hist::Manager::FindByName(const char* name, TDirectory* owner) {
 	LockingPointer<hist::Container_t> pSet(fSet, fSetMutex);
-	for(hist::Container_t::iterator it = pSet->begin(); it != pSet->end(); ++it)
-		 if(!strcmp((*it)->GetName(), name)) {
-			 if(!owner || (*it)->GetDirectory() == owner) {
-				 return *it;
-			 }
-		 }
+	const std::vector<rb::hist::Base*>& bucket = fNameIndex[name_hash(name) & (fNameIndex.size() - 1)];
+	for(std::vector<rb::hist::Base*>::const_iterator it = bucket.begin(); it != bucket.end(); ++it)
+		if(!strcmp((*it)->GetName(), name) && (!owner || (*it)->GetDirectory() == owner))
+			return *it;
 	return 0;
 }
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::hist::Manager::Index() [private]             //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Manager::Index(rb::hist::Base* hist) {
+	if(++fNindexed > fNameIndex.size()) { // rehash into twice the buckets
+		std::vector< std::vector<rb::hist::Base*> > index(2 * fNameIndex.size());
+		for(UInt_t b = 0; b< fNameIndex.size(); ++b)
+			for(UInt_t i = 0; i< fNameIndex[b].size(); ++i)
+				index[fNameIndex[b][i]->fNameHash & (index.size() - 1)].push_back(fNameIndex[b][i]);
+		fNameIndex.swap(index);
+	}
+	hist->fNameHash = name_hash(hist->GetName());
+	fNameIndex[hist->fNameHash & (fNameIndex.size() - 1)].push_back(hist);
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::hist::Manager::Unindex() [private]           //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Manager::Unindex(rb::hist::Base* hist) {
+	/*!
+	 * The bucket comes from the hash stored at Index() time, not from the current name, which
+	 * could have been changed behind the manager's back.
+	 */
+	std::vector<rb::hist::Base*>& bucket = fNameIndex[hist->fNameHash & (fNameIndex.size() - 1)];
+	std::vector<rb::hist::Base*>::iterator it = std::find(bucket.begin(), bucket.end(), hist);
+	if(it == bucket.end()) return;
+	bucket.erase(it);
+	--fNindexed;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::hist::Manager::Rename() [private]            //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Manager::Rename(rb::hist::Base* hist, const char* name) {
+	LockingPointer<hist::Container_t> pSet(fSet, fSetMutex);
+	const Bool_t indexed = pSet->count(hist);
+	if(indexed) Unindex(hist);
+	hist->TNamed::SetName(name);
+	if(indexed) Index(hist);
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::hist::Manager::BeginBulk()                   //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Manager::BeginBulk() {
+	LockingPointer<hist::Container_t> pSet(fSet, fSetMutex);
+	if(fBulkDepth++ == 0) fBulkCount = 0;
+}
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+// void rb::hist::Manager::EndBulk()                     //
+//\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\//
+void rb::hist::Manager::EndBulk() {
+	Int_t added = 0;
+	{
+		LockingPointer<hist::Container_t> pSet(fSet, fSetMutex);
+		if(fBulkDepth == 0 || --fBulkDepth > 0) return;
+		added = fBulkCount;
+		fBulkCount = 0;
+		fGroupsValid = false; // FillAll() picks up the whole batch in one rebuild
+	}
+	if(added && Rint::gApp()->GetHistSignals()) Rint::gApp()->GetHistSignals()->NewOrDeleteHist();
+}
@@ -19,27 +19,112 @@ typedef std::set<rb::hist::Base*> Container_t;
 //! \details Also takes care of functions for Adding and Deleting histograms.
 class Manager
 {
+public:
+	//! \brief One histogram in the fill plan
+	struct FillStep {
+		rb::hist::Base* fHist;  ///< The histogram
+		UInt_t fDimensions;     ///< Number of dimensions
+		Bool_t fPlain;          ///< Plain 1d/2d/3d fill (D1, D2, D3), no DoFill() needed
+		UInt_t fOffset;         ///< Offset of the parameter values in fValues
+		UInt_t fNparams;        ///< Number of parameter values
+	};
+	//! \brief Histograms of the fill plan sharing a gate
+	struct GateBlock {
+		rb::hist::Base* fGate;  ///< Histogram whose gate is evaluated for the whole block
+		UInt_t fBegin;          ///< First step in fPlan
+		UInt_t fEnd;            ///< One past the last step in fPlan
+	};
 private:
 	//! Container of pointers to histograms registered to this event type.
 	volatile Container_t fSet;
 
+	//! Number of events to collect before filling (<= 1 means fill every event)
+	Int_t fBatchSize;
+
+	//! Number of events collected since the last batch fill
+	Int_t fBatchCount;
+
+	//! \brief Fill plan: the histograms in fSet as a flat array, grouped by gate formula and,
+	//! within a gate, plain histograms first by number of dimensions.
+	//! \details Rebuilt by FillAll() when !fGroupsValid, i.e. after histograms are added,
+	//! removed or regated.
+	std::vector<FillStep> fPlan;
+
+	//! Gate blocks of fPlan
+	std::vector<GateBlock> fBlocks;
+
+	//! Are fPlan and fBlocks up to date with fSet and the histogram gates?
+	Bool_t fGroupsValid;
+
+	//! Indices (in fPlan) of the histograms passing their gate in the current event (FillAll() scratch space)
+	std::vector<UInt_t> fPassed;
+
+	//! Parameter values of every step in fPlan, at FillStep::fOffset (FillAll() scratch space)
+	std::vector<Double_t> fValues;
+
+	//! Parameter values of one histogram, for the vector interfaces (FillAll() scratch space)
+	std::vector<Double_t> fScratch;
+
+	//! \brief Hash table of the histograms in fSet by name (FNV-1a), one bucket per entry.
+	//! \details The number of buckets is a power of two, doubled whenever it's exceeded by the
+	//! number of histograms, so FindByName() compares only a handful of names.
+	std::vector< std::vector<rb::hist::Base*> > fNameIndex;
+
+	//! Number of histograms in fNameIndex
+	UInt_t fNindexed;
+
+	//! Nesting depth of BeginBulk() calls
+	Int_t fBulkDepth;
+
+	//! Number of histograms added since the outermost BeginBulk()
+	Int_t fBulkCount;
+
+	//! Histograms with a time window (see Base::SetWindow()), rotated by FillAll(); rebuilt with fPlan
+	std::vector<rb::hist::Base*> fWindowed;
+
 	//! Mutex to protect access to fSet
 public:
 	rb::Mutex fSetMutex;
 
 public:
-	//! Fill all histograms in fSet
+	//! \brief Fill all histograms in fSet
+	//! \details Each distinct gate is evaluated once per event, and all histograms
+	//! sharing a gate that fails are skipped together.
 	void FillAll();
+	//! Have FillAll() rebuild the fill plan (call after changing a gate)
+	void InvalidateGateGroups();
 	//! Write all histograms in fSet
 	void WriteAll(TFile* file);
+	//! \brief Set the batch size.
+	//! \details In batch mode FillAll() only evaluates gates and parameters, storing
+	//! the values column-wise in each histogram; the histograms themselves are filled
+	//! every \e n events (or on FlushBatch()) in one pass per histogram.
+	//! \param n Number of events per batch, 0 or 1 turns batch mode off.
+	void SetBatchSize(Int_t n);
+	//! Return fBatchSize
+	Int_t GetBatchSize() const { return fBatchSize; }
+	//! Fill all histograms from the events collected so far (batch mode)
+	void FlushBatch();
+	//! \brief Print how each histogram formula is evaluated and what it costs, slowest first.
+	//! \param nloops Number of evaluations to time each formula over.
+	void PrintFormulaReport(std::ostream& strm, Int_t nloops);
 	//! Does nothing
 	Manager();
 	//! Deletes all entries in fSet
 	~Manager();
 	//! Searches for a histogram by it's fHistogram address
 	Base* FindByTH1(TH1* hist);
-	//! Searches for a histogram by it's name.
+	//! \brief Searches for a histogram by it's name (hashed, see fNameIndex).
+	//! \details If \e owner isn't 0, only histograms in that directory are considered.
 	Base* FindByName(const char* name, TDirectory* owner);
+	//! \brief Start creating histograms in bulk.
+	//! \details Until the matching EndBulk(), created histograms are held back from the fill plan
+	//! (so FillAll() doesn't rebuild it after each one) and no NewOrDeleteHist() signal is sent.
+	void BeginBulk();
+	//! \brief End a bulk creation: publish the new histograms to the fill plan at once and send one signal.
+	void EndBulk();
+	//! Is a bulk creation in progress?
+	Bool_t InBulk() const { return fBulkDepth > 0; }
 	//! Create a new 1d histogram and add to fSet
 	template<typename T>
 	rb::hist::Base* Create(const char* name, const char* title, const char* param, const char* gate, Int_t event_code,
@@ -115,6 +200,14 @@ private:
 	void Add(rb::hist::Base* hist);
 	//! Remove a histogram from fSet
 	void Remove(rb::hist::Base* hist);
+	//! Rebuild fPlan and fBlocks from \e set (fSetMutex must be locked)
+	void GroupByGate(const Container_t& set);
+	//! Add \e hist to fNameIndex, growing it if needed (fSetMutex must be locked)
+	void Index(rb::hist::Base* hist);
+	//! Remove \e hist from fNameIndex, using the hash it was filed under (fSetMutex must be locked)
+	void Unindex(rb::hist::Base* hist);
+	//! Change the name of \e hist, refiling it in fNameIndex
+	void Rename(rb::hist::Base* hist, const char* name);
 	//! Allow access to the created histograms
 	friend class rb::hist::Base;
 };
@@ -123,7 +216,9 @@ private:
 
 
 // ========= Inlined Functions ========= //
-inline rb::hist::Manager::Manager(): fSetMutex("SetMutex", true) {
+inline rb::hist::Manager::Manager(): fBatchSize(0), fBatchCount(0), fGroupsValid(false),
+																		 fNameIndex(64), fNindexed(0), fBulkDepth(0), fBulkCount(0),
+																		 fSetMutex("SetMutex", true) {
 }
 
 inline rb::hist::Manager::~Manager() {
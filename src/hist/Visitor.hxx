@@ -8,6 +8,9 @@
 #include <TH1D.h>
 #include <TH2D.h>
 #include <TH3D.h>
+#include <TH2.h>
+#include <TH3.h>
+#include <TMath.h>
 #include <TTreeFormula.h>
 #include "utils/Mutex.hxx"
 #include "utils/Error.hxx"
@@ -20,7 +23,33 @@
 namespace rb
 {
 /// Histogram (1d, 2d, 3d) variant typedef
-typedef boost::variant<TH1D, TH2D, TH3D> HistVariant;
+//! \details One alternative for each dimension and bin storage type (double, float,
+//! 32, 16 and 8 bit integer); the double precision types come first, so a
+//! default-constructed variant is a TH1D.
+typedef boost::variant<TH1D, TH2D, TH3D,
+											 TH1F, TH2F, TH3F,
+											 TH1I, TH2I, TH3I,
+											 TH1S, TH2S, TH3S,
+											 TH1C, TH2C, TH3C> HistVariant;
+
+/// \brief Maps a number of dimensions and a storage code ('D', 'F', 'I', 'S', 'C') to a histogram type
+template <Int_t N, Char_t C> struct HistType;
+
+/// \brief Number of dimensions, storage code and dimensional base class (TH1, TH2, TH3) of a histogram type
+template <class T> struct HistTraits;
+
+#define RB_HIST_TYPE(TYPE, BASE, N, C)																	\
+	template <> struct HistType<N, C> { typedef TYPE Type; };							\
+	template <> struct HistTraits<TYPE> {																	\
+		enum { kDimensions = N, kStorage = C };															\
+		typedef BASE Base_t;																								\
+	}
+RB_HIST_TYPE(TH1D, TH1, 1, 'D'); RB_HIST_TYPE(TH2D, TH2, 2, 'D'); RB_HIST_TYPE(TH3D, TH3, 3, 'D');
+RB_HIST_TYPE(TH1F, TH1, 1, 'F'); RB_HIST_TYPE(TH2F, TH2, 2, 'F'); RB_HIST_TYPE(TH3F, TH3, 3, 'F');
+RB_HIST_TYPE(TH1I, TH1, 1, 'I'); RB_HIST_TYPE(TH2I, TH2, 2, 'I'); RB_HIST_TYPE(TH3I, TH3, 3, 'I');
+RB_HIST_TYPE(TH1S, TH1, 1, 'S'); RB_HIST_TYPE(TH2S, TH2, 2, 'S'); RB_HIST_TYPE(TH3S, TH3, 3, 'S');
+RB_HIST_TYPE(TH1C, TH1, 1, 'C'); RB_HIST_TYPE(TH2C, TH2, 2, 'C'); RB_HIST_TYPE(TH3C, TH3, 3, 'C');
+#undef RB_HIST_TYPE
 
 /// Encloses visitor classes
 namespace visit
@@ -120,9 +149,9 @@ struct Cast : public boost::static_visitor<TH1*>
 struct Fill : public rb::visit::Locked<Int_t>
 {
 public:
-	 Int_t operator() (TH1D& hst) const { return hst.Fill(x_); }
-	 Int_t operator() (TH2D& hst) const { return hst.Fill(x_,y_); }
-	 Int_t operator() (TH3D& hst) const { return hst.Fill(x_,y_,z_); }
+	 Int_t operator() (TH1& hst) const { return hst.Fill(x_); }
+	 Int_t operator() (TH2& hst) const { return hst.Fill(x_,y_); }
+	 Int_t operator() (TH3& hst) const { return hst.Fill(x_,y_,z_); }
 	 static Int_t Do(HistVariant& hist, Double_t x, Double_t y=0, Double_t z=0) {
 		 return boost::apply_visitor(Fill(x,y,z), hist);
 	 }
@@ -131,13 +160,32 @@ private:
 	 Double_t x_, y_, z_;
 };
 
+/// Performs a Fill() for each entry in columns of values (batch mode)
+struct FillN : public rb::visit::Locked<Int_t>
+{
+public:
+	 Int_t operator() (TH1& hst) const { hst.FillN(n_, x_, 0); return n_; }
+	 Int_t operator() (TH2& hst) const { hst.FillN(n_, x_, y_, 0); return n_; }
+	 Int_t operator() (TH3& hst) const {
+		 for(Int_t i=0; i< n_; ++i) hst.Fill(x_[i], y_[i], z_[i]);
+		 return n_;
+	 }
+	 static Int_t Do(HistVariant& hist, Int_t n, const Double_t* x, const Double_t* y=0, const Double_t* z=0) {
+		 return boost::apply_visitor(FillN(n,x,y,z), hist);
+	 }
+	 FillN(Int_t n, const Double_t* x, const Double_t* y, const Double_t* z): n_(n), x_(x), y_(y), z_(z) {}
+private:
+	 Int_t n_;
+	 const Double_t *x_, *y_, *z_;
+};
+
 /// Sets bin content
 struct SetBinContent : public rb::visit::Locked<void>
 {
 public:
-	void operator() (TH1D& hst) const { return hst.SetBinContent(nbin_, val_); }
-	void operator() (TH2D& hst) const { assert(!"Shouldn't get here!"); }
-	void operator() (TH3D& hst) const { assert(!"Shouldn't get here!"); }
+	void operator() (TH1& hst) const { return hst.SetBinContent(nbin_, val_); }
+	void operator() (TH2& hst) const { assert(!"Shouldn't get here!"); }
+	void operator() (TH3& hst) const { assert(!"Shouldn't get here!"); }
 	static void Do(HistVariant& hist, Int_t nbin, Double_t val) {
 		return boost::apply_visitor(SetBinContent(nbin, val), hist);
 	}
@@ -147,6 +195,66 @@ private:
 	Double_t val_;
 };
 
+/// Returns the storage code ('D', 'F', 'I', 'S' or 'C') of the bins
+struct Storage : public boost::static_visitor<Char_t>
+{
+	template <class T> Char_t operator() (const T& t) const {
+		return HistTraits<T>::kStorage;
+	}
+	static Char_t Do(const HistVariant& hist) {
+		return boost::apply_visitor(Storage(), hist);
+	}
+};
+
+/// Returns the largest absolute bin content, including under- and overflow
+/// \warning Does not perform any mutex locking
+struct MaxContent : public boost::static_visitor<Double_t>
+{
+	template <class T> Double_t operator() (const T& t) const {
+		Double_t out = 0;
+		for(Int_t i = 0; i < t.fN; ++i)
+			if(TMath::Abs(Double_t(t.fArray[i])) > out) out = TMath::Abs(Double_t(t.fArray[i]));
+		return out;
+	}
+	static Double_t Do(const HistVariant& hist) {
+		return boost::apply_visitor(MaxContent(), hist);
+	}
+};
+
+/// \brief Copies the histogram into one of the same dimension with a different bin storage.
+//! \details Axes, attributes, statistics and errors are copied by the dimensional base class
+//! (TH1, TH2 or TH3), the bin contents one by one; the caller makes sure they fit.
+//! \warning Does not perform any mutex locking
+struct Convert : public boost::static_visitor<void>
+{
+	template <class T> void operator() (const T& t) const {
+		const Int_t N = HistTraits<T>::kDimensions;
+		switch(fStorage) {
+		case 'F': Copy<typename HistType<N, 'F'>::Type>(t); break;
+		case 'I': Copy<typename HistType<N, 'I'>::Type>(t); break;
+		case 'S': Copy<typename HistType<N, 'S'>::Type>(t); break;
+		case 'C': Copy<typename HistType<N, 'C'>::Type>(t); break;
+		default:  Copy<typename HistType<N, 'D'>::Type>(t); break;
+		}
+	}
+	/// Returns the converted histogram in \e result
+	static void Do(const HistVariant& hist, Char_t storage, HistVariant& result) {
+		boost::apply_visitor(Convert(storage, result), hist);
+	}
+	Convert(Char_t storage, HistVariant& result): fStorage(storage), fResult(result) {}
+private:
+	template <class U, class T> void Copy(const T& t) const {
+		typedef typename HistTraits<T>::Base_t Base_t;
+		fResult = U();
+		U& u = boost::get<U>(fResult);
+		t.Base_t::Copy(u);
+		u.SetBinsLength(t.fN);
+		for(Int_t i = 0; i < t.fN; ++i) u.fArray[i] = t.fArray[i];
+	}
+	Char_t fStorage;
+	HistVariant& fResult;
+};
+
 } // namespace hist
 } // namespace visit
 } // namespace rb
@@ -155,8 +263,11 @@ private:
 #else // Forward declarations for rootcint
 namespace boost {
 template <class T> class scoped_ptr<T>;
-template <class T1, class T2, class T3> class variant<T1,T2,T3>;
+template <class T1, class T2, class T3, class T4, class T5, class T6, class T7, class T8,
+					class T9, class T10, class T11, class T12, class T13, class T14, class T15>
+class variant<T1,T2,T3,T4,T5,T6,T7,T8,T9,T10,T11,T12,T13,T14,T15>;
 }
-namespace rb { typedef boost::variant<TH1D, TH2D, TH3D> HistVariant; }
+namespace rb { typedef boost::variant<TH1D, TH2D, TH3D, TH1F, TH2F, TH3F, TH1I, TH2I, TH3I,
+																			TH1S, TH2S, TH3S, TH1C, TH2C, TH3C> HistVariant; }
 
 #endif
@@ -2,188 +2,214 @@
 //! \brief Wraps TH1 member functions.
 //! \details This file provides simple wrappers around the majority of TH1 member functions, 
 //! for use in rb::hist::Base derived classes. Each wrapper simply delegates the appropriate 
-//! member function to fHistVariant, casted to TH1* using the Cast or ConstCast visitors in
-//! Visitor.hxx
+//! member function to fHistVariant, through the cached pointer returned by Base::AsTH1() (the
+//! non-const version of which counts as a modification, see Base::GetGeneration())
+//!
+//! Wrappers that read or write bin contents go through Base::AsBins() instead, which refuses
+//! them for sparse histograms: their bins live in Base::fSparse, and fHistVariant only keeps the
+//! axes. Wrappers that only touch axes and attributes use AS_TH1.
+//!
+//! Wrappers that write bin contents first promote narrow storage (see Base::SetStorage()) far
+//! enough for the write, as the fills do: Base::Widen() and Base::WidenBin() for writes to known
+//! bins, Base::WidenBins() for fills whose bins aren't known in advance, and Base::WidenAll()
+//! (double storage) for arithmetic on whole histograms (Add(), Scale(), ...).
 //!
 //! The file was generated using wrap.py, operating on the XML file TH1.xml, which was
 //! produced by running the program gccxml on the root v5.32/01 version of TH1.h
 //! Subsequently, member functions that we did not want transferred to rb::hist::Base
 //! (or which would not compile) were commented out by hand.
-#define AS_TH1 visit::hist::Cast::Do(fHistVariant)
+#define AS_TH1 AsTH1()
+#define AS_BINS AsBins()
 
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Add">*** TH1 Member Function ***</a>
 virtual void Add(TF1* h1, Double_t c1 = 1, Option_t* option = "")
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  /*return*/ AS_TH1->Add(h1, c1, option);
+  WidenAll();
+  /*return*/ AS_BINS->Add(h1, c1, option);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Add">*** TH1 Member Function ***</a>
 virtual void Add(const TH1* h1, Double_t c1 = 1)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  /*return*/ AS_TH1->Add(h1, c1);
+  WidenAll();
+  /*return*/ AS_BINS->Add(h1, c1);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Add">*** TH1 Member Function ***</a>
 virtual void Add(const TH1* h, const TH1* h2, Double_t c1 = 1, Double_t c2 = 1)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  /*return*/ AS_TH1->Add(h, h2, c1, c2);
+  WidenAll();
+  /*return*/ AS_BINS->Add(h, h2, c1, c2);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:AddBinContent">*** TH1 Member Function ***</a>
 virtual void AddBinContent(Int_t bin)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->AddBinContent(bin);
+  WidenBin(bin, 1);
+  return AS_BINS->AddBinContent(bin);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:AddBinContent">*** TH1 Member Function ***</a>
 virtual void AddBinContent(Int_t bin, Double_t w)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->AddBinContent(bin, w);
+  WidenBin(bin, w);
+  return AS_BINS->AddBinContent(bin, w);
 }
 // /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Browse">*** TH1 Member Function ***</a>
 // virtual void Browse(TBrowser* b)
 // {
 //   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-//   return AS_TH1->Browse(b);
+//   return AS_BINS->Browse(b);
 // }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Chi2Test">*** TH1 Member Function ***</a>
 virtual Double_t Chi2Test(const TH1* h2, Option_t* option = "UU", Double_t* res = 0) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Chi2Test(h2, option, res);
+  return AS_BINS->Chi2Test(h2, option, res);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Chi2TestX">*** TH1 Member Function ***</a>
 virtual Double_t Chi2TestX(const TH1* h2, Double_t& chi2, Int_t& ndf, Int_t& igood, Option_t* option = "UU", Double_t* res = 0) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Chi2TestX(h2, chi2, ndf, igood, option, res);
+  return AS_BINS->Chi2TestX(h2, chi2, ndf, igood, option, res);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:ComputeIntegral">*** TH1 Member Function ***</a>
 virtual Double_t ComputeIntegral()
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->ComputeIntegral();
+  return AS_BINS->ComputeIntegral();
 }
 // /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:DirectoryAutoAdd">*** TH1 Member Function ***</a>
 // virtual void DirectoryAutoAdd(TDirectory* arg0)
 // {
 //   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-//   return AS_TH1->DirectoryAutoAdd(arg0);
+//   return AS_BINS->DirectoryAutoAdd(arg0);
 // }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:DistancetoPrimitive">*** TH1 Member Function ***</a>
 virtual Int_t DistancetoPrimitive(Int_t px, Int_t py)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->DistancetoPrimitive(px, py);
+  return AS_BINS->DistancetoPrimitive(px, py);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Divide">*** TH1 Member Function ***</a>
 virtual void Divide(TF1* f1, Double_t c1 = 1)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  /*return*/ AS_TH1->Divide(f1, c1);
+  WidenAll();
+  /*return*/ AS_BINS->Divide(f1, c1);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Divide">*** TH1 Member Function ***</a>
 virtual void Divide(const TH1* h1)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  /*return*/ AS_TH1->Divide(h1);
+  WidenAll();
+  /*return*/ AS_BINS->Divide(h1);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Divide">*** TH1 Member Function ***</a>
 virtual void Divide(const TH1* h1, const TH1* h2, Double_t c1 = 1, Double_t c2 = 1, Option_t* option = "")
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  /*return*/ AS_TH1->Divide(h1, h2, c1, c2, option);
+  WidenAll();
+  /*return*/ AS_BINS->Divide(h1, h2, c1, c2, option);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Draw">*** TH1 Member Function ***</a>
 virtual void Draw(Option_t* option = "")
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Draw(option);
+  return AS_BINS->Draw(option);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:DrawCopy">*** TH1 Member Function ***</a>
 virtual TH1* DrawCopy(Option_t* option = "") const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->DrawCopy(option);
+  return AS_BINS->DrawCopy(option);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:DrawNormalized">*** TH1 Member Function ***</a>
 virtual TH1* DrawNormalized(Option_t* option = "", Double_t norm = 1) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->DrawNormalized(option, norm);
+  return AS_BINS->DrawNormalized(option, norm);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:DrawPanel">*** TH1 Member Function ***</a>
 virtual void DrawPanel()
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->DrawPanel();
+  return AS_BINS->DrawPanel();
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:BufferEmpty">*** TH1 Member Function ***</a>
 virtual Int_t BufferEmpty(Int_t action = 0)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->BufferEmpty(action);
+  return AS_BINS->BufferEmpty(action);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Eval">*** TH1 Member Function ***</a>
 virtual void Eval(TF1* f1, Option_t* option = "")
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Eval(f1, option);
+  return AS_BINS->Eval(f1, option);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:ExecuteEvent">*** TH1 Member Function ***</a>
 virtual void ExecuteEvent(Int_t event, Int_t px, Int_t py)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->ExecuteEvent(event, px, py);
+  return AS_BINS->ExecuteEvent(event, px, py);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:FFT">*** TH1 Member Function ***</a>
 virtual TH1* FFT(TH1* h_output, Option_t* option)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->FFT(h_output, option);
+  return AS_BINS->FFT(h_output, option);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Fill">*** TH1 Member Function ***</a>
 virtual Int_t Fill(Double_t x)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Fill(x);
+  WidenBin(AS_TH1->FindBin(x), 1);
+  return AS_BINS->Fill(x);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Fill">*** TH1 Member Function ***</a>
 virtual Int_t Fill(Double_t x, Double_t w)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Fill(x, w);
+  if(GetNdimensions() == 1) WidenBin(AS_TH1->FindBin(x), w);
+  else WidenBin(AS_TH1->FindBin(x, w), 1); // TH2::Fill(x, y)
+  return AS_BINS->Fill(x, w);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Fill">*** TH1 Member Function ***</a>
 virtual Int_t Fill(const char* name, Double_t w)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Fill(name, w);
+  WidenBins(w);
+  return AS_BINS->Fill(name, w);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:FillN">*** TH1 Member Function ***</a>
 virtual void FillN(Int_t ntimes, const Double_t* x, const Double_t* w, Int_t stride = 1)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->FillN(ntimes, x, w, stride);
+  WidenAll();
+  return AS_BINS->FillN(ntimes, x, w, stride);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:FillN">*** TH1 Member Function ***</a>
 virtual void FillN(Int_t arg0, const Double_t* arg1, const Double_t* arg2, const Double_t* arg3, Int_t arg4)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->FillN(arg0, arg1, arg2, arg3, arg4);
+  WidenAll();
+  return AS_BINS->FillN(arg0, arg1, arg2, arg3, arg4);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:FillRandom">*** TH1 Member Function ***</a>
 virtual void FillRandom(const char* fname, Int_t ntimes = 5000)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->FillRandom(fname, ntimes);
+  WidenBins(ntimes);
+  return AS_BINS->FillRandom(fname, ntimes);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:FillRandom">*** TH1 Member Function ***</a>
 virtual void FillRandom(TH1* h, Int_t ntimes = 5000)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->FillRandom(h, ntimes);
+  WidenBins(ntimes);
+  return AS_BINS->FillRandom(h, ntimes);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:FindBin">*** TH1 Member Function ***</a>
 virtual Int_t FindBin(Double_t x, Double_t y = 0, Double_t z = 0)
@@ -201,13 +227,13 @@ virtual Int_t FindFixBin(Double_t x, Double_t y = 0, Double_t z = 0) const
 virtual Int_t FindFirstBinAbove(Double_t threshold = 0, Int_t axis = 1) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->FindFirstBinAbove(threshold, axis);
+  return AS_BINS->FindFirstBinAbove(threshold, axis);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:FindLastBinAbove">*** TH1 Member Function ***</a>
 virtual Int_t FindLastBinAbove(Double_t threshold = 0, Int_t axis = 1) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->FindLastBinAbove(threshold, axis);
+  return AS_BINS->FindLastBinAbove(threshold, axis);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:FindObject">*** TH1 Member Function ***</a>
 virtual TObject* FindObject(const char* name) const
@@ -225,49 +251,49 @@ virtual TObject* FindObject(const TObject* obj) const
 virtual TFitResultPtr Fit(const char* formula, Option_t* option = "", Option_t* goption = "", Double_t xmin = 0, Double_t xmax = 0)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Fit(formula, option, goption, xmin, xmax);
+  return AS_BINS->Fit(formula, option, goption, xmin, xmax);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Fit">*** TH1 Member Function ***</a>
 virtual TFitResultPtr Fit(TF1* f1, Option_t* option = "", Option_t* goption = "", Double_t xmin = 0, Double_t xmax = 0)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Fit(f1, option, goption, xmin, xmax);
+  return AS_BINS->Fit(f1, option, goption, xmin, xmax);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:FitPanel">*** TH1 Member Function ***</a>
 virtual void FitPanel()
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->FitPanel();
+  return AS_BINS->FitPanel();
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetAsymmetry">*** TH1 Member Function ***</a>
 TH1* GetAsymmetry(TH1* h2, Double_t c2 = 1, Double_t dc2 = 0)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetAsymmetry(h2, c2, dc2);
+  return AS_BINS->GetAsymmetry(h2, c2, dc2);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetBufferLength">*** TH1 Member Function ***</a>
 Int_t GetBufferLength() const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetBufferLength();
+  return AS_BINS->GetBufferLength();
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetBufferSize">*** TH1 Member Function ***</a>
 Int_t GetBufferSize() const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetBufferSize();
+  return AS_BINS->GetBufferSize();
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetBuffer">*** TH1 Member Function ***</a>
 const Double_t* GetBuffer() const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetBuffer();
+  return AS_BINS->GetBuffer();
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetIntegral">*** TH1 Member Function ***</a>
 virtual Double_t* GetIntegral()
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetIntegral();
+  return AS_BINS->GetIntegral();
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetListOfFunctions">*** TH1 Member Function ***</a>
 TList* GetListOfFunctions() const
@@ -351,7 +377,7 @@ virtual Float_t GetBarWidth() const
 virtual Int_t GetContour(Double_t* levels = 0)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetContour(levels);
+  return AS_BINS->GetContour(levels);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetContourLevel">*** TH1 Member Function ***</a>
 virtual Double_t GetContourLevel(Int_t level) const
@@ -363,7 +389,7 @@ virtual Double_t GetContourLevel(Int_t level) const
 virtual Double_t GetContourLevelPad(Int_t level) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetContourLevelPad(level);
+  return AS_BINS->GetContourLevelPad(level);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetBin">*** TH1 Member Function ***</a>
 virtual Int_t GetBin(Int_t binx, Int_t biny = 0, Int_t binz = 0) const
@@ -387,37 +413,37 @@ virtual Double_t GetBinCenter(Int_t bin) const
 virtual Double_t GetBinContent(Int_t bin) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetBinContent(bin);
+  return AS_BINS->GetBinContent(bin);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetBinContent">*** TH1 Member Function ***</a>
 virtual Double_t GetBinContent(Int_t binx, Int_t biny) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetBinContent(binx, biny);
+  return AS_BINS->GetBinContent(binx, biny);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetBinContent">*** TH1 Member Function ***</a>
 virtual Double_t GetBinContent(Int_t binx, Int_t biny, Int_t binz) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetBinContent(binx, biny, binz);
+  return AS_BINS->GetBinContent(binx, biny, binz);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetBinError">*** TH1 Member Function ***</a>
 virtual Double_t GetBinError(Int_t bin) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetBinError(bin);
+  return AS_BINS->GetBinError(bin);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetBinError">*** TH1 Member Function ***</a>
 virtual Double_t GetBinError(Int_t binx, Int_t biny) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetBinError(binx, biny);
+  return AS_BINS->GetBinError(binx, biny);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetBinError">*** TH1 Member Function ***</a>
 virtual Double_t GetBinError(Int_t binx, Int_t biny, Int_t binz) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetBinError(binx, biny, binz);
+  return AS_BINS->GetBinError(binx, biny, binz);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetBinLowEdge">*** TH1 Member Function ***</a>
 virtual Double_t GetBinLowEdge(Int_t bin) const
@@ -435,19 +461,19 @@ virtual Double_t GetBinWidth(Int_t bin) const
 virtual Double_t GetBinWithContent(Double_t c, Int_t& binx, Int_t firstx = 0, Int_t lastx = 0, Double_t maxdiff = 0) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetBinWithContent(c, binx, firstx, lastx, maxdiff);
+  return AS_BINS->GetBinWithContent(c, binx, firstx, lastx, maxdiff);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetCellContent">*** TH1 Member Function ***</a>
 virtual Double_t GetCellContent(Int_t binx, Int_t biny) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetCellContent(binx, biny);
+  return AS_BINS->GetCellContent(binx, biny);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetCellError">*** TH1 Member Function ***</a>
 virtual Double_t GetCellError(Int_t binx, Int_t biny) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetCellError(binx, biny);
+  return AS_BINS->GetCellError(binx, biny);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetCenter">*** TH1 Member Function ***</a>
 virtual void GetCenter(Double_t* center) const
@@ -459,19 +485,19 @@ virtual void GetCenter(Double_t* center) const
 // TDirectory* GetDirectory() const
 // {
 //   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-//   return AS_TH1->GetDirectory();
+//   return AS_BINS->GetDirectory();
 // }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetEntries">*** TH1 Member Function ***</a>
 virtual Double_t GetEntries() const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetEntries();
+  return AS_BINS->GetEntries();
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetEffectiveEntries">*** TH1 Member Function ***</a>
 virtual Double_t GetEffectiveEntries() const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetEffectiveEntries();
+  return AS_BINS->GetEffectiveEntries();
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetFunction">*** TH1 Member Function ***</a>
 virtual TF1* GetFunction(const char* name) const
@@ -489,7 +515,7 @@ virtual Int_t GetDimension() const
 virtual Double_t GetKurtosis(Int_t axis = 1) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetKurtosis(axis);
+  return AS_BINS->GetKurtosis(axis);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetLowEdge">*** TH1 Member Function ***</a>
 virtual void GetLowEdge(Double_t* edge) const
@@ -501,19 +527,19 @@ virtual void GetLowEdge(Double_t* edge) const
 virtual Double_t GetMaximum(Double_t maxval = 3.4028234663852885981170418348451692544e+38f) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetMaximum(maxval);
+  return AS_BINS->GetMaximum(maxval);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetMaximumBin">*** TH1 Member Function ***</a>
 virtual Int_t GetMaximumBin() const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetMaximumBin();
+  return AS_BINS->GetMaximumBin();
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetMaximumBin">*** TH1 Member Function ***</a>
 virtual Int_t GetMaximumBin(Int_t& locmax, Int_t& locmay, Int_t& locmaz) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetMaximumBin(locmax, locmay, locmaz);
+  return AS_BINS->GetMaximumBin(locmax, locmay, locmaz);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetMaximumStored">*** TH1 Member Function ***</a>
 virtual Double_t GetMaximumStored() const
@@ -525,19 +551,19 @@ virtual Double_t GetMaximumStored() const
 virtual Double_t GetMinimum(Double_t minval = -3.4028234663852885981170418348451692544e+38f) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetMinimum(minval);
+  return AS_BINS->GetMinimum(minval);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetMinimumBin">*** TH1 Member Function ***</a>
 virtual Int_t GetMinimumBin() const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetMinimumBin();
+  return AS_BINS->GetMinimumBin();
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetMinimumBin">*** TH1 Member Function ***</a>
 virtual Int_t GetMinimumBin(Int_t& locmix, Int_t& locmiy, Int_t& locmiz) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetMinimumBin(locmix, locmiy, locmiz);
+  return AS_BINS->GetMinimumBin(locmix, locmiy, locmiz);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetMinimumStored">*** TH1 Member Function ***</a>
 virtual Double_t GetMinimumStored() const
@@ -549,13 +575,13 @@ virtual Double_t GetMinimumStored() const
 virtual Double_t GetMean(Int_t axis = 1) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetMean(axis);
+  return AS_BINS->GetMean(axis);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetMeanError">*** TH1 Member Function ***</a>
 virtual Double_t GetMeanError(Int_t axis = 1) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetMeanError(axis);
+  return AS_BINS->GetMeanError(axis);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetNbinsX">*** TH1 Member Function ***</a>
 virtual Int_t GetNbinsX() const
@@ -585,7 +611,7 @@ virtual Double_t GetNormFactor() const
 virtual char* GetObjectInfo(Int_t px, Int_t py) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetObjectInfo(px, py);
+  return AS_BINS->GetObjectInfo(px, py);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetOption">*** TH1 Member Function ***</a>
 virtual Option_t* GetOption() const
@@ -597,67 +623,67 @@ virtual Option_t* GetOption() const
 TVirtualHistPainter* GetPainter(Option_t* option = "")
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetPainter(option);
+  return AS_BINS->GetPainter(option);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetQuantiles">*** TH1 Member Function ***</a>
 virtual Int_t GetQuantiles(Int_t nprobSum, Double_t* q, const Double_t* probSum = 0)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetQuantiles(nprobSum, q, probSum);
+  return AS_BINS->GetQuantiles(nprobSum, q, probSum);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetRandom">*** TH1 Member Function ***</a>
 virtual Double_t GetRandom() const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetRandom();
+  return AS_BINS->GetRandom();
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetStats">*** TH1 Member Function ***</a>
 virtual void GetStats(Double_t* stats) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetStats(stats);
+  return AS_BINS->GetStats(stats);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetSumOfWeights">*** TH1 Member Function ***</a>
 virtual Double_t GetSumOfWeights() const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetSumOfWeights();
+  return AS_BINS->GetSumOfWeights();
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetSumw2">*** TH1 Member Function ***</a>
 virtual TArrayD* GetSumw2()
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetSumw2();
+  return AS_BINS->GetSumw2();
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetSumw2">*** TH1 Member Function ***</a>
 virtual const TArrayD* GetSumw2() const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetSumw2();
+  return AS_BINS->GetSumw2();
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetSumw2N">*** TH1 Member Function ***</a>
 virtual Int_t GetSumw2N() const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetSumw2N();
+  return AS_BINS->GetSumw2N();
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetRMS">*** TH1 Member Function ***</a>
 virtual Double_t GetRMS(Int_t axis = 1) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetRMS(axis);
+  return AS_BINS->GetRMS(axis);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetRMSError">*** TH1 Member Function ***</a>
 virtual Double_t GetRMSError(Int_t axis = 1) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetRMSError(axis);
+  return AS_BINS->GetRMSError(axis);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetSkewness">*** TH1 Member Function ***</a>
 virtual Double_t GetSkewness(Int_t axis = 1) const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->GetSkewness(axis);
+  return AS_BINS->GetSkewness(axis);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:GetXaxis">*** TH1 Member Function ***</a>
 TAxis* GetXaxis() const
@@ -681,37 +707,37 @@ TAxis* GetZaxis() const
 virtual Double_t Integral(Option_t* option = "") const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Integral(option);
+  return AS_BINS->Integral(option);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Integral">*** TH1 Member Function ***</a>
 virtual Double_t Integral(Int_t binx1, Int_t binx2, Option_t* option = "") const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Integral(binx1, binx2, option);
+  return AS_BINS->Integral(binx1, binx2, option);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:IntegralAndError">*** TH1 Member Function ***</a>
 virtual Double_t IntegralAndError(Int_t binx1, Int_t binx2, Double_t& err, Option_t* option = "") const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->IntegralAndError(binx1, binx2, err, option);
+  return AS_BINS->IntegralAndError(binx1, binx2, err, option);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Interpolate">*** TH1 Member Function ***</a>
 virtual Double_t Interpolate(Double_t x)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Interpolate(x);
+  return AS_BINS->Interpolate(x);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Interpolate">*** TH1 Member Function ***</a>
 virtual Double_t Interpolate(Double_t x, Double_t y)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Interpolate(x, y);
+  return AS_BINS->Interpolate(x, y);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Interpolate">*** TH1 Member Function ***</a>
 virtual Double_t Interpolate(Double_t x, Double_t y, Double_t z)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Interpolate(x, y, z);
+  return AS_BINS->Interpolate(x, y, z);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:IsBinOverflow">*** TH1 Member Function ***</a>
 Bool_t IsBinOverflow(Int_t bin) const
@@ -729,55 +755,59 @@ Bool_t IsBinUnderflow(Int_t bin) const
 virtual Double_t KolmogorovTest(const TH1* h2, Option_t* option = "") const
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->KolmogorovTest(h2, option);
+  return AS_BINS->KolmogorovTest(h2, option);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:LabelsDeflate">*** TH1 Member Function ***</a>
 virtual void LabelsDeflate(Option_t* axis = "X")
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->LabelsDeflate(axis);
+  return AS_BINS->LabelsDeflate(axis);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:LabelsInflate">*** TH1 Member Function ***</a>
 virtual void LabelsInflate(Option_t* axis = "X")
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->LabelsInflate(axis);
+  return AS_BINS->LabelsInflate(axis);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:LabelsOption">*** TH1 Member Function ***</a>
 virtual void LabelsOption(Option_t* option = "h", Option_t* axis = "X")
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->LabelsOption(option, axis);
+  return AS_BINS->LabelsOption(option, axis);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Merge">*** TH1 Member Function ***</a>
 virtual Long64_t Merge(TCollection* list)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Merge(list);
+  WidenAll();
+  return AS_BINS->Merge(list);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Multiply">*** TH1 Member Function ***</a>
 virtual void Multiply(TF1* h1, Double_t c1 = 1)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  /*return*/ AS_TH1->Multiply(h1, c1);
+  WidenAll();
+  /*return*/ AS_BINS->Multiply(h1, c1);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Multiply">*** TH1 Member Function ***</a>
 virtual void Multiply(const TH1* h1)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  /*return*/ AS_TH1->Multiply(h1);
+  WidenAll();
+  /*return*/ AS_BINS->Multiply(h1);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Multiply">*** TH1 Member Function ***</a>
 virtual void Multiply(const TH1* h1, const TH1* h2, Double_t c1 = 1, Double_t c2 = 1, Option_t* option = "")
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  /*return*/ AS_TH1->Multiply(h1, h2, c1, c2, option);
+  WidenAll();
+  /*return*/ AS_BINS->Multiply(h1, h2, c1, c2, option);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Paint">*** TH1 Member Function ***</a>
 virtual void Paint(Option_t* option = "")
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Paint(option);
+  return AS_BINS->Paint(option);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Print">*** TH1 Member Function ***</a>
 virtual void Print(Option_t* option = "") const
@@ -789,25 +819,27 @@ virtual void Print(Option_t* option = "") const
 virtual void PutStats(Double_t* stats)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->PutStats(stats);
+  return AS_BINS->PutStats(stats);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Rebin">*** TH1 Member Function ***</a>
 virtual TH1* Rebin(Int_t ngroup = 2, const char* newname = "", const Double_t* xbins = 0)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Rebin(ngroup, newname, xbins);
+  if(!newname || !*newname) WidenAll(); // otherwise rebins a copy
+  return AS_BINS->Rebin(ngroup, newname, xbins);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:RebinAxis">*** TH1 Member Function ***</a>
 virtual void RebinAxis(Double_t x, TAxis* axis)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->RebinAxis(x, axis);
+  WidenAll();
+  return AS_BINS->RebinAxis(x, axis);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Rebuild">*** TH1 Member Function ***</a>
 virtual void Rebuild(Option_t* option = "")
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Rebuild(option);
+  return AS_BINS->Rebuild(option);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:RecursiveRemove">*** TH1 Member Function ***</a>
 virtual void RecursiveRemove(TObject* obj)
@@ -819,25 +851,26 @@ virtual void RecursiveRemove(TObject* obj)
 virtual void Reset(Option_t* option = "")
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Reset(option);
+  return AS_BINS->Reset(option);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:ResetStats">*** TH1 Member Function ***</a>
 virtual void ResetStats()
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->ResetStats();
+  return AS_BINS->ResetStats();
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SavePrimitive">*** TH1 Member Function ***</a>
 virtual void SavePrimitive(ostream& out, Option_t* option = "")
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->SavePrimitive(out, option);
+  return AS_BINS->SavePrimitive(out, option);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Scale">*** TH1 Member Function ***</a>
 virtual void Scale(Double_t c1 = 1, Option_t* option = "")
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Scale(c1, option);
+  WidenAll();
+  return AS_BINS->Scale(c1, option);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetAxisColor">*** TH1 Member Function ***</a>
 virtual void SetAxisColor(Color_t color = 1, Option_t* axis = "X")
@@ -867,109 +900,114 @@ virtual void SetBarWidth(Float_t width = 5.0e-1)
 virtual void SetBinContent(Int_t bin, Double_t content)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->SetBinContent(bin, content);
+  Widen(content);
+  return AS_BINS->SetBinContent(bin, content);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetBinContent">*** TH1 Member Function ***</a>
 virtual void SetBinContent(Int_t binx, Int_t biny, Double_t content)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->SetBinContent(binx, biny, content);
+  Widen(content);
+  return AS_BINS->SetBinContent(binx, biny, content);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetBinContent">*** TH1 Member Function ***</a>
 virtual void SetBinContent(Int_t binx, Int_t biny, Int_t binz, Double_t content)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->SetBinContent(binx, biny, binz, content);
+  Widen(content);
+  return AS_BINS->SetBinContent(binx, biny, binz, content);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetBinError">*** TH1 Member Function ***</a>
 virtual void SetBinError(Int_t bin, Double_t error)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->SetBinError(bin, error);
+  return AS_BINS->SetBinError(bin, error);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetBinError">*** TH1 Member Function ***</a>
 virtual void SetBinError(Int_t binx, Int_t biny, Double_t error)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->SetBinError(binx, biny, error);
+  return AS_BINS->SetBinError(binx, biny, error);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetBinError">*** TH1 Member Function ***</a>
 virtual void SetBinError(Int_t binx, Int_t biny, Int_t binz, Double_t error)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->SetBinError(binx, biny, binz, error);
+  return AS_BINS->SetBinError(binx, biny, binz, error);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetBins">*** TH1 Member Function ***</a>
 virtual void SetBins(Int_t nx, Double_t xmin, Double_t xmax)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->SetBins(nx, xmin, xmax);
+  return AS_BINS->SetBins(nx, xmin, xmax);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetBins">*** TH1 Member Function ***</a>
 virtual void SetBins(Int_t nx, const Double_t* xBins)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->SetBins(nx, xBins);
+  return AS_BINS->SetBins(nx, xBins);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetBins">*** TH1 Member Function ***</a>
 virtual void SetBins(Int_t nx, Double_t xmin, Double_t xmax, Int_t ny, Double_t ymin, Double_t ymax)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->SetBins(nx, xmin, xmax, ny, ymin, ymax);
+  return AS_BINS->SetBins(nx, xmin, xmax, ny, ymin, ymax);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetBins">*** TH1 Member Function ***</a>
 virtual void SetBins(Int_t nx, const Double_t* xBins, Int_t ny, const Double_t* yBins)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->SetBins(nx, xBins, ny, yBins);
+  return AS_BINS->SetBins(nx, xBins, ny, yBins);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetBins">*** TH1 Member Function ***</a>
 virtual void SetBins(Int_t nx, Double_t xmin, Double_t xmax, Int_t ny, Double_t ymin, Double_t ymax, Int_t nz, Double_t zmin, Double_t zmax)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->SetBins(nx, xmin, xmax, ny, ymin, ymax, nz, zmin, zmax);
+  return AS_BINS->SetBins(nx, xmin, xmax, ny, ymin, ymax, nz, zmin, zmax);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetBins">*** TH1 Member Function ***</a>
 virtual void SetBins(Int_t nx, const Double_t* xBins, Int_t ny, const Double_t* yBins, Int_t nz, const Double_t* zBins)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->SetBins(nx, xBins, ny, yBins, nz, zBins);
+  return AS_BINS->SetBins(nx, xBins, ny, yBins, nz, zBins);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetBinsLength">*** TH1 Member Function ***</a>
 virtual void SetBinsLength(Int_t arg0 = -0x00000000000000001)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->SetBinsLength(arg0);
+  return AS_BINS->SetBinsLength(arg0);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetBuffer">*** TH1 Member Function ***</a>
 virtual void SetBuffer(Int_t buffersize, Option_t* option = "")
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->SetBuffer(buffersize, option);
+  return AS_BINS->SetBuffer(buffersize, option);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetCellContent">*** TH1 Member Function ***</a>
 virtual void SetCellContent(Int_t binx, Int_t biny, Double_t content)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->SetCellContent(binx, biny, content);
+  Widen(content);
+  return AS_BINS->SetCellContent(binx, biny, content);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetCellError">*** TH1 Member Function ***</a>
 virtual void SetCellError(Int_t binx, Int_t biny, Double_t content)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->SetCellError(binx, biny, content);
+  return AS_BINS->SetCellError(binx, biny, content);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetContent">*** TH1 Member Function ***</a>
 virtual void SetContent(const Double_t* content)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->SetContent(content);
+  WidenAll();
+  return AS_BINS->SetContent(content);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetContour">*** TH1 Member Function ***</a>
 virtual void SetContour(Int_t nlevels, const Double_t* levels = 0)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->SetContour(nlevels, levels);
+  return AS_BINS->SetContour(nlevels, levels);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetContourLevel">*** TH1 Member Function ***</a>
 virtual void SetContourLevel(Int_t level, Double_t value)
@@ -987,13 +1025,13 @@ virtual void SetDirectory(TDirectory* dir)
 virtual void SetEntries(Double_t n)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->SetEntries(n);
+  return AS_BINS->SetEntries(n);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetError">*** TH1 Member Function ***</a>
 virtual void SetError(const Double_t* error)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->SetError(error);
+  return AS_BINS->SetError(error);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetLabelColor">*** TH1 Member Function ***</a>
 virtual void SetLabelColor(Color_t color = 1, Option_t* axis = "X")
@@ -1035,13 +1073,13 @@ virtual void SetMinimum(Double_t minimum = -0x00000000000000457)
 // virtual void SetName(const char* name)
 // {
 //   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-//   return AS_TH1->SetName(name);
+//   return AS_BINS->SetName(name);
 // }
 // /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetNameTitle">*** TH1 Member Function ***</a>
 // virtual void SetNameTitle(const char* name, const char* title)
 // {
 //   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-//   return AS_TH1->SetNameTitle(name, title);
+//   return AS_BINS->SetNameTitle(name, title);
 // }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:SetNdivisions">*** TH1 Member Function ***</a>
 virtual void SetNdivisions(Int_t n = 510, Option_t* axis = "X")
@@ -1119,55 +1157,56 @@ virtual void SetZTitle(const char* title)
 virtual TH1* ShowBackground(Int_t niter = 20, Option_t* option = "same")
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->ShowBackground(niter, option);
+  return AS_BINS->ShowBackground(niter, option);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:ShowPeaks">*** TH1 Member Function ***</a>
 virtual Int_t ShowPeaks(Double_t sigma = 2, Option_t* option = "", Double_t threshold = 5.000000000000000277555756156289135105907917022705078125e-2)
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->ShowPeaks(sigma, option, threshold);
+  return AS_BINS->ShowPeaks(sigma, option, threshold);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Smooth">*** TH1 Member Function ***</a>
 virtual void Smooth(Int_t ntimes = 1, Option_t* option = "")
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Smooth(ntimes, option);
+  WidenAll();
+  return AS_BINS->Smooth(ntimes, option);
 }
 /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Sumw2">*** TH1 Member Function ***</a>
 virtual void Sumw2()
 {
   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-  return AS_TH1->Sumw2();
+  return AS_BINS->Sumw2();
 }
 // /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:UseCurrentStyle">*** TH1 Member Function ***</a>
 // virtual void UseCurrentStyle()
 // {
 //   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-//   return AS_TH1->UseCurrentStyle();
+//   return AS_BINS->UseCurrentStyle();
 // }
 // /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:IsA">*** TH1 Member Function ***</a>
 // virtual TClass* IsA() const
 // {
 //   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-//   return AS_TH1->IsA();
+//   return AS_BINS->IsA();
 // }
 // /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:ShowMembers">*** TH1 Member Function ***</a>
 // virtual void ShowMembers(TMemberInspector& insp)
 // {
 //   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-//   return AS_TH1->ShowMembers(insp);
+//   return AS_BINS->ShowMembers(insp);
 // }
 // /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:Streamer">*** TH1 Member Function ***</a>
 // virtual void Streamer(TBuffer& b)
 // {
 //   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-//   return AS_TH1->Streamer(b);
+//   return AS_BINS->Streamer(b);
 // }
 // /// <a href = "http://root.cern.ch/root/html/TH1.html#TH1:StreamerNVirtual">*** TH1 Member Function ***</a>
 // void StreamerNVirtual(TBuffer& b)
 // {
 //   rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);
-//   return AS_TH1->StreamerNVirtual(b);
+//   return AS_BINS->StreamerNVirtual(b);
 // }
 
 /// <a href = "http://root.cern.ch/root/html/TAttLine.html#TAttLine:ResetAttLine">*** TAttLine Member Function ***</a>
@@ -1260,3 +1299,4 @@ virtual Option_t* GetDrawOption() const
   return AS_TH1->GetDrawOption();
 }
 #undef AS_TH1
+#undef AS_BINS
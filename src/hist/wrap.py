@@ -1,6 +1,7 @@
 ##@file wrap.py
 ##@brief Generates source files for wrapping TH1 member functions in rb::hist::Base
 
+import re
 import types
 from xml.etree import ElementTree as ET
 
@@ -76,6 +77,23 @@ def get_return(meth) :
     global filename
     return type_map(meth.attrib["returns"])
 
+## Wrappers that only touch axes and attributes; all others read or write bin contents
+## and go through Base::AsBins() (see WrapTH1.hxx)
+axis_methods = re.compile(r"^(Get[XYZ]axis|GetNbins[XYZ]|FindBin|FindFixBin|GetBin|GetBinXYZ|"
+                          r"GetBinCenter|GetBinLowEdge|GetBinWidth|GetCenter|GetLowEdge|"
+                          r"IsBinOverflow|IsBinUnderflow|"
+                          r"(Set|Get)(Line|Fill|Marker|Label|Title|Axis|Bar|Ndivisions|TickLength)\w*|"
+                          r"Set[XYZ]Title|SetTitle|SetOption|GetOption|GetDrawOption|SetStats|"
+                          r"SetMaximum|SetMinimum|GetMaximumStored|GetMinimumStored|SetNormFactor|"
+                          r"GetNormFactor|SetAxisRange|SetDirectory|SetContourLevel|GetContourLevel|"
+                          r"GetDimension|GetListOfFunctions|GetFunction|FindObject|RecursiveRemove|"
+                          r"Print|ResetAtt\w+|Save\w*Attributes)$")
+
+def accessor(method) :
+    if axis_methods.match(get_name(method)) :
+        return "AS_TH1"
+    return "AS_BINS"
+
 def is_public(method) :
     return (method.attrib.get("access") == "public")
 
@@ -160,7 +178,7 @@ def print_method(method) :
             const = 0
     to_print += "\n{\n"
     to_print += "  rb::ScopedLock<rb::Mutex> LOCK (TTHREAD_GLOBAL_MUTEX);\n"
-    to_print += "  return AS_TH1->" + get_name(method) + "("
+    to_print += "  return " + accessor(method) + "->" + get_name(method) + "("
     if (len(args) == 0) :
         to_print += ");\n}"
     elif (len(args) == 1) :
@@ -183,18 +201,29 @@ if __name__ == '__main__' :
     print "//! \\brief Wraps TH1 member functions."
     print "//! \\details This file provides simple wrappers around the majority of TH1 member functions, "
     print "//! for use in rb::hist::Base derived classes. Each wrapper simply delegates the appropriate "
-    print "//! member function to fHistVariant, casted to TH1* using the Cast or ConstCast visitors in"
-    print "//! Visitor.hxx"
+    print "//! member function to fHistVariant, through the cached pointer returned by Base::AsTH1() (the"
+    print "//! non-const version of which counts as a modification, see Base::GetGeneration())"
+    print "//!"
+    print "//! Wrappers that read or write bin contents go through Base::AsBins() instead, which refuses"
+    print "//! them for sparse histograms: their bins live in Base::fSparse, and fHistVariant only keeps the"
+    print "//! axes. Wrappers that only touch axes and attributes use AS_TH1."
+    print "//!"
+    print "//! Wrappers that write bin contents first promote narrow storage (see Base::SetStorage()) far"
+    print "//! enough for the write, as the fills do: Base::Widen() and Base::WidenBin() for writes to known"
+    print "//! bins, Base::WidenBins() for fills whose bins aren't known in advance, and Base::WidenAll()"
+    print "//! (double storage) for arithmetic on whole histograms (Add(), Scale(), ...)."
     print "//!"
     print "//! The file was generated using wrap.py, operating on the XML file TH1.xml, which was"
     print "//! produced by running the program gccxml on the root v5.32/01 version of TH1.h"
     print "//! Subsequently, member functions that we did not want transferred to rb::hist::Base"
     print "//! (or which would not compile) were commented out by hand."
-    print "#define AS_TH1 visit::hist::Cast::Do(fHistVariant)\n"
+    print "#define AS_TH1 AsTH1()"
+    print "#define AS_BINS AsBins()\n"
     for method in methods:
         if(is_public(method) and method.get("file") == "f35"):
             print_method(method)
     print "\n#undef AS_TH1"
+    print "#undef AS_BINS"
 
 
 '''
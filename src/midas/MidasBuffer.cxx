@@ -375,12 +375,14 @@ Int_t rb_run_stop(Int_t runnum, char* err)
 {
 	bm_empty_buffers();
 	rb::MidasBuffer::Instance()->RunStopTransition(runnum);
+	rb::OnlineAttach::RunTransition(runnum, false);
 	return CM_SUCCESS;
 }
 
 Int_t rb_run_start(Int_t runnum, char* err)
 {
 	rb::MidasBuffer::Instance()->RunStartTransition(runnum);
+	rb::OnlineAttach::RunTransition(runnum, true);
 	return CM_SUCCESS;
 }
 
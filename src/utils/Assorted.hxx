@@ -4,6 +4,7 @@
 #define RB_UTILS_ASSORTED_HXX
 #ifndef __MAKECINT__
 #include <string>
+#include <sstream>
 
 #include "TError.h"
 #include "TString.h"
@@ -64,6 +65,17 @@ inline std::string expand_path_std(const TString& static_, const char* dynamic_)
 	return std::string(expand_path(static_, dynamic_).Data());
 }
 
+// Replace each "%d" in format by the channel index (names, parameters, ... of histogram channels)
+inline std::string channel_string(const char* format, Int_t channel) {
+	std::stringstream number;
+	number << channel;
+	std::string out = format ? format : "";
+	for(std::string::size_type pos = out.find("%d"); pos != std::string::npos;
+			pos = out.find("%d", pos + number.str().size()))
+		out.replace(pos, 2, number.str());
+	return out;
+}
+
 //\\\\\\\\ ALPHA-NUMERIC SORTING \\\\\\\\\//
 
 namespace {
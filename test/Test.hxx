@@ -0,0 +1,63 @@
+//! \file Test.hxx
+//! \brief Minimal checking helpers shared by the programs in test/.
+//! \details Each test program is a plain executable linked against libRootbeer: checks print the
+//! failing condition with its file and line, and main() returns Summary(), which is non-zero if any
+//! check failed, so `make test` stops at the first failing program.
+#ifndef RB_TEST_HXX
+#define RB_TEST_HXX
+#include <cmath>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <Rtypes.h>
+
+
+namespace rb
+{
+
+namespace test
+{
+
+/// Number of failed checks so far
+inline Int_t& Failures() { static Int_t failures = 0; return failures; }
+
+/// Record a failed check
+inline void Fail(const char* file, Int_t line, const std::string& what) {
+	std::cerr << file << ":" << line << ": check failed: " << what << "\n";
+	++Failures();
+}
+
+/// Print the result of the program \e name; returns the exit code for main()
+inline Int_t Summary(const char* name) {
+	if(Failures()) std::cerr << name << ": " << Failures() << " check(s) failed\n";
+	else std::cout << name << ": all checks passed\n";
+	return Failures() ? 1 : 0;
+}
+
+/// Record a failure unless \e a and \e b agree to within a relative tolerance of 1e-12
+inline void CheckClose(Double_t a, Double_t b, const char* what, const char* file, Int_t line) {
+	const Double_t scale = std::max(1., std::max(std::fabs(a), std::fabs(b)));
+	if(std::fabs(a - b) <= 1e-12 * scale) return;
+	std::ostringstream message;
+	message << what << " (" << a << " vs. " << b << ")";
+	Fail(file, line, message.str());
+}
+
+} // namespace test
+
+} // namespace rb
+
+
+/// Check that \e COND is true
+#define RB_CHECK(COND) \
+	do { \
+		if(!(COND)) rb::test::Fail(__FILE__, __LINE__, #COND); \
+	} while(0)
+
+/// Check that \e A and \e B agree to within a relative tolerance of 1e-12
+#define RB_CHECK_CLOSE(A, B) \
+	rb::test::CheckClose((A), (B), #A " == " #B, __FILE__, __LINE__)
+
+
+#endif
@@ -0,0 +1,230 @@
+//! \file TestExpression.cxx
+//! \brief Tests the rb::Expression parser and bytecode evaluator, and rb::DerivedVariables.
+#include <cmath>
+#include <ctime>
+#include <string>
+#include <TMath.h>
+#include <TCutG.h>
+#include "Reflect.hxx"
+#include "Expression.hxx"
+#include "PolygonGate.hxx"
+#include "DerivedVariables.hxx"
+#include "Test.hxx"
+
+
+/// Event class read by the test expressions, reflected so no dictionary is needed
+struct Sample
+{
+	Double_t a;
+	Int_t b[4];
+	Short_t c;
+};
+
+RB_REFLECT_BEGIN(Sample)
+  RB_REFLECT_MEMBER(a)
+  RB_REFLECT_MEMBER(b)
+  RB_REFLECT_MEMBER(c)
+RB_REFLECT_END(Sample)
+
+
+namespace {
+//
+// Value of expr on sample, NaN if it doesn't compile
+Double_t eval(const char* expr, Sample& sample, const rb::DerivedVariables* derived = 0) {
+	rb::Expression e(expr, "sample", "Sample", &sample, derived);
+	if(!e.IsValid()) {
+		rb::test::Fail(__FILE__, __LINE__, std::string("couldn't compile \"") + expr + "\": " + e.GetError());
+		return std::sqrt(-1.);
+	}
+	return e.Eval();
+}
+//
+// Does expr fail to compile, with a message?
+Bool_t invalid(const char* expr, Sample& sample) {
+	rb::Expression e(expr, "sample", "Sample", &sample);
+	return !e.IsValid() && std::string(e.GetError()).size() > 0;
+}
+//
+// Constant expressions, folded at compile time
+void test_constants(Sample& s) {
+	RB_CHECK_CLOSE(eval("1+2*3", s), 7);
+	RB_CHECK_CLOSE(eval("(1+2)*3", s), 9);
+	RB_CHECK_CLOSE(eval("2^3", s), 8);
+	RB_CHECK_CLOSE(eval("2**3", s), 8);
+	RB_CHECK_CLOSE(eval("2^3^2", s), 512);
+	RB_CHECK_CLOSE(eval("-2^2", s), -4);
+	RB_CHECK_CLOSE(eval("10-4-3", s), 3);
+	RB_CHECK_CLOSE(eval("12/3/2", s), 2);
+	RB_CHECK_CLOSE(eval("7%3", s), 1);
+	RB_CHECK_CLOSE(eval("1<<4", s), 16);
+	RB_CHECK_CLOSE(eval("256>>4", s), 16);
+	RB_CHECK_CLOSE(eval("6&3", s), 2);
+	RB_CHECK_CLOSE(eval("6|3", s), 7);
+	RB_CHECK_CLOSE(eval("1/0", s), 0);
+	RB_CHECK_CLOSE(eval("pi", s), TMath::Pi());
+	RB_CHECK_CLOSE(eval("sqrt(16)", s), 4);
+	RB_CHECK_CLOSE(eval("TMath::Abs(-3)", s), 3);
+	RB_CHECK_CLOSE(eval("min(2, 5) + max(2, 5)", s), 7);
+	RB_CHECK_CLOSE(eval("atan2(1, 1)", s), TMath::Pi() / 4);
+	RB_CHECK_CLOSE(eval("!0", s), 1);
+	RB_CHECK_CLOSE(eval("!3", s), 0);
+	RB_CHECK_CLOSE(eval("1 < 2 && 2 <= 2 && 3 > 2 && 3 >= 4", s), 0);
+	RB_CHECK_CLOSE(eval("1 == 2 || 1 != 2", s), 1);
+	RB_CHECK_CLOSE(eval("", s), 1);
+	RB_CHECK_CLOSE(eval("  ", s), 1);
+}
+//
+// The same operations on class data, so they run in the bytecode rather than the folder
+void test_variables(Sample& s) {
+	s.a = 2; s.b[0] = 6; s.b[1] = 3; s.b[2] = 7; s.b[3] = 0; s.c = -5;
+	RB_CHECK_CLOSE(eval("a+b[0]*b[1]", s), 20);
+	RB_CHECK_CLOSE(eval("(a+b[0])*b[1]", s), 24);
+	RB_CHECK_CLOSE(eval("a^b[1]", s), 8);
+	RB_CHECK_CLOSE(eval("a**b[1]", s), 8);
+	RB_CHECK_CLOSE(eval("a^b[1]^a", s), 512);
+	RB_CHECK_CLOSE(eval("-a^2", s), -4);
+	RB_CHECK_CLOSE(eval("b[2]%b[1]", s), 1);
+	RB_CHECK_CLOSE(eval("b[1]<<a", s), 12);
+	RB_CHECK_CLOSE(eval("b[0]>>1", s), 3);
+	RB_CHECK_CLOSE(eval("b[0]&b[1]", s), 2);
+	RB_CHECK_CLOSE(eval("b[0]|b[1]", s), 7);
+	RB_CHECK_CLOSE(eval("a/b[3]", s), 0);
+	RB_CHECK_CLOSE(eval("abs(c)", s), 5);
+	RB_CHECK_CLOSE(eval("TMath::Sqrt(a*8)", s), 4);
+	RB_CHECK_CLOSE(eval("pow(a, b[1])", s), 8);
+	RB_CHECK_CLOSE(eval("min(a, c)", s), -5);
+	RB_CHECK_CLOSE(eval("!b[3]", s), 1);
+	RB_CHECK_CLOSE(eval("c < 0 && a == 2", s), 1);
+	RB_CHECK_CLOSE(eval("c > 0 || b[3] != 0", s), 0);
+
+	// the data are read at each call, not at compile time
+	rb::Expression e("a*b[1] + c", "sample", "Sample", &s);
+	RB_CHECK(e.IsValid());
+	RB_CHECK(e.GetNvar() == 3);
+	RB_CHECK_CLOSE(e.Eval(), 1);
+	s.a = 10; s.c = 0;
+	RB_CHECK_CLOSE(e.Eval(), 30);
+
+	// a caller-supplied register file gives the same result
+	std::vector<Double_t> registers(e.GetNregisters());
+	RB_CHECK_CLOSE(e.Eval(&registers[0]), e.Eval());
+}
+//
+// A chain of && terms keeps the result of the plain expression while its terms are re-ordered
+void test_chain(Sample& s) {
+	rb::Expression e("a > 0 && b[0] % 3 == 0 && c < 5", "sample", "Sample", &s);
+	RB_CHECK(e.IsValid());
+	RB_CHECK(e.GetNterms() == 3);
+	rb::Expression f("a > 0 || b[0] % 3 == 0 || c < 5", "sample", "Sample", &s);
+	RB_CHECK(f.GetNterms() == 3);
+	std::vector<Double_t> registers(e.GetNregisters());
+	for(Int_t i=0; i< 4*rb::Expression::kAdaptInterval; ++i) {
+		s.a = (i % 7) - 3;
+		s.b[0] = i;
+		s.c = (i < 2*rb::Expression::kAdaptInterval) ? (i % 11) : (i % 3);
+		const Double_t expected = (s.a > 0 && s.b[0] % 3 == 0 && s.c < 5);
+		RB_CHECK_CLOSE(e.Eval(), expected);
+		RB_CHECK_CLOSE(e.Eval(&registers[0]), expected);
+		RB_CHECK_CLOSE(f.Eval(), (s.a > 0 || s.b[0] % 3 == 0 || s.c < 5));
+	}
+}
+//
+// Arguments out of domain give what TFormula gives, not NaN or infinity
+void test_domain(Sample& s) {
+	RB_CHECK_CLOSE(eval("sqrt(-16)", s), 4);
+	RB_CHECK_CLOSE(eval("log(0)", s), 0);
+	RB_CHECK_CLOSE(eval("log(-1)", s), 0);
+	RB_CHECK_CLOSE(eval("log10(-100)", s), 0);
+	RB_CHECK_CLOSE(eval("exp(800)", s), std::exp(700.));
+	RB_CHECK_CLOSE(eval("exp(-800)", s), 0);
+	RB_CHECK_CLOSE(eval("sign(3, -1)", s), -3);
+	RB_CHECK_CLOSE(eval("sign(-3, 2)", s), 3);
+	RB_CHECK_CLOSE(eval("acos(2)", s), 0);
+	RB_CHECK_CLOSE(eval("asin(-2)", s), TMath::Pi() / 2);
+	RB_CHECK_CLOSE(eval("acosh(0.5)", s), 0);
+	RB_CHECK_CLOSE(eval("atanh(2)", s), 0);
+
+	// the same on class data, evaluated by the bytecode
+	s.a = -16; s.b[0] = 0; s.b[1] = 800; s.c = -1;
+	RB_CHECK_CLOSE(eval("sqrt(a)", s), 4);
+	RB_CHECK_CLOSE(eval("log(b[0])", s), 0);
+	RB_CHECK_CLOSE(eval("log(a)", s), 0);
+	RB_CHECK_CLOSE(eval("log10(a)", s), 0);
+	RB_CHECK_CLOSE(eval("exp(b[1])", s), std::exp(700.));
+	RB_CHECK_CLOSE(eval("exp(-b[1])", s), 0);
+	RB_CHECK_CLOSE(eval("sign(b[1], c)", s), -800);
+	RB_CHECK_CLOSE(eval("sign(a, b[0])", s), 16);
+	RB_CHECK_CLOSE(eval("acos(a)", s), 0);
+	RB_CHECK_CLOSE(eval("atanh(a)", s), 0);
+
+	// TFormula's sign takes two arguments; one is left to TFormula
+	RB_CHECK(invalid("sign(a)", s));
+}
+//
+// Compile errors
+void test_invalid(Sample& s) {
+	RB_CHECK(invalid("a +", s));
+	RB_CHECK(invalid("(a", s));
+	RB_CHECK(invalid("a)", s));
+	RB_CHECK(invalid("nosuchmember * 2", s));
+	RB_CHECK(invalid("[0]*a", s));
+	RB_CHECK(invalid("nosuchfunction(a)", s));
+}
+//
+// Named derived variables
+void test_derived(Sample& s) {
+	s.a = 1.5; s.b[0] = 4; s.c = 2;
+	rb::DerivedVariables derived;
+	RB_CHECK(derived.Define("sum", "a + b[0]", false, "sample", "Sample", &s));
+	RB_CHECK(derived.Define("twice", "2*sum", false, "sample", "Sample", &s));
+	RB_CHECK(derived.Define("big", "sum > 5", true, "sample", "Sample", &s));
+	RB_CHECK(derived.GetNdefinitions() == 3);
+	RB_CHECK(derived.Find("nothing") == 0);
+	derived.Evaluate();
+	RB_CHECK_CLOSE(*derived.Find("sum"), 5.5);
+	RB_CHECK_CLOSE(*derived.Find("twice"), 11);
+	RB_CHECK_CLOSE(*derived.Find("big"), 1);
+	RB_CHECK_CLOSE(eval("twice - c", s, &derived), 9);
+
+	// a cycle is refused, and the old definition stays in place
+	RB_CHECK(!derived.Define("sum", "twice + 1", false, "sample", "Sample", &s));
+	RB_CHECK(!derived.Define("bad name", "a", false, "sample", "Sample", &s));
+	RB_CHECK(!derived.Define("broken", "a +", false, "sample", "Sample", &s));
+	s.b[0] = 0;
+	derived.Evaluate();
+	RB_CHECK_CLOSE(*derived.Find("sum"), 1.5);
+	RB_CHECK_CLOSE(*derived.Find("twice"), 3);
+	RB_CHECK_CLOSE(*derived.Find("big"), 0);
+}
+//
+// Graphical cuts, and their re-synchronization after an edit
+void test_cut(Sample& s) {
+	TCutG* cut = new TCutG("rb_test_box", 4);
+	cut->SetVarX("a");
+	cut->SetVarY("c");
+	cut->SetPoint(0, 0, 0); cut->SetPoint(1, 2, 0); cut->SetPoint(2, 2, 2); cut->SetPoint(3, 0, 2);
+	rb::Expression e("rb_test_box", "sample", "Sample", &s);
+	RB_CHECK(e.IsValid());
+	s.a = 1; s.c = 1;
+	RB_CHECK_CLOSE(e.Eval(), 1);
+	s.a = 3;
+	RB_CHECK_CLOSE(e.Eval(), 0);
+	cut->SetPoint(1, 4, 0); cut->SetPoint(2, 4, 2); // widen the box past a = 3
+	for(std::time_t start = std::time(0); std::time(0) - start < rb::PolygonGate::kSyncPeriod; ) { }
+	RB_CHECK_CLOSE(e.Eval(), 1);
+	delete cut;
+}
+}
+
+
+int main() {
+	Sample sample = { 0, { 0, 0, 0, 0 }, 0 };
+	test_constants(sample);
+	test_variables(sample);
+	test_chain(sample);
+	test_domain(sample);
+	test_invalid(sample);
+	test_derived(sample);
+	test_cut(sample);
+	return rb::test::Summary("TestExpression");
+}
@@ -0,0 +1,104 @@
+//! \file TestRing.cxx
+//! \brief Tests the slot arithmetic of rb::hist::Ring.
+#include "hist/Hist.hxx"
+#include "Test.hxx"
+
+
+namespace {
+//
+// Filling, advancing and reading back a ring of 4 slots
+void test_ring() {
+	rb::hist::Ring ring(4);
+	RB_CHECK(ring.Size() == 4);
+	RB_CHECK(ring.fEmpty);
+	RB_CHECK(ring.Sum(0) == 0 && ring.Count(0) == 0);
+	RB_CHECK(ring.Lag(100) == 0);
+
+	// the first value sets the head wherever it is
+	ring.Add(10, 1.5);
+	ring.Add(10, 2.5);
+	RB_CHECK(!ring.fEmpty);
+	RB_CHECK(ring.fHead == 10);
+	RB_CHECK_CLOSE(ring.Sum(0), 4);
+	RB_CHECK_CLOSE(ring.Count(0), 2);
+
+	// moving on zeroes the slots skipped
+	RB_CHECK(ring.Lag(12) == 2);
+	ring.Add(12, 3);
+	RB_CHECK(ring.fHead == 12);
+	RB_CHECK_CLOSE(ring.Sum(0), 3);
+	RB_CHECK_CLOSE(ring.Sum(1), 0);
+	RB_CHECK_CLOSE(ring.Sum(2), 4);
+	RB_CHECK_CLOSE(ring.Count(2), 2);
+	RB_CHECK_CLOSE(ring.Sum(4), 0);   // older than the ring
+	RB_CHECK(ring.Lag(12) == 0 && ring.Lag(11) == 0);
+
+	// late values still inside the ring are kept, older ones dropped
+	ring.Add(8, 100);                 // 8 <= 12 - 4
+	ring.Add(11, 5);
+	RB_CHECK(ring.fHead == 12);
+	RB_CHECK_CLOSE(ring.Sum(1), 5);
+	RB_CHECK_CLOSE(ring.Sum(0) + ring.Sum(1) + ring.Sum(2) + ring.Sum(3), 12);
+
+	// advancing into the past (or the present) does nothing
+	RB_CHECK(!ring.Advance(12));
+	RB_CHECK(!ring.Advance(3));
+	RB_CHECK(ring.fHead == 12);
+
+	// wrapping around: the slot of 10 is re-used by 14
+	RB_CHECK(ring.Advance(14));
+	RB_CHECK_CLOSE(ring.Sum(0), 0);
+	RB_CHECK_CLOSE(ring.Sum(2), 3);
+	RB_CHECK_CLOSE(ring.Sum(3), 5);
+	RB_CHECK(ring.Index(14) == ring.Index(10));
+
+	// a jump longer than the ring empties it
+	ring.Add(1000, 7);
+	RB_CHECK(ring.fHead == 1000);
+	RB_CHECK_CLOSE(ring.Sum(0), 7);
+	for(Long64_t age = 1; age < ring.Size(); ++age) {
+		RB_CHECK_CLOSE(ring.Sum(age), 0);
+		RB_CHECK_CLOSE(ring.Count(age), 0);
+	}
+
+	// Clear() starts over
+	ring.Clear();
+	RB_CHECK(ring.fEmpty);
+	RB_CHECK(ring.Sum(0) == 0);
+	RB_CHECK(ring.Advance(5));
+	RB_CHECK(ring.fHead == 5);
+}
+//
+// Negative slots and degenerate sizes
+void test_ring_edges() {
+	rb::hist::Ring ring(3);
+	for(Long64_t slot = -7; slot <= 7; ++slot) {
+		RB_CHECK(ring.Index(slot) >= 0 && ring.Index(slot) < 3);
+		RB_CHECK(ring.Index(slot) == ring.Index(slot + 3));
+	}
+	ring.Add(-2, 1);
+	ring.Add(-1, 2);
+	ring.Add(0, 4);
+	RB_CHECK(ring.fHead == 0);
+	RB_CHECK_CLOSE(ring.Sum(0), 4);
+	RB_CHECK_CLOSE(ring.Sum(1), 2);
+	RB_CHECK_CLOSE(ring.Sum(2), 1);
+
+	rb::hist::Ring one(0);            // at least one slot
+	RB_CHECK(one.Size() == 1);
+	one.Add(3, 1);
+	one.Add(3, 1);
+	one.Add(2, 1);                    // dropped
+	RB_CHECK_CLOSE(one.Sum(0), 2);
+	one.Add(4, 1);
+	RB_CHECK_CLOSE(one.Sum(0), 1);
+	RB_CHECK_CLOSE(one.Sum(1), 0);
+}
+}
+
+
+int main() {
+	test_ring();
+	test_ring_edges();
+	return rb::test::Summary("TestRing");
+}
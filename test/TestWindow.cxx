@@ -0,0 +1,38 @@
+//! \file TestWindow.cxx
+//! \brief Tests the rotation schedule of rb::hist::Window.
+#include "hist/Hist.hxx"
+#include "Test.hxx"
+
+
+namespace {
+//
+// Number of slices due at a given time, with slices of 2 seconds and the current one ending at 100
+void test_window() {
+	rb::hist::Window w;
+	w.fLength = 20;
+	w.fNslices = 10;
+	w.fSlice = 2;
+	w.fDecay = 0;
+	w.fNextRotation = 100;
+	w.fOldest = 0;
+	RB_CHECK(w.Due(0) == 0);
+	RB_CHECK(w.Due(99.9) == 0);
+	RB_CHECK(w.Due(100) == 1);
+	RB_CHECK(w.Due(101.9) == 1);
+	RB_CHECK(w.Due(102) == 2);
+	RB_CHECK(w.Due(107) == 4);
+	RB_CHECK(w.Due(100 + 2 * 1e6) == 1000001);
+
+	// after rotating by Due() slices the current slice hasn't ended
+	const Double_t now = 107;
+	w.fNextRotation += w.Due(now) * w.fSlice;
+	RB_CHECK(w.fNextRotation > now && w.fNextRotation - w.fSlice <= now);
+	RB_CHECK(w.Due(now) == 0);
+}
+}
+
+
+int main() {
+	test_window();
+	return rb::test::Summary("TestWindow");
+}